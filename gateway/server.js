@@ -181,6 +181,77 @@ app.post('/api/command', async (req, res) => {
   }
 });
 
+// Change feed: keep one TCP connection open with WATCH and relay pushed events as SSE
+app.get('/api/watch', (req, res) => {
+  const sessionId = req.query.sessionId ? String(req.query.sessionId) : '';
+  if (!sessionId) {
+    return res.status(400).json({ ok: false, error: 'Missing sessionId' });
+  }
+  const since = req.query.since ? String(req.query.since) : '';
+
+  res.setHeader('Content-Type', 'text/event-stream');
+  res.setHeader('Cache-Control', 'no-cache');
+  res.setHeader('Connection', 'keep-alive');
+  res.flushHeaders();
+
+  const socket = new net.Socket();
+  let buffer = Buffer.alloc(0);
+  let acked = false;
+
+  const finish = () => {
+    socket.destroy();
+    res.end();
+  };
+
+  socket.on('error', finish);
+  socket.on('close', finish);
+  req.on('close', () => socket.destroy());
+
+  socket.on('data', (chunk) => {
+    buffer = Buffer.concat([buffer, chunk]);
+    while (buffer.length >= 4) {
+      const len = buffer.readUInt32BE(0);
+      if (buffer.length < 4 + len) break;
+      const body = buffer.slice(4, 4 + len).toString();
+      buffer = buffer.slice(4 + len);
+
+      let payload;
+      try {
+        payload = (JSON.parse(body) || {}).payload || {};
+      } catch (e) {
+        continue;
+      }
+      if (!payload.ok) {
+        const msg = payload.error && payload.error.message ? payload.error.message : 'WATCH failed';
+        res.write(`event: error\ndata: ${JSON.stringify({ error: msg })}\n\n`);
+        return finish();
+      }
+      if (!acked) {
+        // First frame is the subscription ack: {"message":"Watching","seq":N}
+        acked = true;
+        res.write(`event: ready\ndata: ${JSON.stringify(payload.data || {})}\n\n`);
+        continue;
+      }
+      const event = payload.data && payload.data.event;
+      if (event) {
+        res.write(`id: ${event.seq}\ndata: ${JSON.stringify(event)}\n\n`);
+      }
+    }
+  });
+
+  socket.connect(TCP_PORT, TCP_HOST, () => {
+    const envelope = {
+      type: 'CommandRequest',
+      payload: { sessionId, cmd: 'WATCH', args: since ? [since] : [], rawArgs: since },
+    };
+    const body = JSON.stringify(envelope);
+    const len = Buffer.alloc(4);
+    len.writeUInt32BE(Buffer.byteLength(body), 0);
+    socket.write(len);
+    socket.write(body);
+  });
+});
+
 // Simple health endpoint for the web UI
 app.post('/api/health', (_req, res) => {
   res.json({ ok: true });
@@ -0,0 +1,599 @@
+// osproj_bench：BlockCache / Vfs / 协议层热点路径的微基准。
+//
+// 用法：osproj_bench [--filter 子串] [--warmup N] [--reps N] [--batch N]
+//                    [--json] [--out 文件] [--baseline 文件] [--max-regression 百分比]
+//
+// - 每个基准先预热 warmup 批，再执行 reps 批，每批 batch 次操作；
+//   以“每批的 ns/op”为样本统计中位数与 p90/p99，分配次数按全部批次平均。
+// - --json 输出机器可读结果（同时可用 --out 写入文件），可作为下一次运行的 --baseline；
+//   指定 --baseline 时，任一基准中位数比基线慢超过 max-regression%（默认 10）则以退出码 1 结束，
+//   便于在 CI 中拦截性能回退。
+// - Vfs 基准在临时目录下创建独立的 data.fs 镜像，结束后删除，不会触碰工作目录中的 data.fs。
+
+#include "common/protocol.hpp"
+#include "server/filesystem/block_cache.hpp"
+#include "server/filesystem/vfs.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+// ------------ 分配计数：替换全局 operator new/delete ------------
+// 全部变体（普通 / 数组 / sized / nothrow / 对齐）都经由同一对计数分配函数，new 与 delete 始终成对匹配。
+// 两个函数不内联：否则编译器会看到 operator new 返回的指针被直接交给 free，报 -Wmismatched-new-delete
+
+namespace
+{
+std::atomic<std::uint64_t> gAllocCount{0};
+
+[[gnu::noinline]] void* countedAlloc(std::size_t size, std::size_t align) noexcept
+{
+    gAllocCount.fetch_add(1, std::memory_order_relaxed);
+    size = size == 0 ? 1 : size;
+    if (align <= alignof(std::max_align_t))
+    {
+        return std::malloc(size);
+    }
+    // aligned_alloc 要求 size 是 align 的整数倍
+    return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+[[gnu::noinline]] void countedFree(void* p) noexcept
+{
+    std::free(p);
+}
+
+void* countedAllocOrThrow(std::size_t size, std::size_t align)
+{
+    if (void* p = countedAlloc(size, align))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    return countedAllocOrThrow(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size)
+{
+    return countedAllocOrThrow(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t align)
+{
+    return countedAllocOrThrow(size, static_cast<std::size_t>(align));
+}
+
+void* operator new[](std::size_t size, std::align_val_t align)
+{
+    return countedAllocOrThrow(size, static_cast<std::size_t>(align));
+}
+
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(size, static_cast<std::size_t>(align));
+}
+
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(size, static_cast<std::size_t>(align));
+}
+
+void operator delete(void* p) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    countedFree(p);
+}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    countedFree(p);
+}
+
+namespace
+{
+
+using json = osp::protocol::json;
+
+struct Options
+{
+    std::string filter;
+    std::size_t warmup{3};
+    std::size_t reps{30};
+    std::size_t batch{2000};
+    bool        jsonOutput{false};
+    std::string outPath;
+    std::string baselinePath;
+    double      maxRegressionPct{10.0};
+};
+
+struct Result
+{
+    std::string name;
+    double      nsPerOp{0};     // 各批 ns/op 的中位数
+    double      p90{0};
+    double      p99{0};
+    double      minNs{0};
+    double      allocsPerOp{0};
+    std::size_t ops{0};
+};
+
+double percentile(std::vector<double> sorted, double p)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+    const auto idx = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+// 防止编译器把基准中的结果优化掉
+template <typename T>
+void doNotOptimize(const T& value)
+{
+    __asm__ __volatile__("" : : "m"(value) : "memory");
+}
+
+class Runner
+{
+public:
+    explicit Runner(const Options& opt)
+        : opt_(opt)
+    {
+    }
+
+    // op(i) 执行一次被测操作，i 为批内序号
+    template <typename Op>
+    void run(const std::string& name, Op&& op)
+    {
+        if (!opt_.filter.empty() && name.find(opt_.filter) == std::string::npos)
+        {
+            return;
+        }
+
+        using clock = std::chrono::steady_clock;
+
+        for (std::size_t w = 0; w < opt_.warmup; ++w)
+        {
+            for (std::size_t i = 0; i < opt_.batch; ++i)
+            {
+                op(i);
+            }
+        }
+
+        std::vector<double> samples;
+        samples.reserve(opt_.reps);
+        std::uint64_t allocs = 0;
+        for (std::size_t r = 0; r < opt_.reps; ++r)
+        {
+            const std::uint64_t allocBefore = gAllocCount.load(std::memory_order_relaxed);
+            const auto          start = clock::now();
+            for (std::size_t i = 0; i < opt_.batch; ++i)
+            {
+                op(i);
+            }
+            const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+            allocs += gAllocCount.load(std::memory_order_relaxed) - allocBefore;
+            samples.push_back(static_cast<double>(elapsed.count()) / static_cast<double>(opt_.batch));
+        }
+        std::sort(samples.begin(), samples.end());
+
+        Result res;
+        res.name = name;
+        res.nsPerOp = percentile(samples, 0.5);
+        res.p90 = percentile(samples, 0.9);
+        res.p99 = percentile(samples, 0.99);
+        res.minNs = samples.front();
+        res.ops = opt_.reps * opt_.batch;
+        res.allocsPerOp = static_cast<double>(allocs) / static_cast<double>(res.ops);
+        results_.push_back(res);
+
+        if (!opt_.jsonOutput)
+        {
+            std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(12) << res.nsPerOp << std::setw(12) << res.p90 << std::setw(12) << res.p99
+                      << std::setw(12) << res.minNs << std::setprecision(2) << std::setw(12) << res.allocsPerOp
+                      << '\n';
+        }
+    }
+
+    [[nodiscard]] const std::vector<Result>& results() const noexcept { return results_; }
+
+private:
+    const Options&      opt_;
+    std::vector<Result> results_;
+};
+
+// ------------ 基准 ------------
+
+void benchBlockCache(Runner& runner)
+{
+    constexpr std::size_t kCapacity = 64;
+    constexpr std::size_t kCapacityBytes = kCapacity * osp::fs::BlockCache::entryCost(4096);
+    const std::vector<std::byte> block(4096, std::byte{0x5a});
+
+    {
+        osp::fs::BlockCache cache(kCapacityBytes);
+        for (std::size_t id = 0; id < kCapacity; ++id)
+        {
+            cache.put(id, block);
+        }
+        runner.run("cache.get_hit", [&](std::size_t i) {
+            bool hit = false;
+            auto data = cache.get(i % kCapacity, hit);
+            doNotOptimize(data.data());
+        });
+    }
+
+    {
+        osp::fs::BlockCache cache(kCapacityBytes);
+        runner.run("cache.get_miss", [&](std::size_t i) {
+            bool hit = false;
+            auto data = cache.get(i, hit);
+            doNotOptimize(data.data());
+        });
+    }
+
+    {
+        osp::fs::BlockCache cache(kCapacityBytes);
+        std::size_t         next = 0;
+        runner.run("cache.put_evict", [&](std::size_t) { cache.put(next++, block); });
+    }
+}
+
+void benchVfs(Runner& runner, const std::filesystem::path& image)
+{
+    osp::fs::Vfs vfs(64 * osp::fs::BlockCache::entryCost(4096));
+    if (!vfs.mount(image.string()))
+    {
+        std::cerr << "osproj_bench: cannot mount " << image << '\n';
+        return;
+    }
+
+    // 目录树：/bench/a/b/c，若干小文件（内联）与多块文件
+    vfs.createDirectory("/bench");
+    vfs.createDirectory("/bench/a");
+    vfs.createDirectory("/bench/a/b");
+    vfs.createDirectory("/bench/a/b/c");
+    vfs.writeFile("/bench/a/b/c/leaf.txt", "leaf");
+    vfs.writeFile("/bench/small.txt", std::string(64, 's'));
+    const std::string big(16 * 1024, 'b');
+    vfs.writeFile("/bench/big.txt", big);
+
+    // resolvePath：经由 stat() 只解析路径 + 读取目标 inode
+    runner.run("vfs.stat_depth5", [&](std::size_t) {
+        auto st = vfs.stat("/bench/a/b/c/leaf.txt");
+        doNotOptimize(st);
+    });
+
+    runner.run("vfs.read_inline_64B", [&](std::size_t) {
+        auto data = vfs.readFile("/bench/small.txt");
+        doNotOptimize(data);
+    });
+
+    runner.run("vfs.read_16KiB", [&](std::size_t) {
+        auto data = vfs.readFile("/bench/big.txt");
+        doNotOptimize(data);
+    });
+
+    runner.run("vfs.read_range_1KiB", [&](std::size_t i) {
+        auto data = vfs.readFileRange("/bench/big.txt", (i * 1024) % big.size(), 1024);
+        doNotOptimize(data);
+    });
+
+    // writeFile 覆盖写：释放旧块后重新 allocDataBlock，每块一次 flush
+    runner.run("vfs.write_16KiB", [&](std::size_t) { vfs.writeFile("/bench/big.txt", big); });
+
+    // 创建 + 删除：覆盖 findFreeInode / allocDataBlock / freeDataBlock / 目录项改写
+    const std::string eightK(8 * 1024, 'c');
+    runner.run("vfs.create_remove_8KiB", [&](std::size_t) {
+        vfs.writeFile("/bench/tmp.txt", eightK);
+        vfs.removeFile("/bench/tmp.txt");
+    });
+
+    // 同样的操作放在一个事务中：只 flush 一次
+    osp::TimedMutex txMutex;
+    runner.run("vfs.tx_create_remove_8KiB", [&](std::size_t) {
+        osp::fs::Vfs::Transaction tx(vfs, txMutex);
+        tx->writeFile("/bench/tmp.txt", eightK);
+        tx->removeFile("/bench/tmp.txt");
+        tx.commit();
+    });
+}
+
+void benchProtocol(Runner& runner)
+{
+    // 典型的 LIST_PAPERS 响应：20 篇论文
+    json papers = json::array();
+    for (int i = 1; i <= 20; ++i)
+    {
+        papers.push_back({{"id", i}, {"title", "Paper title number " + std::to_string(i)}, {"status", "UnderReview"}, {"authorId", 2}});
+    }
+    const osp::protocol::Message response = osp::protocol::makeSuccessResponse({{"papers", papers}});
+    const std::string            wire = osp::protocol::serialize(response);
+
+    runner.run("protocol.serialize", [&](std::size_t) {
+        auto s = osp::protocol::serialize(response);
+        doNotOptimize(s);
+    });
+
+    runner.run("protocol.deserialize", [&](std::size_t) {
+        auto m = osp::protocol::deserialize(wire);
+        doNotOptimize(m);
+    });
+
+    runner.run("protocol.parse_command_line", [&](std::size_t) {
+        auto cmd = osp::protocol::parseCommandLine("REVIEW 12 ACCEPT well written and clearly argued");
+        doNotOptimize(cmd);
+    });
+}
+
+// ------------ 结果输出与基线比较 ------------
+
+json toJson(const std::vector<Result>& results, const Options& opt)
+{
+    json arr = json::array();
+    for (const auto& r : results)
+    {
+        arr.push_back({
+            {"name", r.name},
+            {"nsPerOp", r.nsPerOp},
+            {"p90", r.p90},
+            {"p99", r.p99},
+            {"min", r.minNs},
+            {"allocsPerOp", r.allocsPerOp},
+            {"ops", r.ops}
+        });
+    }
+    return {
+        {"warmup", opt.warmup},
+        {"reps", opt.reps},
+        {"batch", opt.batch},
+        {"results", arr}
+    };
+}
+
+// 返回回退的基准个数
+int compareWithBaseline(const std::vector<Result>& results, const Options& opt)
+{
+    std::ifstream in(opt.baselinePath);
+    if (!in)
+    {
+        std::cerr << "osproj_bench: cannot open baseline " << opt.baselinePath << '\n';
+        return 1;
+    }
+
+    json baseline;
+    try
+    {
+        in >> baseline;
+    }
+    catch (const json::exception& e)
+    {
+        std::cerr << "osproj_bench: bad baseline: " << e.what() << '\n';
+        return 1;
+    }
+
+    int regressions = 0;
+    for (const auto& r : results)
+    {
+        for (const auto& b : baseline.value("results", json::array()))
+        {
+            if (b.value("name", "") != r.name)
+            {
+                continue;
+            }
+            const double base = b.value("nsPerOp", 0.0);
+            if (base <= 0)
+            {
+                break;
+            }
+            const double deltaPct = (r.nsPerOp - base) / base * 100.0;
+            if (deltaPct > opt.maxRegressionPct)
+            {
+                ++regressions;
+                std::cerr << "REGRESSION " << r.name << ": " << std::fixed << std::setprecision(1) << base
+                          << " -> " << r.nsPerOp << " ns/op (+" << deltaPct << "%)\n";
+            }
+            break;
+        }
+    }
+    return regressions;
+}
+
+bool parseOptions(int argc, char** argv, Options& opt)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+        try
+        {
+            if (arg == "--filter")
+            {
+                const char* v = next();
+                if (!v) return false;
+                opt.filter = v;
+            }
+            else if (arg == "--warmup")
+            {
+                const char* v = next();
+                if (!v) return false;
+                opt.warmup = std::stoul(v);
+            }
+            else if (arg == "--reps")
+            {
+                const char* v = next();
+                if (!v) return false;
+                opt.reps = std::max<std::size_t>(1, std::stoul(v));
+            }
+            else if (arg == "--batch")
+            {
+                const char* v = next();
+                if (!v) return false;
+                opt.batch = std::max<std::size_t>(1, std::stoul(v));
+            }
+            else if (arg == "--json")
+            {
+                opt.jsonOutput = true;
+            }
+            else if (arg == "--out")
+            {
+                const char* v = next();
+                if (!v) return false;
+                opt.outPath = v;
+            }
+            else if (arg == "--baseline")
+            {
+                const char* v = next();
+                if (!v) return false;
+                opt.baselinePath = v;
+            }
+            else if (arg == "--max-regression")
+            {
+                const char* v = next();
+                if (!v) return false;
+                opt.maxRegressionPct = std::stod(v);
+            }
+            else
+            {
+                return false;
+            }
+        }
+        catch (...)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if (!parseOptions(argc, argv, opt))
+    {
+        std::cerr << "Usage: osproj_bench [--filter substr] [--warmup N] [--reps N] [--batch N]\n"
+                     "                    [--json] [--out file] [--baseline file] [--max-regression pct]\n";
+        return 2;
+    }
+
+    // 基准运行期间关闭 std::clog 日志输出，避免终端 I/O 淹没被测路径
+    std::streambuf* savedClog = std::clog.rdbuf(nullptr);
+
+    namespace fs = std::filesystem;
+    const fs::path image = fs::temp_directory_path() / ("osproj_bench_" + std::to_string(::getpid()) + ".fs");
+
+    if (!opt.jsonOutput)
+    {
+        std::cout << std::left << std::setw(28) << "benchmark" << std::right << std::setw(12) << "ns/op"
+                  << std::setw(12) << "p90" << std::setw(12) << "p99" << std::setw(12) << "min" << std::setw(12)
+                  << "allocs/op" << '\n';
+    }
+
+    Runner runner(opt);
+    benchBlockCache(runner);
+    benchVfs(runner, image);
+    benchProtocol(runner);
+
+    std::error_code ec;
+    fs::remove(image, ec);
+    std::clog.rdbuf(savedClog);
+
+    const json report = toJson(runner.results(), opt);
+    if (opt.jsonOutput)
+    {
+        std::cout << report.dump(2) << '\n';
+    }
+    if (!opt.outPath.empty())
+    {
+        std::ofstream out(opt.outPath);
+        out << report.dump(2) << '\n';
+    }
+
+    if (!opt.baselinePath.empty())
+    {
+        const int regressions = compareWithBaseline(runner.results(), opt);
+        return regressions == 0 ? 0 : 1;
+    }
+    return 0;
+}
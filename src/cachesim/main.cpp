@@ -0,0 +1,575 @@
+// osproj_cachesim：离线回放 Vfs 录制的块访问追踪，比较不同替换策略、不同容量下的缓存缺失率。
+//
+// 用法：osproj_cachesim <trace 文件> [--capacities 16,32,...] [--policies lru,fifo,clock,arc]
+//                       [--sample-rate R] [--json]
+//
+// - 追踪由服务器录制：OSP_BLOCK_TRACE=<file> 启动，或管理员执行 BLOCK_TRACE START <file> / BLOCK_TRACE STOP；
+// - 只有读访问计入命中/缺失，写访问与 Vfs 一样把块放入缓存（不算缺失）；
+// - LRU 用栈距离（Mattson）一次回放得到所有容量的结果，其余策略按容量逐个模拟；
+// - --sample-rate < 1 时按 SHARDS 的空间采样：只回放块号哈希落在采样区间内的访问，容量按同样比例缩小，
+//   追踪很长时可以用很小的代价得到近似的缺失率曲线；
+// - 输出末尾给出建议容量：LRU 缺失率与所测最大容量相差不超过 1 个百分点的最小容量。
+//   注意服务器的 cacheCapacity 上限为 4096（clampCacheCapacity）。
+
+#include "common/protocol.hpp"
+#include "server/filesystem/block_trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+
+using osp::protocol::json;
+
+struct Options
+{
+    std::string              tracePath;
+    std::vector<std::size_t> capacities{16, 32, 64, 128, 256, 512, 1024, 2048, 4096};
+    std::vector<std::string> policies{"lru", "fifo", "clock", "arc"};
+    double                   sampleRate{1.0};
+    bool                     jsonOutput{false};
+};
+
+struct Access
+{
+    std::uint32_t block;
+    bool          write;
+};
+
+// ------------ 替换策略（只关心命中与否，不保存块内容） ------------
+
+class Policy
+{
+public:
+    virtual ~Policy() = default;
+    // 返回是否命中；未命中时插入。write 为 true 时调用方不统计结果
+    virtual bool access(std::uint32_t block) = 0;
+};
+
+class FifoPolicy : public Policy
+{
+public:
+    explicit FifoPolicy(std::size_t capacity)
+        : capacity_(capacity)
+    {
+    }
+
+    bool access(std::uint32_t block) override
+    {
+        if (resident_.count(block) != 0)
+        {
+            return true;
+        }
+        if (queue_.size() >= capacity_)
+        {
+            resident_.erase(queue_.front());
+            queue_.pop_front();
+        }
+        queue_.push_back(block);
+        resident_.insert(block);
+        return false;
+    }
+
+private:
+    std::size_t                       capacity_;
+    std::list<std::uint32_t>          queue_;
+    std::unordered_set<std::uint32_t> resident_;
+};
+
+class ClockPolicy : public Policy
+{
+public:
+    explicit ClockPolicy(std::size_t capacity)
+        : slots_(capacity)
+    {
+    }
+
+    bool access(std::uint32_t block) override
+    {
+        auto it = where_.find(block);
+        if (it != where_.end())
+        {
+            slots_[it->second].referenced = true;
+            return true;
+        }
+
+        if (used_ < slots_.size())
+        {
+            slots_[used_] = {block, true};
+            where_[block] = used_++;
+            return false;
+        }
+
+        // 指针扫过时清除引用位，遇到引用位为 0 的槽位即替换
+        while (slots_[hand_].referenced)
+        {
+            slots_[hand_].referenced = false;
+            hand_ = (hand_ + 1) % slots_.size();
+        }
+        where_.erase(slots_[hand_].block);
+        slots_[hand_] = {block, true};
+        where_[block] = hand_;
+        hand_ = (hand_ + 1) % slots_.size();
+        return false;
+    }
+
+private:
+    struct Slot
+    {
+        std::uint32_t block{0};
+        bool          referenced{false};
+    };
+
+    std::vector<Slot>                              slots_;
+    std::unordered_map<std::uint32_t, std::size_t> where_;
+    std::size_t                                    used_{0};
+    std::size_t                                    hand_{0};
+};
+
+// ARC（Megiddo & Modha）：T1/T2 为缓存中的块，B1/B2 为最近被淘汰块的“幽灵”记录，p 为 T1 的目标大小
+class ArcPolicy : public Policy
+{
+public:
+    explicit ArcPolicy(std::size_t capacity)
+        : c_(capacity)
+    {
+    }
+
+    bool access(std::uint32_t block) override
+    {
+        auto it = index_.find(block);
+        if (it != index_.end() && (it->second.list == kT1 || it->second.list == kT2))
+        {
+            moveTo(block, kT2);
+            return true;
+        }
+
+        if (it != index_.end() && it->second.list == kB1)
+        {
+            const std::size_t delta = std::max<std::size_t>(1, lists_[kB2].size() / std::max<std::size_t>(1, lists_[kB1].size()));
+            p_ = std::min(c_, p_ + delta);
+            replace(false);
+            moveTo(block, kT2);
+            return false;
+        }
+
+        if (it != index_.end() && it->second.list == kB2)
+        {
+            const std::size_t delta = std::max<std::size_t>(1, lists_[kB1].size() / std::max<std::size_t>(1, lists_[kB2].size()));
+            p_ = p_ > delta ? p_ - delta : 0;
+            replace(true);
+            moveTo(block, kT2);
+            return false;
+        }
+
+        // 全新的块
+        const std::size_t l1 = lists_[kT1].size() + lists_[kB1].size();
+        const std::size_t total = l1 + lists_[kT2].size() + lists_[kB2].size();
+        if (l1 == c_)
+        {
+            if (lists_[kT1].size() < c_)
+            {
+                dropLru(kB1);
+                replace(false);
+            }
+            else
+            {
+                dropLru(kT1);
+            }
+        }
+        else if (l1 < c_ && total >= c_)
+        {
+            if (total == 2 * c_)
+            {
+                dropLru(kB2);
+            }
+            replace(false);
+        }
+        insertMru(block, kT1);
+        return false;
+    }
+
+private:
+    enum ListId
+    {
+        kT1 = 0,
+        kT2 = 1,
+        kB1 = 2,
+        kB2 = 3
+    };
+
+    struct Location
+    {
+        ListId                             list;
+        std::list<std::uint32_t>::iterator pos;
+    };
+
+    void insertMru(std::uint32_t block, ListId list)
+    {
+        lists_[list].push_front(block);
+        index_[block] = {list, lists_[list].begin()};
+    }
+
+    void moveTo(std::uint32_t block, ListId list)
+    {
+        auto& loc = index_[block];
+        lists_[loc.list].erase(loc.pos);
+        lists_[list].push_front(block);
+        loc = {list, lists_[list].begin()};
+    }
+
+    void dropLru(ListId list)
+    {
+        if (lists_[list].empty())
+        {
+            return;
+        }
+        index_.erase(lists_[list].back());
+        lists_[list].pop_back();
+    }
+
+    // 从 T1 或 T2 淘汰一个块，把它记入对应的幽灵列表
+    void replace(bool hitInB2)
+    {
+        const auto t1 = lists_[kT1].size();
+        if (t1 > 0 && (t1 > p_ || (hitInB2 && t1 == p_)))
+        {
+            moveTo(lists_[kT1].back(), kB1);
+        }
+        else if (!lists_[kT2].empty())
+        {
+            moveTo(lists_[kT2].back(), kB2);
+        }
+        else if (t1 > 0)
+        {
+            moveTo(lists_[kT1].back(), kB1);
+        }
+    }
+
+    std::size_t                                 c_;
+    std::size_t                                 p_{0};
+    std::list<std::uint32_t>                    lists_[4];
+    std::unordered_map<std::uint32_t, Location> index_;
+};
+
+// ------------ LRU 栈距离：一次回放得到所有容量的缺失率 ------------
+
+// 树状数组：在时间轴上标记“某块最近一次访问”的位置，区间和即两次访问之间的不同块数
+class Fenwick
+{
+public:
+    explicit Fenwick(std::size_t n)
+        : tree_(n + 1, 0)
+    {
+    }
+
+    void add(std::size_t i, int delta)
+    {
+        for (++i; i < tree_.size(); i += i & (~i + 1))
+        {
+            tree_[i] += delta;
+        }
+    }
+
+    // [0, i) 的和
+    [[nodiscard]] long long prefix(std::size_t i) const
+    {
+        long long s = 0;
+        for (; i > 0; i -= i & (~i + 1))
+        {
+            s += tree_[i];
+        }
+        return s;
+    }
+
+private:
+    std::vector<long long> tree_;
+};
+
+// 返回每次读访问的栈深度（1 表示刚被访问过；0 表示冷缺失）
+std::vector<std::uint64_t> lruStackDepths(const std::vector<Access>& accesses)
+{
+    Fenwick                                          marks(accesses.size());
+    std::unordered_map<std::uint32_t, std::size_t> last;
+    std::vector<std::uint64_t>                       depths;
+    depths.reserve(accesses.size());
+
+    for (std::size_t t = 0; t < accesses.size(); ++t)
+    {
+        const auto& a = accesses[t];
+        auto        it = last.find(a.block);
+        std::uint64_t depth = 0;
+        if (it != last.end())
+        {
+            depth = static_cast<std::uint64_t>(marks.prefix(t) - marks.prefix(it->second + 1)) + 1;
+            marks.add(it->second, -1);
+            it->second = t;
+        }
+        else
+        {
+            last.emplace(a.block, t);
+        }
+        marks.add(t, 1);
+
+        if (!a.write)
+        {
+            depths.push_back(depth);
+        }
+    }
+    return depths;
+}
+
+double simulate(const std::string& name, std::size_t capacity, const std::vector<Access>& accesses)
+{
+    std::unique_ptr<Policy> policy;
+    if (name == "fifo")
+    {
+        policy = std::make_unique<FifoPolicy>(capacity);
+    }
+    else if (name == "clock")
+    {
+        policy = std::make_unique<ClockPolicy>(capacity);
+    }
+    else
+    {
+        policy = std::make_unique<ArcPolicy>(capacity);
+    }
+
+    std::uint64_t reads = 0;
+    std::uint64_t misses = 0;
+    for (const auto& a : accesses)
+    {
+        const bool hit = policy->access(a.block);
+        if (!a.write)
+        {
+            ++reads;
+            if (!hit)
+            {
+                ++misses;
+            }
+        }
+    }
+    return reads == 0 ? 0.0 : static_cast<double>(misses) / static_cast<double>(reads);
+}
+
+// SHARDS 空间采样：按块号哈希决定是否保留，同一块的所有访问要么全保留要么全丢弃
+bool sampled(std::uint32_t block, double rate)
+{
+    std::uint64_t x = block + 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    constexpr std::uint64_t kModulus = 1u << 24;
+    return static_cast<double>(x % kModulus) < rate * static_cast<double>(kModulus);
+}
+
+std::size_t scaledCapacity(std::size_t capacity, double rate)
+{
+    return std::max<std::size_t>(1, static_cast<std::size_t>(std::llround(static_cast<double>(capacity) * rate)));
+}
+
+bool parseList(const std::string& s, std::vector<std::string>& out)
+{
+    out.clear();
+    std::stringstream ss(s);
+    std::string       item;
+    while (std::getline(ss, item, ','))
+    {
+        if (!item.empty())
+        {
+            out.push_back(item);
+        }
+    }
+    return !out.empty();
+}
+
+bool parseOptions(int argc, char** argv, Options& opt)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+        try
+        {
+            if (arg == "--capacities")
+            {
+                const char* v = next();
+                std::vector<std::string> items;
+                if (!v || !parseList(v, items)) return false;
+                opt.capacities.clear();
+                for (const auto& item : items)
+                {
+                    opt.capacities.push_back(std::max<std::size_t>(1, std::stoul(item)));
+                }
+                std::sort(opt.capacities.begin(), opt.capacities.end());
+            }
+            else if (arg == "--policies")
+            {
+                const char* v = next();
+                if (!v || !parseList(v, opt.policies)) return false;
+                for (const auto& p : opt.policies)
+                {
+                    if (p != "lru" && p != "fifo" && p != "clock" && p != "arc") return false;
+                }
+            }
+            else if (arg == "--sample-rate")
+            {
+                const char* v = next();
+                if (!v) return false;
+                opt.sampleRate = std::stod(v);
+                if (!(opt.sampleRate > 0.0 && opt.sampleRate <= 1.0)) return false;
+            }
+            else if (arg == "--json")
+            {
+                opt.jsonOutput = true;
+            }
+            else if (!arg.empty() && arg[0] != '-' && opt.tracePath.empty())
+            {
+                opt.tracePath = arg;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        catch (...)
+        {
+            return false;
+        }
+    }
+    return !opt.tracePath.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if (!parseOptions(argc, argv, opt))
+    {
+        std::cerr << "Usage: osproj_cachesim <trace file> [--capacities 16,32,...] [--policies lru,fifo,clock,arc]\n"
+                     "                       [--sample-rate R] [--json]\n";
+        return 2;
+    }
+
+    const auto trace = osp::fs::readBlockTrace(opt.tracePath);
+    if (!trace)
+    {
+        std::cerr << "osproj_cachesim: cannot read block trace " << opt.tracePath << '\n';
+        return 1;
+    }
+
+    std::uint64_t                     reads = 0;
+    std::uint64_t                     writes = 0;
+    std::unordered_set<std::uint32_t> unique;
+    std::vector<Access>               accesses;
+    accesses.reserve(trace->records.size());
+    for (const auto rec : trace->records)
+    {
+        const Access a{rec & ~osp::fs::kBlockTraceWriteBit, (rec & osp::fs::kBlockTraceWriteBit) != 0};
+        a.write ? ++writes : ++reads;
+        unique.insert(a.block);
+        if (opt.sampleRate >= 1.0 || sampled(a.block, opt.sampleRate))
+        {
+            accesses.push_back(a);
+        }
+    }
+
+    // 每个策略在每个容量下的读缺失率
+    std::vector<std::vector<double>> ratios(opt.policies.size(), std::vector<double>(opt.capacities.size(), 0.0));
+    for (std::size_t p = 0; p < opt.policies.size(); ++p)
+    {
+        if (opt.policies[p] == "lru")
+        {
+            const auto depths = lruStackDepths(accesses);
+            for (std::size_t c = 0; c < opt.capacities.size(); ++c)
+            {
+                const auto cap = scaledCapacity(opt.capacities[c], opt.sampleRate);
+                const auto misses = std::count_if(depths.begin(), depths.end(),
+                                                  [cap](std::uint64_t d) { return d == 0 || d > cap; });
+                ratios[p][c] = depths.empty() ? 0.0 : static_cast<double>(misses) / static_cast<double>(depths.size());
+            }
+            continue;
+        }
+        for (std::size_t c = 0; c < opt.capacities.size(); ++c)
+        {
+            ratios[p][c] = simulate(opt.policies[p], scaledCapacity(opt.capacities[c], opt.sampleRate), accesses);
+        }
+    }
+
+    // 建议容量：以 LRU（未选时取第一个策略）为准，缺失率与最大容量相差不超过 1 个百分点的最小容量
+    const auto lruIt = std::find(opt.policies.begin(), opt.policies.end(), "lru");
+    const auto& curve = ratios[lruIt == opt.policies.end() ? 0 : static_cast<std::size_t>(lruIt - opt.policies.begin())];
+    std::size_t suggested = opt.capacities.back();
+    for (std::size_t c = 0; c < opt.capacities.size(); ++c)
+    {
+        if (curve[c] <= curve.back() + 0.01)
+        {
+            suggested = opt.capacities[c];
+            break;
+        }
+    }
+
+    if (opt.jsonOutput)
+    {
+        json policies = json::object();
+        for (std::size_t p = 0; p < opt.policies.size(); ++p)
+        {
+            json points = json::array();
+            for (std::size_t c = 0; c < opt.capacities.size(); ++c)
+            {
+                points.push_back({{"capacity", opt.capacities[c]}, {"missRatio", ratios[p][c]}});
+            }
+            policies[opt.policies[p]] = points;
+        }
+        json report = {
+            {"records", trace->records.size()},
+            {"reads", reads},
+            {"writes", writes},
+            {"uniqueBlocks", unique.size()},
+            {"sampleRate", opt.sampleRate},
+            {"sampledAccesses", accesses.size()},
+            {"policies", policies},
+            {"suggestedCapacity", suggested}
+        };
+        std::cout << report.dump(2) << '\n';
+        return 0;
+    }
+
+    std::cout << "trace: " << trace->records.size() << " accesses (" << reads << " reads, " << writes << " writes), "
+              << unique.size() << " distinct blocks of " << trace->totalBlocks << ", block size " << trace->blockSize
+              << '\n';
+    if (opt.sampleRate < 1.0)
+    {
+        std::cout << "sample rate " << opt.sampleRate << ": replayed " << accesses.size() << " accesses\n";
+    }
+    std::cout << "read miss ratio by capacity (blocks):\n";
+    std::cout << std::left << std::setw(10) << "capacity" << std::right;
+    for (const auto& p : opt.policies)
+    {
+        std::cout << std::setw(10) << p;
+    }
+    std::cout << '\n' << std::fixed << std::setprecision(2);
+    for (std::size_t c = 0; c < opt.capacities.size(); ++c)
+    {
+        std::cout << std::left << std::setw(10) << opt.capacities[c] << std::right;
+        for (std::size_t p = 0; p < opt.policies.size(); ++p)
+        {
+            std::cout << std::setw(9) << ratios[p][c] * 100.0 << '%';
+        }
+        std::cout << '\n';
+    }
+    std::cout << "suggested cacheCapacity: " << suggested << '\n';
+    return 0;
+}
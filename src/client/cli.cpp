@@ -175,7 +175,7 @@ std::optional<osp::protocol::Message> Cli::sendRequest(const osp::protocol::json
     req.type = osp::protocol::MessageType::CommandRequest;
     req.payload = payload;
 
-    osp::log(osp::LogLevel::Info, "Send request: " + payload.dump() + " to " + host_ + ":" + std::to_string(port_));
+    OSP_LOG(osp::LogLevel::Info, "Send request: " + payload.dump() + " to " + host_ + ":" + std::to_string(port_));
 
     osp::net::TcpClient tcpClient(host_, port_);
     return tcpClient.request(req);
@@ -204,7 +204,7 @@ void Cli::handleLoginResponse(const osp::protocol::Message& resp)
 
     if (!sessionId_.empty())
     {
-        osp::log(osp::LogLevel::Info, "Logged in as " + currentUser_ + " (" + currentRole_ + ")");
+        OSP_LOG(osp::LogLevel::Info, "Logged in as " + currentUser_ + " (" + currentRole_ + ")");
     }
 }
 
@@ -216,9 +216,99 @@ void Cli::printResponse(const osp::protocol::Message& resp) const
     std::cout << resp.payload.dump(2) << '\n';
 }
 
+Cli::~Cli()
+{
+    stopWatch();
+}
+
+void Cli::startWatch(const std::string& line)
+{
+    if (sessionId_.empty())
+    {
+        std::cout << "WATCH: need to login first\n";
+        return;
+    }
+    if (watchThread_.joinable())
+    {
+        if (watching_.load())
+        {
+            std::cout << "WATCH: already watching (use UNWATCH to stop)\n";
+            return;
+        }
+        stopWatch();
+    }
+
+    watchClient_ = std::make_unique<osp::net::TcpClient>(host_, static_cast<std::uint16_t>(port_));
+    if (!watchClient_->open())
+    {
+        std::cout << "WATCH: failed to contact server\n";
+        watchClient_.reset();
+        return;
+    }
+
+    osp::protocol::Message req;
+    req.type = osp::protocol::MessageType::CommandRequest;
+    req.payload = buildJsonPayload(line);
+
+    if (!watchClient_->send(req))
+    {
+        std::cout << "WATCH: failed to send request\n";
+        watchClient_.reset();
+        return;
+    }
+
+    auto ack = watchClient_->receive();
+    if (!ack || !ack->payload.value("ok", false))
+    {
+        std::cout << "WATCH failed: " << (ack ? ack->payload.dump() : std::string("no response")) << '\n';
+        watchClient_.reset();
+        return;
+    }
+
+    std::cout << "Watching for paper events (type UNWATCH to stop).\n";
+    watching_.store(true);
+    watchThread_ = std::thread([this] {
+        while (auto msg = watchClient_->receive())
+        {
+            const auto& payload = msg->payload;
+            if (!payload.contains("data") || !payload["data"].contains("event"))
+            {
+                continue;
+            }
+            const auto& event = payload["data"]["event"];
+            const std::string type = event.value("type", "");
+            if (type == "Heartbeat")
+            {
+                continue;
+            }
+            std::cout << "\n[事件] " << type;
+            if (event.contains("data"))
+            {
+                std::cout << ' ' << event["data"].dump();
+            }
+            std::cout << "\n> " << std::flush;
+        }
+        watching_.store(false);
+    });
+}
+
+void Cli::stopWatch()
+{
+    if (watchClient_)
+    {
+        watchClient_->shutdown();
+    }
+    if (watchThread_.joinable())
+    {
+        watchThread_.join();
+    }
+    watchClient_.reset();
+    watching_.store(false);
+}
+
 void Cli::run()
 {
-    osp::log(osp::LogLevel::Info, "Client CLI started. Type commands or 'quit' to exit.");
+    OSP_LOG(osp::LogLevel::Info, "Client CLI started. Type commands or 'quit' to exit.");
     printGeneralGuide();
 
     for (;;)
@@ -239,7 +329,7 @@ void Cli::run()
 
         if (line == "quit" || line == "exit" || line == "q" || line == "Q")
         {
-            osp::log(osp::LogLevel::Info, "Client exiting by user command");
+            OSP_LOG(osp::LogLevel::Info, "Client exiting by user command");
             break;
         }
 
@@ -248,6 +338,22 @@ void Cli::run()
             continue;
         }
 
+        // 事件订阅（长连接，不走一次性请求通道）
+        {
+            osp::protocol::Command local = osp::protocol::parseCommandLine(line);
+            if (local.name == "WATCH")
+            {
+                startWatch(line);
+                continue;
+            }
+            if (local.name == "UNWATCH")
+            {
+                stopWatch();
+                std::cout << "Stopped watching.\n";
+                continue;
+            }
+        }
+
         // 角色数字菜单处理
         if (currentRole_ == "Author")
         {
@@ -323,7 +429,7 @@ void Cli::run()
             auto resp = sendRequest(listPayload);
             if (!resp)
             {
-                osp::log(osp::LogLevel::Error, "CD: failed to contact server");
+                OSP_LOG(osp::LogLevel::Error, "CD: failed to contact server");
                 std::cout << "CD: failed to contact server\n";
                 continue;
             }
@@ -346,7 +452,7 @@ void Cli::run()
         auto resp = sendRequest(payload);
         if (!resp)
         {
-            osp::log(osp::LogLevel::Error, "Failed to get response from server");
+            OSP_LOG(osp::LogLevel::Error, "Failed to get response from server");
             continue;
         }
 
@@ -381,7 +487,12 @@ void Cli::printGeneralGuide() const
     std::cout << "  ROLE_HELP                 - 查看当前角色可用命令/菜单\n";
     std::cout << "  quit / exit / q           - 退出客户端\n";
     std::cout << "文件系统命令:\n";
-    std::cout << "  LIST [path] | MKDIR <path> | WRITE <path> <content> | READ <path> | RM <path> | RMDIR <path> | CD <path>\n";
+    std::cout << "  LIST [path] | MKDIR <path> | WRITE <path> <content> | APPEND <path> <content> | READ <path> | STAT <path> | RM <path> | RMDIR <path> | CD <path>\n";
+    std::cout << "论文检索（需登录）:\n";
+    std::cout << "  SEARCH <关键词...>        - 按标题/正文全文检索论文，返回相关度排序结果\n";
+    std::cout << "  GET_PAPER <ID> <offset> [length] - 分页读取论文正文（大论文按页读取）\n";
+    std::cout << "变更通知（需登录）:\n";
+    std::cout << "  WATCH [sinceSeq] | UNWATCH - 订阅/取消订阅论文变更事件（提交、分配、评审、决定），无需反复刷新列表\n";
     std::cout << "内置账号（用户名=密码）：admin / author / reviewer / editor\n";
     std::cout << "----------------\n";
 }
@@ -1,10 +1,14 @@
 #pragma once
 
+#include "client/net/tcp_client.hpp"
 #include "common/protocol.hpp"
 
+#include <atomic>
+#include <memory>
 #include <string>
 #include <set>
 #include <optional>
+#include <thread>
 
 namespace osp::client
 {
@@ -19,6 +23,8 @@ public:
     {
     }
 
+    ~Cli();
+
     // 启动交互式命令行循环。
     // - 支持 LOGIN 命令获取会话 ID（session）；
     // - 对后续业务命令自动携带 sessionId。
@@ -37,6 +43,10 @@ private:
     // 格式化输出 JSON 响应（pretty print 或用户友好的格式）
     void printResponse(const osp::protocol::Message& resp) const;
 
+    // WATCH：在后台线程保持一条长连接，服务器推送的变更事件会直接打印出来；UNWATCH 结束订阅。
+    void startWatch(const std::string& line);
+    void stopWatch();
+
     // 打印通用指引（PING/LOGIN/退出等）。
     void printGeneralGuide() const;
 
@@ -67,6 +77,11 @@ private:
     std::string    currentRole_;        // 当前登录角色（Admin / Editor / ...）
     std::string    currentPath_ = "/";  // 客户端维护的"当前目录"（仅影响默认 LIST 等命令）
 
+    // WATCH 后台订阅
+    std::unique_ptr<osp::net::TcpClient> watchClient_;
+    std::thread                          watchThread_;
+    std::atomic<bool>                    watching_{false};
+
     // 作者数字菜单的临时状态
     enum class AuthorWizard
     {
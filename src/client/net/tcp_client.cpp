@@ -85,13 +85,13 @@ std::optional<osp::protocol::Message> TcpClient::recvMessage(int fd)
     return osp::protocol::deserialize(data);
 }
 
-std::optional<osp::protocol::Message> TcpClient::request(const osp::protocol::Message& req)
+int TcpClient::connectSocket() const
 {
     const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
     if (fd < 0)
     {
-        osp::log(osp::LogLevel::Error, "TcpClient: failed to create socket");
-        return std::nullopt;
+        OSP_LOG(osp::LogLevel::Error, "TcpClient: failed to create socket");
+        return -1;
     }
 
     sockaddr_in addr{};
@@ -99,21 +99,86 @@ std::optional<osp::protocol::Message> TcpClient::request(const osp::protocol::Me
     addr.sin_port = htons(port_);
     if (::inet_pton(AF_INET, host_.c_str(), &addr.sin_addr) <= 0)
     {
-        osp::log(osp::LogLevel::Error, "TcpClient: invalid host");
+        OSP_LOG(osp::LogLevel::Error, "TcpClient: invalid host");
         ::close(fd);
-        return std::nullopt;
+        return -1;
     }
 
     if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
     {
-        osp::log(osp::LogLevel::Error, "TcpClient: connect failed");
+        OSP_LOG(osp::LogLevel::Error, "TcpClient: connect failed");
         ::close(fd);
+        return -1;
+    }
+
+    if (timeout_.count() > 0)
+    {
+        timeval tv{};
+        tv.tv_sec = static_cast<decltype(tv.tv_sec)>(timeout_.count() / 1000);
+        tv.tv_usec = static_cast<decltype(tv.tv_usec)>((timeout_.count() % 1000) * 1000);
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    }
+    return fd;
+}
+
+TcpClient::~TcpClient()
+{
+    close();
+}
+
+bool TcpClient::open()
+{
+    if (fd_ >= 0)
+    {
+        return true;
+    }
+    fd_ = connectSocket();
+    return fd_ >= 0;
+}
+
+bool TcpClient::send(const osp::protocol::Message& msg)
+{
+    return fd_ >= 0 && sendMessage(fd_, msg);
+}
+
+std::optional<osp::protocol::Message> TcpClient::receive()
+{
+    if (fd_ < 0)
+    {
+        return std::nullopt;
+    }
+    return recvMessage(fd_);
+}
+
+void TcpClient::shutdown()
+{
+    if (fd_ >= 0)
+    {
+        ::shutdown(fd_, SHUT_RDWR);
+    }
+}
+
+void TcpClient::close()
+{
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+std::optional<osp::protocol::Message> TcpClient::request(const osp::protocol::Message& req)
+{
+    const int fd = connectSocket();
+    if (fd < 0)
+    {
         return std::nullopt;
     }
 
     if (!sendMessage(fd, req))
     {
-        osp::log(osp::LogLevel::Error, "TcpClient: failed to send message");
+        OSP_LOG(osp::LogLevel::Error, "TcpClient: failed to send message");
         ::close(fd);
         return std::nullopt;
     }
@@ -121,7 +186,7 @@ std::optional<osp::protocol::Message> TcpClient::request(const osp::protocol::Me
     auto resp = recvMessage(fd);
     if (!resp)
     {
-        osp::log(osp::LogLevel::Error, "TcpClient: failed to receive response");
+        OSP_LOG(osp::LogLevel::Error, "TcpClient: failed to receive response");
     }
 
     ::close(fd);
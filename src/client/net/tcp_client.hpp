@@ -2,6 +2,7 @@
 
 #include "common/protocol.hpp"
 
+#include <chrono>
 #include <cstdint>
 #include <optional>
 #include <string>
@@ -10,17 +11,49 @@ namespace osp::net
 {
 
 // 简单的阻塞式 TCP 客户端：连接服务器、发送一条 Message、接收一条响应。
+// 也支持保持长连接（open/send/receive/close），用于 WATCH 事件推送等场景。
 class TcpClient
 {
 public:
     TcpClient(std::string host, std::uint16_t port);
+    ~TcpClient();
+
+    TcpClient(const TcpClient&) = delete;
+    TcpClient& operator=(const TcpClient&) = delete;
 
     // 连接到服务器，发送 req，并等待响应；失败时返回 std::nullopt。
     std::optional<osp::protocol::Message> request(const osp::protocol::Message& req);
 
+    // ------------ 长连接接口 ------------
+
+    // 建立长连接（已连接时直接返回 true）
+    bool open();
+
+    // 在长连接上发送一条消息
+    bool send(const osp::protocol::Message& msg);
+
+    // 在长连接上阻塞接收一条消息；连接关闭或出错时返回 std::nullopt
+    std::optional<osp::protocol::Message> receive();
+
+    // 中断阻塞中的 receive()（可从其他线程调用），之后仍需 close()
+    void shutdown();
+
+    // 关闭长连接
+    void close();
+
+    // 设置收发超时（0 表示一直阻塞，默认值）；对之后建立的连接生效
+    void setTimeout(std::chrono::milliseconds timeout) noexcept { timeout_ = timeout; }
+
+    [[nodiscard]] bool isOpen() const noexcept { return fd_ >= 0; }
+
 private:
     std::string host_;
     std::uint16_t port_{};
+    int fd_{-1};
+    std::chrono::milliseconds timeout_{0};
+
+    // 创建 socket 并连接服务器，失败返回 -1
+    int connectSocket() const;
 
     static bool sendAll(int fd, const void* buf, std::size_t len);
     static bool recvAll(int fd, void* buf, std::size_t len);
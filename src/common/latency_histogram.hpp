@@ -0,0 +1,179 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace osp
+{
+
+// HDR 风格的对数-线性直方图：
+// - [0, 128) 区间每个整数一个桶；之后每个 2 的幂区间 [2^k, 2^(k+1)) 均分为 64 个桶，
+//   因此任意值的记录误差不超过 1/64（约 1.6%），最大可记录 2^40 - 1（更大的值计入最后一个桶）。
+// - 桶计数为 relaxed 原子变量：record() 无锁，可被多个线程并发调用；读取时是近似一致的快照。
+// 单位由调用方决定（本项目统一使用微秒）。
+class LatencyHistogram
+{
+public:
+    static constexpr std::size_t kLinearBuckets = 128;
+    static constexpr std::size_t kSubBuckets = 64;
+    static constexpr std::size_t kMaxExponent = 40;
+    static constexpr std::size_t kBucketCount = kLinearBuckets + (kMaxExponent - 7) * kSubBuckets;
+
+    LatencyHistogram() = default;
+
+    LatencyHistogram(const LatencyHistogram& other) noexcept { merge(other); }
+
+    LatencyHistogram& operator=(const LatencyHistogram& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            merge(other);
+        }
+        return *this;
+    }
+
+    void record(std::uint64_t value) noexcept
+    {
+        buckets_[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+
+        std::uint64_t cur = max_.load(std::memory_order_relaxed);
+        while (value > cur && !max_.compare_exchange_weak(cur, value, std::memory_order_relaxed))
+        {
+        }
+        cur = min_.load(std::memory_order_relaxed);
+        while (value < cur && !min_.compare_exchange_weak(cur, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void merge(const LatencyHistogram& other) noexcept
+    {
+        for (std::size_t i = 0; i < kBucketCount; ++i)
+        {
+            const auto c = other.buckets_[i].load(std::memory_order_relaxed);
+            if (c != 0)
+            {
+                buckets_[i].fetch_add(c, std::memory_order_relaxed);
+            }
+        }
+        count_.fetch_add(other.count_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        sum_.fetch_add(other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        max_.store(std::max(max_.load(std::memory_order_relaxed), other.max_.load(std::memory_order_relaxed)),
+                   std::memory_order_relaxed);
+        min_.store(std::min(min_.load(std::memory_order_relaxed), other.min_.load(std::memory_order_relaxed)),
+                   std::memory_order_relaxed);
+    }
+
+    void reset() noexcept
+    {
+        for (auto& b : buckets_)
+        {
+            b.store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+        min_.store(std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::uint64_t count() const noexcept { return count_.load(std::memory_order_relaxed); }
+    [[nodiscard]] std::uint64_t sum() const noexcept { return sum_.load(std::memory_order_relaxed); }
+    [[nodiscard]] std::uint64_t max() const noexcept { return max_.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] std::uint64_t min() const noexcept
+    {
+        return count() == 0 ? 0 : min_.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] double mean() const noexcept
+    {
+        const auto n = count();
+        return n == 0 ? 0.0 : static_cast<double>(sum()) / static_cast<double>(n);
+    }
+
+    // p 取 [0, 100]；返回该分位所在桶的上界（与 HdrHistogram 的 highestEquivalentValue 一致），不超过 max()
+    [[nodiscard]] std::uint64_t percentile(double p) const noexcept
+    {
+        const auto n = count();
+        if (n == 0)
+        {
+            return 0;
+        }
+        p = std::clamp(p, 0.0, 100.0);
+        auto target = static_cast<std::uint64_t>(p / 100.0 * static_cast<double>(n) + 0.5);
+        target = std::clamp<std::uint64_t>(target, 1, n);
+
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBucketCount; ++i)
+        {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= target)
+            {
+                return std::min(bucketUpperBound(i), max());
+            }
+        }
+        return max();
+    }
+
+    // 按桶遍历非空桶：fn(upperBound, count)，用于导出累计分布（如 Prometheus histogram）
+    template <typename Fn>
+    void forEachBucket(Fn&& fn) const
+    {
+        for (std::size_t i = 0; i < kBucketCount; ++i)
+        {
+            const auto c = buckets_[i].load(std::memory_order_relaxed);
+            if (c != 0)
+            {
+                fn(bucketUpperBound(i), c);
+            }
+        }
+    }
+
+    static std::size_t bucketIndex(std::uint64_t value) noexcept
+    {
+        if (value < kLinearBuckets)
+        {
+            return static_cast<std::size_t>(value);
+        }
+
+        int msb = 63;
+        while ((value >> msb) == 0)
+        {
+            --msb;
+        }
+        if (static_cast<std::size_t>(msb) >= kMaxExponent)
+        {
+            return kBucketCount - 1;
+        }
+        // value 落在 [2^msb, 2^(msb+1))，右移 shift 位后落在 [64, 128)
+        const auto shift = static_cast<std::size_t>(msb) - 6;
+        return kLinearBuckets + (shift - 1) * kSubBuckets + static_cast<std::size_t>((value >> shift) - kSubBuckets);
+    }
+
+    static std::uint64_t bucketUpperBound(std::size_t index) noexcept
+    {
+        if (index < kLinearBuckets)
+        {
+            return index;
+        }
+        const std::size_t   shift = (index - kLinearBuckets) / kSubBuckets + 1;
+        const std::uint64_t mantissa = (index - kLinearBuckets) % kSubBuckets + kSubBuckets;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, kBucketCount> buckets_{};
+    std::atomic<std::uint64_t>                           count_{0};
+    std::atomic<std::uint64_t>                           sum_{0};
+    std::atomic<std::uint64_t>                           max_{0};
+    std::atomic<std::uint64_t>                           min_{std::numeric_limits<std::uint64_t>::max()};
+};
+
+} // namespace osp
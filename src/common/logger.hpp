@@ -1,7 +1,31 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// 日志：
+// - 运行期级别阈值（setLogLevel），低于阈值的 OSP_LOG 只有一次 relaxed 读和一次比较，消息表达式不会求值；
+// - 编译期下限 OSP_LOG_MIN_LEVEL（0=Debug … 3=Error，CMake 选项同名），低于它的 OSP_LOG 直接被编译器消掉；
+// - 默认同步写 std::clog（客户端、基准等工具）；服务器调用 startAsyncLogging() 后改为异步：
+//   每个线程写自己的无锁单生产者环形缓冲区，由后台线程按时间顺序合并写出。
+//   缓冲区满时丢弃新消息而不阻塞调用方，丢弃条数由后台线程补记一条 WARN。
+
+#ifndef OSP_LOG_MIN_LEVEL
+#define OSP_LOG_MIN_LEVEL 0
+#endif
 
 namespace osp
 {
@@ -14,20 +38,297 @@ enum class LogLevel
     Error
 };
 
-inline void log(LogLevel level, std::string_view msg)
+inline const char* logLevelTag(LogLevel level) noexcept
 {
-    const char* tag = "";
     switch (level)
     {
-    case LogLevel::Debug: tag = "[DEBUG]"; break;
-    case LogLevel::Info: tag = "[INFO ]"; break;
-    case LogLevel::Warn: tag = "[WARN ]"; break;
-    case LogLevel::Error: tag = "[ERROR]"; break;
+    case LogLevel::Debug: return "[DEBUG]";
+    case LogLevel::Info: return "[INFO ]";
+    case LogLevel::Warn: return "[WARN ]";
+    case LogLevel::Error: return "[ERROR]";
+    }
+    return "";
+}
+
+class Logger
+{
+public:
+    static constexpr std::size_t kRingEntries = 1024; // 每线程缓冲条数，必须是 2 的幂
+
+    static Logger& instance()
+    {
+        static Logger logger;
+        return logger;
+    }
+
+    void setLevel(LogLevel level) noexcept { level_.store(level, std::memory_order_relaxed); }
+    [[nodiscard]] LogLevel level() const noexcept { return level_.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] bool enabled(LogLevel level) const noexcept
+    {
+        return static_cast<int>(level) >= OSP_LOG_MIN_LEVEL &&
+               level >= level_.load(std::memory_order_relaxed);
+    }
+
+    void write(LogLevel level, std::string msg)
+    {
+        if (!async_.load(std::memory_order_acquire))
+        {
+            std::clog << logLevelTag(level) << ' ' << msg << '\n';
+            return;
+        }
+        local().push(Record{nowNs(), level, std::move(msg)});
+    }
+
+    // 启动后台写线程；重复调用无效果
+    void startAsync()
+    {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        if (writer_.joinable())
+        {
+            return;
+        }
+        stop_.store(false, std::memory_order_relaxed);
+        writer_ = std::thread([this] { writerLoop(); });
+        async_.store(true, std::memory_order_release);
+    }
+
+    // 停止后台写线程并写出缓冲区中剩余的消息，之后的日志恢复同步写
+    void stopAsync()
+    {
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        if (!writer_.joinable())
+        {
+            return;
+        }
+        async_.store(false, std::memory_order_release);
+        stop_.store(true, std::memory_order_relaxed);
+        writer_.join();
     }
 
-    std::clog << tag << ' ' << msg << '\n';
+    ~Logger() { stopAsync(); }
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+private:
+    struct Record
+    {
+        std::uint64_t timeNs{0}; // 墙上时间（自 Unix 纪元）
+        LogLevel      level{LogLevel::Info};
+        std::string   msg;
+    };
+
+    // 单生产者（所属线程）/ 单消费者（后台写线程）环形缓冲区
+    class Ring
+    {
+    public:
+        explicit Ring(std::uint32_t tid)
+            : tid_(tid)
+        {
+        }
+
+        [[nodiscard]] std::uint32_t tid() const noexcept { return tid_; }
+
+        void push(Record&& r) noexcept
+        {
+            const auto tail = tail_.load(std::memory_order_relaxed);
+            if (tail - head_.load(std::memory_order_acquire) >= kRingEntries)
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            slots_[tail & (kRingEntries - 1)] = std::move(r);
+            tail_.store(tail + 1, std::memory_order_release);
+        }
+
+        // 由写线程调用：取出当前全部消息，返回取出条数
+        std::size_t drain(std::vector<std::pair<std::uint32_t, Record>>& out)
+        {
+            const auto head = head_.load(std::memory_order_relaxed);
+            const auto tail = tail_.load(std::memory_order_acquire);
+            for (auto i = head; i < tail; ++i)
+            {
+                out.emplace_back(tid_, std::move(slots_[i & (kRingEntries - 1)]));
+            }
+            head_.store(tail, std::memory_order_release);
+            return static_cast<std::size_t>(tail - head);
+        }
+
+        std::uint64_t takeDropped() noexcept { return dropped_.exchange(0, std::memory_order_relaxed); }
+
+    private:
+        const std::uint32_t                 tid_;
+        std::atomic<std::uint64_t>          head_{0};
+        std::atomic<std::uint64_t>          tail_{0};
+        std::atomic<std::uint64_t>          dropped_{0};
+        std::array<Record, kRingEntries>    slots_{};
+    };
+
+    Logger() = default;
+
+    static std::uint64_t nowNs() noexcept
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                              std::chrono::system_clock::now().time_since_epoch())
+                                              .count());
+    }
+
+    // 当前线程的缓冲区，首次使用时登记（只在此处加锁一次）；缓冲区由 Logger 持有，线程退出后仍会被写出
+    Ring& local()
+    {
+        thread_local Ring* ring = nullptr;
+        if (ring == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(ringsMutex_);
+            rings_.push_back(std::make_unique<Ring>(static_cast<std::uint32_t>(rings_.size() + 1)));
+            ring = rings_.back().get();
+        }
+        return *ring;
+    }
+
+    // 取出所有线程的消息，按时间排序后一次性写出；返回写出条数
+    std::size_t drainOnce(std::vector<std::pair<std::uint32_t, Record>>& batch, std::string& text)
+    {
+        batch.clear();
+        std::uint64_t dropped = 0;
+        {
+            std::lock_guard<std::mutex> lock(ringsMutex_);
+            for (auto& r : rings_)
+            {
+                r->drain(batch);
+                dropped += r->takeDropped();
+            }
+        }
+        if (batch.empty() && dropped == 0)
+        {
+            return 0;
+        }
+
+        std::stable_sort(batch.begin(), batch.end(), [](const auto& a, const auto& b) {
+            return a.second.timeNs < b.second.timeNs;
+        });
+
+        text.clear();
+        for (const auto& [tid, r] : batch)
+        {
+            appendLine(text, r.timeNs, r.level, tid, r.msg);
+        }
+        if (dropped > 0)
+        {
+            appendLine(text, nowNs(), LogLevel::Warn, 0,
+                       "Logger: dropped " + std::to_string(dropped) + " messages (ring buffer full)");
+        }
+        std::fwrite(text.data(), 1, text.size(), stderr);
+        std::fflush(stderr);
+        return batch.size();
+    }
+
+    // 格式：2026-01-02T03:04:05.678 [INFO ] [t3] 消息
+    static void appendLine(std::string& text, std::uint64_t timeNs, LogLevel level, std::uint32_t tid,
+                           std::string_view msg)
+    {
+        const auto secs = static_cast<std::time_t>(timeNs / 1000000000ULL);
+        const auto millis = static_cast<unsigned>((timeNs / 1000000ULL) % 1000);
+        std::tm tm{};
+        localtime_r(&secs, &tm);
+        char stamp[48];
+        std::snprintf(stamp, sizeof(stamp), "%04d-%02d-%02dT%02d:%02d:%02d.%03u ", tm.tm_year + 1900, tm.tm_mon + 1,
+                      tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, millis);
+        text += stamp;
+        text += logLevelTag(level);
+        text += " [t";
+        text += std::to_string(tid);
+        text += "] ";
+        text += msg;
+        text += '\n';
+    }
+
+    void writerLoop()
+    {
+        std::vector<std::pair<std::uint32_t, Record>> batch;
+        std::string                                   text;
+        // 空闲时逐步放慢轮询，生产者无需唤醒写线程（保持写日志路径无锁、无系统调用）
+        auto idle = std::chrono::milliseconds(1);
+        while (!stop_.load(std::memory_order_relaxed))
+        {
+            if (drainOnce(batch, text) > 0)
+            {
+                idle = std::chrono::milliseconds(1);
+                continue;
+            }
+            std::this_thread::sleep_for(idle);
+            idle = std::min(idle * 2, std::chrono::milliseconds(16));
+        }
+        // async_ 已关闭，不会再有新消息进入缓冲区（除了已在 push 途中的），最后再写两轮
+        drainOnce(batch, text);
+        drainOnce(batch, text);
+    }
+
+    std::atomic<LogLevel> level_{LogLevel::Info};
+    std::atomic<bool>     async_{false};
+    std::atomic<bool>     stop_{false};
+
+    std::mutex  controlMutex_;
+    std::thread writer_;
+
+    std::mutex                         ringsMutex_;
+    std::vector<std::unique_ptr<Ring>> rings_;
+};
+
+inline void setLogLevel(LogLevel level) noexcept
+{
+    Logger::instance().setLevel(level);
 }
 
-} // namespace osp
+inline bool shouldLog(LogLevel level) noexcept
+{
+    return Logger::instance().enabled(level);
+}
+
+// 解析 "debug" / "info" / "warn" / "error"（大小写不敏感），无法识别时返回 def
+inline LogLevel parseLogLevel(std::string_view s, LogLevel def) noexcept
+{
+    std::string lower;
+    for (char c : s)
+    {
+        lower += static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+    }
+    if (lower == "debug") return LogLevel::Debug;
+    if (lower == "info") return LogLevel::Info;
+    if (lower == "warn" || lower == "warning") return LogLevel::Warn;
+    if (lower == "error") return LogLevel::Error;
+    return def;
+}
+
+inline void startAsyncLogging()
+{
+    Logger::instance().startAsync();
+}
 
+inline void stopAsyncLogging()
+{
+    Logger::instance().stopAsync();
+}
+
+// 低于阈值时直接返回；消息已构造好的调用点用它即可，热路径请用 OSP_LOG 以避免构造消息
+inline void log(LogLevel level, std::string msg)
+{
+    auto& logger = Logger::instance();
+    if (logger.enabled(level))
+    {
+        logger.write(level, std::move(msg));
+    }
+}
+
+} // namespace osp
 
+// 先判断级别再求值消息表达式：OSP_LOG(osp::LogLevel::Debug, "x = " + std::to_string(x));
+#define OSP_LOG(level, ...)                                                                                            \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (static_cast<int>(level) >= OSP_LOG_MIN_LEVEL && ::osp::shouldLog(level))                                  \
+        {                                                                                                              \
+            ::osp::Logger::instance().write(level, __VA_ARGS__);                                                       \
+        }                                                                                                              \
+    } while (0)
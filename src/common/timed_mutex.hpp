@@ -0,0 +1,262 @@
+#pragma once
+
+#include "common/latency_histogram.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace osp
+{
+
+// 统计等待时间的互斥锁，满足 Lockable 要求，可直接用于 std::lock_guard / std::unique_lock。
+// - 无竞争时 try_lock 成功即返回，只比 std::mutex 多一次原子操作；
+// - 需要等待时才读取时钟，把等待时间累加到当前线程的 threadWaitStats()。
+//   调用方在请求开始/结束时各取一次快照，差值即为该请求在锁上的等待。
+// - 竞争分析：每个线程每 sampleEvery() 次加锁采样一次，记录这次的等待时间、持锁时间，
+//   按持锁线程当前的标签（ScopedTag，通常是命令名）汇总，通过 profile() 导出。
+class TimedMutex
+{
+public:
+    struct WaitStats
+    {
+        std::uint64_t acquisitions{0}; // lock() 次数
+        std::uint64_t contended{0};    // 其中需要等待的次数
+        std::uint64_t waitNanos{0};    // 累计等待时间
+    };
+
+    // 按持锁方标签汇总的采样结果（时间单位：纳秒）
+    struct SiteProfile
+    {
+        std::string      site;
+        std::uint64_t    samples{0};
+        std::uint64_t    contended{0}; // 采样中需要等待的次数
+        LatencyHistogram waitNs;
+        LatencyHistogram holdNs;
+    };
+
+    struct Profile
+    {
+        std::string              name;
+        std::uint64_t            acquisitions{0}; // 全部加锁次数（含未采样）
+        std::uint64_t            contended{0};    // 全部需要等待的次数（含未采样）
+        std::uint32_t            sampleEvery{0};
+        std::vector<SiteProfile> sites;           // 按采样持锁总时间从大到小排列
+    };
+
+    // 在作用域内把当前线程的持锁标签设为 site（需指向静态存储，例如字符串字面量）
+    class ScopedTag
+    {
+    public:
+        explicit ScopedTag(std::string_view site) noexcept
+            : previous_(threadTag())
+        {
+            threadTag() = site;
+        }
+        ~ScopedTag() { threadTag() = previous_; }
+
+        ScopedTag(const ScopedTag&) = delete;
+        ScopedTag& operator=(const ScopedTag&) = delete;
+
+    private:
+        std::string_view previous_;
+    };
+
+    explicit TimedMutex(std::string name = "mutex")
+        : name_(std::move(name))
+    {
+    }
+
+    TimedMutex(const TimedMutex&) = delete;
+    TimedMutex& operator=(const TimedMutex&) = delete;
+
+    void lock()
+    {
+        auto& stats = threadWaitStats();
+        ++stats.acquisitions;
+        acquisitions_.fetch_add(1, std::memory_order_relaxed);
+        const bool sampled = shouldSample();
+
+        if (mutex_.try_lock())
+        {
+            if (sampled)
+            {
+                beginSampledHold(0, false);
+            }
+            return;
+        }
+
+        const auto start = Clock::now();
+        mutex_.lock();
+        const auto waited = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+        ++stats.contended;
+        stats.waitNanos += waited;
+        contended_.fetch_add(1, std::memory_order_relaxed);
+        if (sampled)
+        {
+            beginSampledHold(waited, true);
+        }
+    }
+
+    bool try_lock()
+    {
+        if (!mutex_.try_lock())
+        {
+            return false;
+        }
+        acquisitions_.fetch_add(1, std::memory_order_relaxed);
+        if (shouldSample())
+        {
+            beginSampledHold(0, false);
+        }
+        return true;
+    }
+
+    void unlock()
+    {
+        if (!holdSampled_)
+        {
+            mutex_.unlock();
+            return;
+        }
+
+        // hold* 成员只由持锁线程读写，释放前取出，释放后再汇总，避免延长临界区
+        holdSampled_ = false;
+        const auto held = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - holdStart_).count());
+        const auto site = holdSite_;
+        const auto waited = holdWait_;
+        const bool contended = holdContended_;
+        mutex_.unlock();
+
+        recordSample(site, waited, held, contended);
+    }
+
+    [[nodiscard]] const std::string& name() const noexcept { return name_; }
+
+    // 导出采样结果（可与加锁并发调用）
+    [[nodiscard]] Profile profile() const
+    {
+        Profile p;
+        p.name = name_;
+        p.acquisitions = acquisitions_.load(std::memory_order_relaxed);
+        p.contended = contended_.load(std::memory_order_relaxed);
+        p.sampleEvery = sampleEvery().load(std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(profileMutex_);
+            p.sites.reserve(sites_.size());
+            for (const auto& [site, entry] : sites_)
+            {
+                p.sites.push_back(*entry);
+            }
+        }
+        std::sort(p.sites.begin(), p.sites.end(), [](const SiteProfile& a, const SiteProfile& b) {
+            return a.holdNs.sum() > b.holdNs.sum();
+        });
+        return p;
+    }
+
+    void resetProfile()
+    {
+        acquisitions_.store(0, std::memory_order_relaxed);
+        contended_.store(0, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(profileMutex_);
+        sites_.clear();
+    }
+
+    // 当前线程在所有 TimedMutex 上的累计等待（只由本线程读写，无需同步）
+    static WaitStats& threadWaitStats() noexcept
+    {
+        static thread_local WaitStats stats;
+        return stats;
+    }
+
+    // 当前线程的持锁标签，未设置时为 "(untagged)"
+    static std::string_view& threadTag() noexcept
+    {
+        static thread_local std::string_view tag{"(untagged)"};
+        return tag;
+    }
+
+    // 每个线程每 N 次加锁采样一次；0 表示关闭采样（全局生效）
+    static std::atomic<std::uint32_t>& sampleEvery() noexcept
+    {
+        static std::atomic<std::uint32_t> every{64};
+        return every;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static bool shouldSample() noexcept
+    {
+        const auto every = sampleEvery().load(std::memory_order_relaxed);
+        if (every == 0)
+        {
+            return false;
+        }
+        static thread_local std::uint32_t counter = 0;
+        if (++counter < every)
+        {
+            return false;
+        }
+        counter = 0;
+        return true;
+    }
+
+    void beginSampledHold(std::uint64_t waited, bool contended) noexcept
+    {
+        holdSampled_ = true;
+        holdSite_ = threadTag();
+        holdWait_ = waited;
+        holdContended_ = contended;
+        holdStart_ = Clock::now();
+    }
+
+    void recordSample(std::string_view site, std::uint64_t waited, std::uint64_t held, bool contended)
+    {
+        std::lock_guard<std::mutex> lock(profileMutex_);
+        auto it = sites_.find(site);
+        if (it == sites_.end())
+        {
+            auto entry = std::make_unique<SiteProfile>();
+            entry->site = std::string(site);
+            it = sites_.emplace(entry->site, std::move(entry)).first;
+        }
+        auto& e = *it->second;
+        ++e.samples;
+        if (contended)
+        {
+            ++e.contended;
+        }
+        e.waitNs.record(waited);
+        e.holdNs.record(held);
+    }
+
+    std::mutex mutex_;
+    std::string name_;
+
+    std::atomic<std::uint64_t> acquisitions_{0};
+    std::atomic<std::uint64_t> contended_{0};
+
+    // 当前这次持锁是否被采样（受 mutex_ 保护）
+    bool              holdSampled_{false};
+    std::string_view  holdSite_;
+    std::uint64_t     holdWait_{0};
+    bool              holdContended_{false};
+    Clock::time_point holdStart_{};
+
+    mutable std::mutex                                                     profileMutex_;
+    std::map<std::string, std::unique_ptr<SiteProfile>, std::less<>> sites_;
+};
+
+} // namespace osp
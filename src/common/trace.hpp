@@ -0,0 +1,255 @@
+#pragma once
+
+#include "third_party/json.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 端到端请求追踪：在关键路径上打点（Span），每个线程写自己的环形缓冲区，按需导出为
+// Chrome trace JSON（chrome://tracing 或 https://ui.perfetto.dev 直接打开）。
+//
+// - 编译期开关：CMake 选项 OSP_ENABLE_TRACING（默认 OFF）。关闭时 OSP_TRACE_* 宏展开为空，没有任何开销；
+// - 运行期开关：osp::trace::setEnabled()，编译进来但未开启时每个打点只有一次 relaxed 读；
+// - 缓冲区写满后覆盖最旧的事件，导出的是每个线程最近 kThreadBufferEvents 个事件。
+// Span 名称必须指向静态存储（字符串字面量或常量表中的 string_view）。
+
+namespace osp::trace
+{
+
+#if defined(OSP_ENABLE_TRACING)
+constexpr bool kCompiledIn = true;
+#else
+constexpr bool kCompiledIn = false;
+#endif
+
+constexpr std::size_t kThreadBufferEvents = 8192;
+
+struct Event
+{
+    std::string_view name;
+    std::uint64_t    startNs{0};
+    std::uint64_t    durationNs{0};
+    char             phase{'X'}; // 'X'：完整区间；'i'：瞬时事件
+};
+
+// 单个线程的环形缓冲区：只由所属线程写入；导出线程通过每个槽位的序号判断读到的事件是否被并发覆盖
+class ThreadBuffer
+{
+public:
+    explicit ThreadBuffer(std::uint32_t tid)
+        : tid_(tid)
+    {
+    }
+
+    [[nodiscard]] std::uint32_t tid() const noexcept { return tid_; }
+
+    void push(const Event& e) noexcept
+    {
+        const auto index = head_.load(std::memory_order_relaxed);
+        auto&      slot = slots_[index % kThreadBufferEvents];
+        slot.seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.event = e;
+        slot.seq.store(index + 1, std::memory_order_release);
+        head_.store(index + 1, std::memory_order_release);
+    }
+
+    // 复制当前保留的事件（按写入顺序），跳过导出过程中被覆盖的槽位
+    void snapshot(std::vector<Event>& out) const
+    {
+        const auto head = head_.load(std::memory_order_acquire);
+        const auto begin = head > kThreadBufferEvents ? head - kThreadBufferEvents : 0;
+        for (auto i = begin; i < head; ++i)
+        {
+            const auto& slot = slots_[i % kThreadBufferEvents];
+            if (slot.seq.load(std::memory_order_acquire) != i + 1)
+            {
+                continue;
+            }
+            const Event copy = slot.event;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == i + 1)
+            {
+                out.push_back(copy);
+            }
+        }
+    }
+
+    void clear() noexcept
+    {
+        for (auto& slot : slots_)
+        {
+            slot.seq.store(0, std::memory_order_relaxed);
+        }
+        head_.store(0, std::memory_order_release);
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<std::uint64_t> seq{0}; // 0 表示空或正在写入，否则为写入序号 + 1
+        Event                      event;
+    };
+
+    const std::uint32_t                   tid_;
+    std::atomic<std::uint64_t>            head_{0};
+    std::array<Slot, kThreadBufferEvents> slots_{};
+};
+
+// 所有线程缓冲区的登记表；缓冲区由登记表持有，线程退出后其事件仍可导出
+class Registry
+{
+public:
+    static Registry& instance()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    ThreadBuffer& local()
+    {
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (buffer == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            buffers_.push_back(std::make_unique<ThreadBuffer>(static_cast<std::uint32_t>(buffers_.size() + 1)));
+            buffer = buffers_.back().get();
+        }
+        return *buffer;
+    }
+
+    void setEnabled(bool on) noexcept { enabled_.store(on, std::memory_order_relaxed); }
+    [[nodiscard]] bool enabled() const noexcept { return kCompiledIn && enabled_.load(std::memory_order_relaxed); }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& b : buffers_)
+        {
+            b->clear();
+        }
+    }
+
+    // 导出为 Chrome trace JSON（traceEvents 数组格式，时间单位微秒）
+    [[nodiscard]] nlohmann::json toChromeTrace() const
+    {
+        auto events = nlohmann::json::array();
+        std::vector<Event> buf;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& b : buffers_)
+        {
+            buf.clear();
+            b->snapshot(buf);
+            if (buf.empty())
+            {
+                continue;
+            }
+
+            events.push_back({{"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", b->tid()},
+                              {"args", {{"name", "thread-" + std::to_string(b->tid())}}}});
+            for (const auto& e : buf)
+            {
+                nlohmann::json j = {
+                    {"name", std::string(e.name)},
+                    {"cat", "osp"},
+                    {"ph", std::string(1, e.phase)},
+                    {"ts", static_cast<double>(e.startNs) / 1000.0},
+                    {"pid", 1},
+                    {"tid", b->tid()}
+                };
+                if (e.phase == 'X')
+                {
+                    j["dur"] = static_cast<double>(e.durationNs) / 1000.0;
+                }
+                else
+                {
+                    j["s"] = "t";
+                }
+                events.push_back(std::move(j));
+            }
+        }
+        return {{"traceEvents", std::move(events)}, {"displayTimeUnit", "ns"}};
+    }
+
+    static std::uint64_t nowNs() noexcept
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                              std::chrono::steady_clock::now().time_since_epoch())
+                                              .count());
+    }
+
+private:
+    Registry() = default;
+
+    std::atomic<bool>                          enabled_{false};
+    mutable std::mutex                         mutex_;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+inline void setEnabled(bool on) noexcept
+{
+    Registry::instance().setEnabled(on);
+}
+
+inline bool enabled() noexcept
+{
+    return Registry::instance().enabled();
+}
+
+// RAII 区间：构造时记录起点，析构时把完整事件写入当前线程的缓冲区
+class Span
+{
+public:
+    explicit Span(std::string_view name) noexcept
+        : name_(name)
+        , active_(enabled())
+        , startNs_(active_ ? Registry::nowNs() : 0)
+    {
+    }
+
+    ~Span()
+    {
+        if (active_)
+        {
+            Registry::instance().local().push({name_, startNs_, Registry::nowNs() - startNs_, 'X'});
+        }
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    std::string_view name_;
+    bool             active_;
+    std::uint64_t    startNs_;
+};
+
+inline void instant(std::string_view name) noexcept
+{
+    if (enabled())
+    {
+        Registry::instance().local().push({name, Registry::nowNs(), 0, 'i'});
+    }
+}
+
+} // namespace osp::trace
+
+#define OSP_TRACE_CONCAT_INNER(a, b) a##b
+#define OSP_TRACE_CONCAT(a, b) OSP_TRACE_CONCAT_INNER(a, b)
+
+#if defined(OSP_ENABLE_TRACING)
+#define OSP_TRACE_SPAN(name) ::osp::trace::Span OSP_TRACE_CONCAT(ospTraceSpan_, __LINE__)(name)
+#define OSP_TRACE_INSTANT(name) ::osp::trace::instant(name)
+#else
+#define OSP_TRACE_SPAN(name) ((void)0)
+#define OSP_TRACE_INSTANT(name) ((void)0)
+#endif
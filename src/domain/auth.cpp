@@ -69,21 +69,14 @@ bool AuthService::loadUsers()
     loadNextUserId();
 
     // 列出用户目录
-    auto listing = vfsOps_.listDirectory(kUsersDir);
+    auto listing = vfsOps_.listFiles(kUsersDir);
     if (!listing)
     {
         return true; // 目录为空或不存在，正常情况
     }
 
-    std::stringstream ss(*listing);
-    std::string       entry;
-
-    while (std::getline(ss, entry))
+    for (const auto& entry : *listing)
     {
-        if (entry.empty() || entry.back() == '/')
-        {
-            continue; // 跳过目录
-        }
 
         // 移除 .txt 后缀得到用户名
         if (entry.size() > 4 && entry.substr(entry.size() - 4) == ".txt")
@@ -31,7 +31,8 @@ struct VfsOperations
     std::function<bool(const std::string&, const std::string&)>     writeFile;
     std::function<std::optional<std::string>(const std::string&)>   readFile;
     std::function<bool(const std::string&)>                         removeFile;
-    std::function<std::optional<std::string>(const std::string&)>   listDirectory;
+    // 列出目录下的普通文件名（不含子目录），目录不存在时返回 std::nullopt
+    std::function<std::optional<std::vector<std::string>>(const std::string&)> listFiles;
 };
 
 // 认证服务：
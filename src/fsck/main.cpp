@@ -0,0 +1,1125 @@
+// osproj_fsck：离线检查 data.fs 镜像并给出布局统计（只读，不修改镜像，服务器运行时也可以检查其副本）。
+//
+// 用法：osproj_fsck <镜像文件> [--threads N] [--max-examples N] [--json]
+//
+// 检查项：
+// - superblock：魔数、块大小、各区域（inode 表 / 空闲位图 / 数据区）的范围与先后顺序；
+// - inode 表：编号、块指针是否落在数据区、内联文件与块文件的大小是否与指针一致、数据块是否被多个 inode 引用；
+// - 空闲位图与实际引用的数据块：被引用却标记为空闲（错误，之后会被重新分配而覆盖数据）、
+//   标记为已用却无人引用（警告，空间泄漏）；
+// - 目录：目录项指向的 inode 是否在用、类型是否一致、名称是否合法与重名、每个 inode 是否恰好被引用一次、
+//   是否都能从根目录到达。
+// 统计：inode 使用、空闲空间与空闲区段、碎片（与 Vfs::fragmentation 同口径）、文件大小与目录扇出直方图。
+//
+// 镜像通过 mmap 只读映射；inode 表、目录与位图按区间分给 --threads 个线程并行扫描（默认为 CPU 核数）。
+// 退出码：0 没有错误（可能有警告）；1 发现错误；2 无法打开镜像或 superblock 不可用。
+
+#include "common/protocol.hpp"
+#include "server/filesystem/dir_entry.hpp"
+#include "server/filesystem/inode.hpp"
+#include "server/filesystem/superblock.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+using osp::fs::DirEntry;
+using osp::fs::FileType;
+using osp::fs::Inode;
+using osp::fs::SuperBlock;
+using osp::protocol::json;
+
+struct Options
+{
+    std::string imagePath;
+    unsigned    threads{std::max(1u, std::thread::hardware_concurrency())};
+    std::size_t maxExamples{10};
+    bool        jsonOutput{false};
+};
+
+// ------------ 镜像访问 ------------
+
+// 只读映射整个镜像；compact() 截断后文件可能短于 totalBlocks * blockSize，末尾之后按全 0 块处理（与 Vfs 一致）
+class Image
+{
+public:
+    Image() = default;
+    ~Image()
+    {
+        if (data_ != nullptr)
+        {
+            ::munmap(const_cast<std::byte*>(data_), fileBytes_);
+        }
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+        }
+    }
+
+    Image(const Image&) = delete;
+    Image& operator=(const Image&) = delete;
+
+    bool open(const std::string& path)
+    {
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0)
+        {
+            return false;
+        }
+        struct stat st{};
+        if (::fstat(fd_, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(SuperBlock)))
+        {
+            return false;
+        }
+        fileBytes_ = static_cast<std::size_t>(st.st_size);
+        allocatedBytes_ = static_cast<std::uint64_t>(st.st_blocks) * 512u;
+
+        void* p = ::mmap(nullptr, fileBytes_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (p == MAP_FAILED)
+        {
+            return false;
+        }
+        data_ = static_cast<const std::byte*>(p);
+        ::madvise(p, fileBytes_, MADV_WILLNEED);
+        std::memcpy(&sb_, data_, sizeof(SuperBlock));
+        return true;
+    }
+
+    // 设置块大小后才能按块访问（superblock 校验通过之后调用）
+    void setBlockSize(std::uint32_t blockSize)
+    {
+        blockSize_ = blockSize;
+        zeroBlock_.assign(blockSize, std::byte{0});
+    }
+
+    [[nodiscard]] const std::byte* block(std::uint32_t id) const noexcept
+    {
+        const auto offset = static_cast<std::uint64_t>(id) * blockSize_;
+        if (offset + blockSize_ > fileBytes_)
+        {
+            return zeroBlock_.data();
+        }
+        return data_ + offset;
+    }
+
+    [[nodiscard]] const SuperBlock& superBlock() const noexcept { return sb_; }
+    [[nodiscard]] std::uint64_t fileBytes() const noexcept { return fileBytes_; }
+    [[nodiscard]] std::uint64_t allocatedBytes() const noexcept { return allocatedBytes_; }
+
+private:
+    int                    fd_{-1};
+    const std::byte*       data_{nullptr};
+    std::size_t            fileBytes_{0};
+    std::uint64_t          allocatedBytes_{0};
+    std::uint32_t          blockSize_{0};
+    std::vector<std::byte> zeroBlock_;
+    SuperBlock             sb_{};
+};
+
+// ------------ 问题汇总 ------------
+
+enum class Severity
+{
+    Warning,
+    Error
+};
+
+// 按问题类别计数，每类只保留前 maxExamples 条明细；各扫描线程并发写入（问题少见，直接加锁）
+class Findings
+{
+public:
+    struct Kind
+    {
+        Severity                 severity{Severity::Error};
+        std::uint64_t            count{0};
+        std::vector<std::string> examples;
+    };
+
+    explicit Findings(std::size_t maxExamples)
+        : maxExamples_(maxExamples)
+    {
+    }
+
+    void add(Severity severity, const char* kind, std::string detail)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& k = kinds_[kind];
+        k.severity = severity;
+        ++k.count;
+        if (k.examples.size() < maxExamples_)
+        {
+            k.examples.push_back(std::move(detail));
+        }
+    }
+
+    void error(const char* kind, std::string detail) { add(Severity::Error, kind, std::move(detail)); }
+    void warning(const char* kind, std::string detail) { add(Severity::Warning, kind, std::move(detail)); }
+
+    [[nodiscard]] std::uint64_t total(Severity severity) const
+    {
+        std::uint64_t n = 0;
+        for (const auto& [name, k] : kinds_)
+        {
+            if (k.severity == severity)
+            {
+                n += k.count;
+            }
+        }
+        return n;
+    }
+
+    [[nodiscard]] const std::map<std::string, Kind>& kinds() const noexcept { return kinds_; }
+
+private:
+    std::size_t                 maxExamples_;
+    std::mutex                  mutex_;
+    std::map<std::string, Kind> kinds_;
+};
+
+// ------------ 统计 ------------
+
+// 文件大小分桶：0、内联（<= InlineCapacity）、<= 1/2/4/8 个块
+constexpr std::size_t kSizeBuckets = 6;
+// 目录扇出分桶：0、1、2-3、4-7、8-15、16-31、32-63、>= 64
+constexpr std::size_t kFanoutBuckets = 8;
+
+// 每个线程各自累加，扫描结束后合并
+struct Stats
+{
+    std::uint64_t usedInodes{0};
+    std::uint64_t directories{0};
+    std::uint64_t files{0};
+    std::uint64_t inlineFiles{0};
+    std::uint64_t fileBytes{0};
+    std::uint64_t fileBlocks{0};
+    std::uint64_t dirBlocks{0};
+    std::uint64_t multiBlockFiles{0};
+    std::uint64_t fragmentedFiles{0};
+    std::uint64_t extents{0};
+    std::uint64_t dirEntries{0};
+    std::uint64_t maxFanout{0};
+
+    std::array<std::uint64_t, kSizeBuckets>   sizeHist{};
+    std::array<std::uint64_t, kFanoutBuckets> fanoutHist{};
+
+    void merge(const Stats& o)
+    {
+        usedInodes += o.usedInodes;
+        directories += o.directories;
+        files += o.files;
+        inlineFiles += o.inlineFiles;
+        fileBytes += o.fileBytes;
+        fileBlocks += o.fileBlocks;
+        dirBlocks += o.dirBlocks;
+        multiBlockFiles += o.multiBlockFiles;
+        fragmentedFiles += o.fragmentedFiles;
+        extents += o.extents;
+        dirEntries += o.dirEntries;
+        maxFanout = std::max(maxFanout, o.maxFanout);
+        for (std::size_t i = 0; i < kSizeBuckets; ++i)
+        {
+            sizeHist[i] += o.sizeHist[i];
+        }
+        for (std::size_t i = 0; i < kFanoutBuckets; ++i)
+        {
+            fanoutHist[i] += o.fanoutHist[i];
+        }
+    }
+};
+
+std::size_t sizeBucket(std::uint32_t size, std::uint32_t blockSize)
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+    if (size <= Inode::InlineCapacity)
+    {
+        return 1;
+    }
+    std::size_t   bucket = 2;
+    std::uint64_t limit = blockSize;
+    while (size > limit && bucket + 1 < kSizeBuckets)
+    {
+        limit *= 2;
+        ++bucket;
+    }
+    return bucket;
+}
+
+std::size_t fanoutBucket(std::uint64_t n)
+{
+    std::size_t bucket = 0;
+    while (n > 0 && bucket + 1 < kFanoutBuckets)
+    {
+        n >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+std::string humanBytes(std::uint64_t bytes)
+{
+    static const char* units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+    double             v = static_cast<double>(bytes);
+    std::size_t        u = 0;
+    while (v >= 1024.0 && u + 1 < std::size(units))
+    {
+        v /= 1024.0;
+        ++u;
+    }
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(u == 0 ? 0 : 1) << v << ' ' << units[u];
+    return os.str();
+}
+
+std::vector<std::string> sizeBucketLabels(std::uint32_t blockSize)
+{
+    // 文件最多 MaxDirectBlocks 个块，最后一桶（<= 8 个块）即覆盖全部合法大小
+    std::vector<std::string> labels{"0", "<=" + std::to_string(Inode::InlineCapacity) + " B"};
+    std::uint64_t            limit = blockSize;
+    for (std::size_t i = 2; i < kSizeBuckets; ++i, limit *= 2)
+    {
+        labels.push_back("<=" + humanBytes(limit));
+    }
+    return labels;
+}
+
+const std::array<const char*, kFanoutBuckets> kFanoutLabels{"0", "1", "2-3", "4-7", "8-15", "16-31", "32-63", ">=64"};
+
+// 把 [0, n) 切成 threads 段并行执行 fn(begin, end, threadIndex)
+template <typename Fn>
+void parallelFor(std::size_t n, unsigned threads, Fn&& fn)
+{
+    threads = static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(threads, n)));
+    if (threads <= 1)
+    {
+        fn(std::size_t{0}, n, 0u);
+        return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    const std::size_t chunk = (n + threads - 1) / threads;
+    for (unsigned t = 0; t < threads; ++t)
+    {
+        const std::size_t begin = std::min(n, t * chunk);
+        const std::size_t end = std::min(n, begin + chunk);
+        workers.emplace_back([&fn, begin, end, t] { fn(begin, end, t); });
+    }
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+}
+
+// ------------ 检查 ------------
+
+enum InodeKind : std::uint8_t
+{
+    kFree = 0,
+    kFile = 1,
+    kDirectory = 2,
+};
+
+constexpr std::uint32_t kNoOwner = 0xFFFFFFFFu;
+
+class Checker
+{
+public:
+    Checker(const Image& image, const Options& opt, Findings& findings)
+        : image_(image)
+        , sb_(image.superBlock())
+        , opt_(opt)
+        , findings_(findings)
+    {
+    }
+
+    // superblock 不可用时返回 false（无法继续检查）
+    bool checkSuperBlock();
+    void run();
+
+    [[nodiscard]] json toJson() const;
+    void               print(std::ostream& os) const;
+
+private:
+    [[nodiscard]] const std::byte* inodeRecord(std::uint32_t id) const
+    {
+        const std::uint32_t perBlock = sb_.blockSize / diskSize_;
+        return image_.block(sb_.inodeTableStart + id / perBlock) + static_cast<std::size_t>(id % perBlock) * diskSize_;
+    }
+
+    [[nodiscard]] bool bitmapUsed(std::uint32_t rel) const
+    {
+        const std::uint32_t bitsPerBlock = sb_.blockSize * 8u;
+        const std::byte*    bm = image_.block(sb_.freeBitmapStart + rel / bitsPerBlock);
+        const std::uint32_t bit = rel % bitsPerBlock;
+        return (static_cast<std::uint8_t>(bm[bit / 8u]) & (1u << (bit % 8u))) != 0;
+    }
+
+    [[nodiscard]] bool isDataBlock(std::uint32_t b) const
+    {
+        return b >= sb_.dataBlockStart && b < sb_.dataBlockStart + sb_.dataBlockCount;
+    }
+
+    void claimBlock(std::uint32_t block, std::uint32_t inodeId);
+    void scanInodes(std::size_t begin, std::size_t end, Stats& stats, std::vector<std::uint32_t>& dirs);
+    void scanDirectory(std::uint32_t dirId, Stats& stats, std::vector<std::pair<std::uint32_t, std::uint32_t>>& edges);
+    void checkReachability(const std::vector<std::pair<std::uint32_t, std::uint32_t>>& edges);
+    std::uint64_t scanBitmap(std::size_t begin, std::size_t end);
+    void measureFreeSpace();
+
+    const Image&      image_;
+    const SuperBlock& sb_;
+    const Options&    opt_;
+    Findings&         findings_;
+    std::uint32_t     diskSize_{0};
+
+    std::vector<std::uint8_t>                kinds_;     // 每个 inode 的 InodeKind
+    std::unique_ptr<std::atomic<std::uint32_t>[]> owners_; // 每个数据块的引用者 inode（kNoOwner 表示无）
+    std::unique_ptr<std::atomic<std::uint32_t>[]> refs_;   // 每个 inode 被目录项引用的次数
+
+    Stats         stats_;
+    std::uint64_t bitmapUsed_{0};
+    std::uint64_t freeRuns_{0};
+    std::uint64_t largestFreeRun_{0};
+    double        seconds_{0};
+    unsigned      threadsUsed_{1};
+};
+
+bool Checker::checkSuperBlock()
+{
+    auto fatal = [&](std::string detail) {
+        findings_.error("superblock", std::move(detail));
+        return false;
+    };
+
+    if (sb_.magic != SuperBlock{}.magic)
+    {
+        return fatal("bad magic 0x" + [&] {
+            std::ostringstream os;
+            os << std::hex << sb_.magic;
+            return os.str();
+        }() + " (not an osproj filesystem)");
+    }
+    if ((sb_.features & osp::fs::kFeatureStriped) != 0 && sb_.stripeCount > 1)
+    {
+        return fatal("striped image: data blocks are spread over " + std::to_string(sb_.stripeCount) +
+                     " files; check a BACKUP of it instead (backups are single-file images)");
+    }
+    if (sb_.inodeMigrationStaging != 0)
+    {
+        return fatal("inode table migration was interrupted (staged at block " +
+                     std::to_string(sb_.inodeMigrationStaging) + "); mount the image once to finish it");
+    }
+    if (sb_.blockSize < 512 || sb_.blockSize > (1u << 20) || (sb_.blockSize & (sb_.blockSize - 1)) != 0)
+    {
+        return fatal("invalid block size " + std::to_string(sb_.blockSize));
+    }
+    diskSize_ = osp::fs::inodeDiskSize(sb_.inodeSize);
+    if (diskSize_ != osp::fs::kLegacyInodeDiskSize && diskSize_ != osp::fs::kInodeDiskSizeV2 &&
+        diskSize_ != osp::fs::kInodeDiskSize)
+    {
+        return fatal("unknown inode record size " + std::to_string(sb_.inodeSize));
+    }
+    if (sb_.inodeTableStart < 1 || sb_.inodeTableBlocks == 0 ||
+        sb_.inodeTableStart + static_cast<std::uint64_t>(sb_.inodeTableBlocks) > sb_.freeBitmapStart)
+    {
+        return fatal("inode table [" + std::to_string(sb_.inodeTableStart) + ", +" +
+                     std::to_string(sb_.inodeTableBlocks) + ") overlaps the superblock or the bitmap");
+    }
+    if (sb_.freeBitmapBlocks == 0 ||
+        sb_.freeBitmapStart + static_cast<std::uint64_t>(sb_.freeBitmapBlocks) > sb_.dataBlockStart)
+    {
+        return fatal("free bitmap [" + std::to_string(sb_.freeBitmapStart) + ", +" +
+                     std::to_string(sb_.freeBitmapBlocks) + ") overlaps the data area");
+    }
+    if (sb_.dataBlockStart + static_cast<std::uint64_t>(sb_.dataBlockCount) > sb_.totalBlocks)
+    {
+        return fatal("data area [" + std::to_string(sb_.dataBlockStart) + ", +" + std::to_string(sb_.dataBlockCount) +
+                     ") extends past totalBlocks " + std::to_string(sb_.totalBlocks));
+    }
+    if (static_cast<std::uint64_t>(sb_.inodeCount) * diskSize_ >
+        static_cast<std::uint64_t>(sb_.inodeTableBlocks) * sb_.blockSize)
+    {
+        return fatal("inodeCount " + std::to_string(sb_.inodeCount) + " does not fit in " +
+                     std::to_string(sb_.inodeTableBlocks) + " inode table blocks");
+    }
+    if (static_cast<std::uint64_t>(sb_.freeBitmapBlocks) * sb_.blockSize * 8u < sb_.dataBlockCount)
+    {
+        return fatal("free bitmap too small for " + std::to_string(sb_.dataBlockCount) + " data blocks");
+    }
+    if (sb_.rootInodeId >= sb_.inodeCount)
+    {
+        return fatal("root inode " + std::to_string(sb_.rootInodeId) + " out of range");
+    }
+
+    if (sb_.dataBlockStart + sb_.dataBlockCount != sb_.totalBlocks)
+    {
+        findings_.warning("superblock", std::to_string(sb_.totalBlocks - sb_.dataBlockStart - sb_.dataBlockCount) +
+                                            " blocks after the data area are unused");
+    }
+    const auto expected = static_cast<std::uint64_t>(sb_.totalBlocks) * sb_.blockSize;
+    if (image_.fileBytes() > expected)
+    {
+        findings_.warning("image-size", "image is " + std::to_string(image_.fileBytes() - expected) +
+                                            " bytes longer than totalBlocks * blockSize");
+    }
+    return true;
+}
+
+void Checker::claimBlock(std::uint32_t block, std::uint32_t inodeId)
+{
+    auto&         owner = owners_[block - sb_.dataBlockStart];
+    std::uint32_t expected = kNoOwner;
+    if (!owner.compare_exchange_strong(expected, inodeId, std::memory_order_relaxed))
+    {
+        findings_.error("duplicate-block", "block " + std::to_string(block) + " referenced by inodes " +
+                                               std::to_string(expected) + " and " + std::to_string(inodeId));
+    }
+}
+
+void Checker::scanInodes(std::size_t begin, std::size_t end, Stats& stats, std::vector<std::uint32_t>& dirs)
+{
+    const std::uint32_t blockSize = sb_.blockSize;
+    for (auto id = static_cast<std::uint32_t>(begin); id < end; ++id)
+    {
+        Inode ino{};
+        osp::fs::decodeInode(inodeRecord(id), diskSize_, ino);
+        const std::string name = "inode " + std::to_string(id);
+
+        if (!ino.isUsed())
+        {
+            bool stale = ino.size != 0 || ino.isDirectory;
+            for (auto b : ino.directBlocks)
+            {
+                stale = stale || b != 0;
+            }
+            if (stale)
+            {
+                findings_.warning("stale-free-inode", name + " is free but still has size or block pointers");
+            }
+            continue;
+        }
+
+        ++stats.usedInodes;
+        if (ino.id != id)
+        {
+            findings_.error("inode-id", name + " records id " + std::to_string(ino.id));
+        }
+
+        // 块指针：必须落在数据区，且每个块只属于一个 inode
+        std::uint32_t blocks = 0;
+        std::uint32_t extents = 0;
+        std::uint32_t prev = 0;
+        for (std::size_t i = 0; i < Inode::MaxDirectBlocks; ++i)
+        {
+            const std::uint32_t b = ino.directBlocks[i];
+            if (b == 0)
+            {
+                continue;
+            }
+            if (!isDataBlock(b))
+            {
+                findings_.error("block-out-of-range", name + " directBlocks[" + std::to_string(i) + "] = " +
+                                                          std::to_string(b) + " is outside the data area");
+                continue;
+            }
+            claimBlock(b, id);
+            if (blocks == 0 || b != prev + 1)
+            {
+                ++extents;
+            }
+            ++blocks;
+            prev = b;
+        }
+
+        if (ino.isDirectory)
+        {
+            kinds_[id] = kDirectory;
+            ++stats.directories;
+            stats.dirBlocks += blocks;
+            if (ino.isInline())
+            {
+                findings_.error("directory", name + " is a directory with the inline flag set");
+            }
+            for (std::size_t i = 1; i < Inode::MaxDirectBlocks; ++i)
+            {
+                if (ino.directBlocks[i] != 0)
+                {
+                    findings_.error("directory", name + " uses directBlocks[" + std::to_string(i) +
+                                                     "] (directories occupy one block)");
+                }
+            }
+            if (ino.size % sizeof(DirEntry) != 0 || ino.size > blockSize)
+            {
+                findings_.error("directory", name + " has invalid size " + std::to_string(ino.size));
+            }
+            if (isDataBlock(ino.directBlocks[0]))
+            {
+                dirs.push_back(id);
+            }
+            else if (ino.size != 0)
+            {
+                findings_.error("directory", name + " has entries but no data block");
+            }
+            continue;
+        }
+
+        kinds_[id] = kFile;
+        ++stats.files;
+        stats.fileBytes += ino.size;
+        stats.fileBlocks += blocks;
+        ++stats.sizeHist[sizeBucket(ino.size, blockSize)];
+
+        if (ino.isInline())
+        {
+            ++stats.inlineFiles;
+            if (ino.size > Inode::InlineCapacity)
+            {
+                findings_.error("inline-size", name + " is inline but size " + std::to_string(ino.size) + " exceeds " +
+                                                   std::to_string(Inode::InlineCapacity) + " bytes");
+            }
+            if (blocks != 0)
+            {
+                findings_.error("inline-blocks", name + " is inline but also references data blocks");
+            }
+            continue;
+        }
+
+        if (ino.size > Inode::MaxDirectBlocks * static_cast<std::uint64_t>(blockSize))
+        {
+            findings_.error("file-size", name + " size " + std::to_string(ino.size) + " exceeds " +
+                                             std::to_string(Inode::MaxDirectBlocks) + " direct blocks");
+            continue;
+        }
+        const std::size_t needed = (ino.size + blockSize - 1) / blockSize;
+        for (std::size_t i = 0; i < Inode::MaxDirectBlocks; ++i)
+        {
+            if (i < needed && ino.directBlocks[i] == 0)
+            {
+                findings_.error("file-hole", name + " size " + std::to_string(ino.size) + " but directBlocks[" +
+                                                 std::to_string(i) + "] is empty");
+            }
+            else if (i >= needed && ino.directBlocks[i] != 0)
+            {
+                findings_.warning("block-past-eof", name + " keeps block " + std::to_string(ino.directBlocks[i]) +
+                                                        " past end of file");
+            }
+        }
+
+        if (blocks >= 2)
+        {
+            ++stats.multiBlockFiles;
+            stats.extents += extents;
+            if (extents > 1)
+            {
+                ++stats.fragmentedFiles;
+            }
+        }
+    }
+}
+
+void Checker::scanDirectory(std::uint32_t dirId, Stats& stats,
+                            std::vector<std::pair<std::uint32_t, std::uint32_t>>& edges)
+{
+    Inode dir{};
+    osp::fs::decodeInode(inodeRecord(dirId), diskSize_, dir);
+    const std::string name = "directory inode " + std::to_string(dirId);
+
+    const std::byte*  block = image_.block(dir.directBlocks[0]);
+    const std::size_t maxEntries = sb_.blockSize / sizeof(DirEntry);
+    const bool        typed = (sb_.features & osp::fs::kFeatureTypedDirEntries) != 0;
+
+    std::unordered_set<std::string>      names;
+    std::uint64_t                        count = 0;
+    for (std::size_t i = 0; i < maxEntries; ++i)
+    {
+        DirEntry e{};
+        std::memcpy(&e, block + i * sizeof(DirEntry), sizeof(DirEntry));
+        if (e.inodeId == 0)
+        {
+            continue;
+        }
+        ++count;
+
+        const auto entryName = std::string(e.nameView());
+        const auto where = name + " entry '" + entryName + "'";
+        if (e.inodeId >= sb_.inodeCount)
+        {
+            findings_.error("dangling-entry", where + " points to inode " + std::to_string(e.inodeId) + " (out of range)");
+            continue;
+        }
+        if (e.inodeId == sb_.rootInodeId)
+        {
+            findings_.error("root-reference", where + " points to the root directory");
+            continue;
+        }
+        if (kinds_[e.inodeId] == kFree)
+        {
+            findings_.error("dangling-entry", where + " points to free inode " + std::to_string(e.inodeId));
+            continue;
+        }
+        if (entryName.empty() || entryName.find('/') != std::string::npos || entryName == "." || entryName == "..")
+        {
+            findings_.error("entry-name", where + " has an invalid name");
+        }
+        if (e.name[sizeof(e.name) - 1] != '\0')
+        {
+            findings_.warning("entry-name", where + " name is not NUL-terminated");
+        }
+        if (!names.insert(entryName).second)
+        {
+            findings_.error("duplicate-name", where + " appears more than once");
+        }
+
+        const bool isDir = kinds_[e.inodeId] == kDirectory;
+        if (e.type == FileType::Unknown)
+        {
+            if (typed)
+            {
+                findings_.warning("entry-type", where + " has no file type although the image is marked typed");
+            }
+        }
+        else if ((e.type == FileType::Directory) != isDir)
+        {
+            findings_.error("entry-type", where + " type does not match inode " + std::to_string(e.inodeId));
+        }
+
+        refs_[e.inodeId].fetch_add(1, std::memory_order_relaxed);
+        edges.emplace_back(dirId, e.inodeId);
+    }
+
+    if (count * sizeof(DirEntry) != dir.size)
+    {
+        findings_.warning("directory-size", name + " size " + std::to_string(dir.size) + " but holds " +
+                                                std::to_string(count) + " entries");
+    }
+    stats.dirEntries += count;
+    stats.maxFanout = std::max(stats.maxFanout, count);
+    ++stats.fanoutHist[fanoutBucket(count)];
+}
+
+void Checker::checkReachability(const std::vector<std::pair<std::uint32_t, std::uint32_t>>& edges)
+{
+    if (kinds_[sb_.rootInodeId] != kDirectory)
+    {
+        findings_.error("root", "root inode " + std::to_string(sb_.rootInodeId) + " is not a used directory");
+        return;
+    }
+
+    // 目录树按父目录分组后从根做一次 BFS
+    std::vector<std::uint32_t> firstChild(sb_.inodeCount + 1, 0);
+    for (const auto& [parent, child] : edges)
+    {
+        ++firstChild[parent + 1];
+    }
+    for (std::size_t i = 1; i < firstChild.size(); ++i)
+    {
+        firstChild[i] += firstChild[i - 1];
+    }
+    std::vector<std::uint32_t> children(edges.size());
+    {
+        auto cursor = firstChild;
+        for (const auto& [parent, child] : edges)
+        {
+            children[cursor[parent]++] = child;
+        }
+    }
+
+    std::vector<bool>          reached(sb_.inodeCount, false);
+    std::vector<std::uint32_t> queue{sb_.rootInodeId};
+    reached[sb_.rootInodeId] = true;
+    for (std::size_t q = 0; q < queue.size(); ++q)
+    {
+        const auto dir = queue[q];
+        for (auto i = firstChild[dir]; i < firstChild[dir + 1]; ++i)
+        {
+            const auto child = children[i];
+            if (!reached[child])
+            {
+                reached[child] = true;
+                if (kinds_[child] == kDirectory)
+                {
+                    queue.push_back(child);
+                }
+            }
+        }
+    }
+
+    for (std::uint32_t id = 0; id < sb_.inodeCount; ++id)
+    {
+        if (kinds_[id] == kFree || id == sb_.rootInodeId)
+        {
+            continue;
+        }
+        const auto refs = refs_[id].load(std::memory_order_relaxed);
+        const auto what = std::string(kinds_[id] == kDirectory ? "directory" : "file") + " inode " + std::to_string(id);
+        if (refs == 0)
+        {
+            findings_.error("orphan-inode", what + " is in use but not referenced by any directory");
+        }
+        else if (refs > 1)
+        {
+            findings_.error("multiple-links", what + " is referenced by " + std::to_string(refs) + " directory entries");
+        }
+        else if (!reached[id])
+        {
+            findings_.error("unreachable", what + " is not reachable from the root directory");
+        }
+    }
+}
+
+// 返回该区间内位图标记为已用的块数
+std::uint64_t Checker::scanBitmap(std::size_t begin, std::size_t end)
+{
+    std::uint64_t used = 0;
+    for (auto rel = static_cast<std::uint32_t>(begin); rel < end; ++rel)
+    {
+        const bool marked = bitmapUsed(rel);
+        const auto owner = owners_[rel].load(std::memory_order_relaxed);
+        used += marked ? 1 : 0;
+        if (marked && owner == kNoOwner)
+        {
+            findings_.warning("leaked-block", "block " + std::to_string(sb_.dataBlockStart + rel) +
+                                                  " is marked used but not referenced");
+        }
+        else if (!marked && owner != kNoOwner)
+        {
+            findings_.error("unmarked-block", "block " + std::to_string(sb_.dataBlockStart + rel) + " used by inode " +
+                                                  std::to_string(owner) + " is marked free in the bitmap");
+        }
+    }
+    return used;
+}
+
+// 按位图统计空闲区段（顺序扫描，开销远小于前面的阶段）
+void Checker::measureFreeSpace()
+{
+    std::uint64_t run = 0;
+    for (std::uint32_t rel = 0; rel < sb_.dataBlockCount; ++rel)
+    {
+        if (!bitmapUsed(rel))
+        {
+            if (run++ == 0)
+            {
+                ++freeRuns_;
+            }
+            largestFreeRun_ = std::max(largestFreeRun_, run);
+        }
+        else
+        {
+            run = 0;
+        }
+    }
+}
+
+void Checker::run()
+{
+    const auto start = std::chrono::steady_clock::now();
+    threadsUsed_ = std::max(1u, opt_.threads);
+
+    kinds_.assign(sb_.inodeCount, kFree);
+    owners_ = std::make_unique<std::atomic<std::uint32_t>[]>(sb_.dataBlockCount);
+    refs_ = std::make_unique<std::atomic<std::uint32_t>[]>(sb_.inodeCount);
+    parallelFor(sb_.dataBlockCount, threadsUsed_, [&](std::size_t begin, std::size_t end, unsigned) {
+        for (auto i = begin; i < end; ++i)
+        {
+            owners_[i].store(kNoOwner, std::memory_order_relaxed);
+        }
+    });
+
+    // 1. inode 表：分类、块引用、大小一致性
+    std::vector<Stats>                      stats(threadsUsed_);
+    std::vector<std::vector<std::uint32_t>> dirs(threadsUsed_);
+    parallelFor(sb_.inodeCount, threadsUsed_, [&](std::size_t begin, std::size_t end, unsigned t) {
+        scanInodes(begin, end, stats[t], dirs[t]);
+    });
+
+    // 2. 目录：目录项与引用计数
+    std::vector<std::uint32_t> allDirs;
+    for (const auto& d : dirs)
+    {
+        allDirs.insert(allDirs.end(), d.begin(), d.end());
+    }
+    std::vector<std::vector<std::pair<std::uint32_t, std::uint32_t>>> edges(threadsUsed_);
+    parallelFor(allDirs.size(), threadsUsed_, [&](std::size_t begin, std::size_t end, unsigned t) {
+        for (auto i = begin; i < end; ++i)
+        {
+            scanDirectory(allDirs[i], stats[t], edges[t]);
+        }
+    });
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> allEdges;
+    for (const auto& e : edges)
+    {
+        allEdges.insert(allEdges.end(), e.begin(), e.end());
+    }
+
+    // 3. 从根目录可达性与链接数
+    checkReachability(allEdges);
+
+    // 4. 空闲位图与实际引用对比
+    std::vector<std::uint64_t> used(threadsUsed_, 0);
+    parallelFor(sb_.dataBlockCount, threadsUsed_, [&](std::size_t begin, std::size_t end, unsigned t) {
+        used[t] = scanBitmap(begin, end);
+    });
+    for (auto u : used)
+    {
+        bitmapUsed_ += u;
+    }
+    measureFreeSpace();
+
+    for (const auto& s : stats)
+    {
+        stats_.merge(s);
+    }
+    seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+json Checker::toJson() const
+{
+    const auto sizeLabels = sizeBucketLabels(sb_.blockSize);
+    json       sizes = json::object();
+    for (std::size_t i = 0; i < kSizeBuckets; ++i)
+    {
+        sizes[sizeLabels[i]] = stats_.sizeHist[i];
+    }
+    json fanout = json::object();
+    for (std::size_t i = 0; i < kFanoutBuckets; ++i)
+    {
+        fanout[kFanoutLabels[i]] = stats_.fanoutHist[i];
+    }
+
+    json problems = json::array();
+    for (const auto& [kind, k] : findings_.kinds())
+    {
+        problems.push_back({{"kind", kind},
+                            {"severity", k.severity == Severity::Error ? "error" : "warning"},
+                            {"count", k.count},
+                            {"examples", k.examples}});
+    }
+
+    const std::uint64_t freeBlocks = sb_.dataBlockCount - bitmapUsed_;
+    return {
+        {"layout", {
+            {"blockSize", sb_.blockSize},
+            {"totalBlocks", sb_.totalBlocks},
+            {"inodeTableStart", sb_.inodeTableStart},
+            {"inodeTableBlocks", sb_.inodeTableBlocks},
+            {"inodeCount", sb_.inodeCount},
+            {"inodeSize", diskSize_},
+            {"freeBitmapStart", sb_.freeBitmapStart},
+            {"freeBitmapBlocks", sb_.freeBitmapBlocks},
+            {"dataBlockStart", sb_.dataBlockStart},
+            {"dataBlockCount", sb_.dataBlockCount},
+            {"rootInodeId", sb_.rootInodeId},
+            {"features", sb_.features}
+        }},
+        {"image", {{"fileBytes", image_.fileBytes()}, {"allocatedBytes", image_.allocatedBytes()}}},
+        {"inodes", {
+            {"used", stats_.usedInodes},
+            {"total", sb_.inodeCount},
+            {"directories", stats_.directories},
+            {"files", stats_.files},
+            {"inlineFiles", stats_.inlineFiles}
+        }},
+        {"space", {
+            {"usedBlocks", bitmapUsed_},
+            {"freeBlocks", freeBlocks},
+            {"freeBytes", freeBlocks * sb_.blockSize},
+            {"fileBytes", stats_.fileBytes},
+            {"fileBlocks", stats_.fileBlocks},
+            {"directoryBlocks", stats_.dirBlocks},
+            {"freeRuns", freeRuns_},
+            {"largestFreeRun", largestFreeRun_}
+        }},
+        {"fragmentation", {
+            {"multiBlockFiles", stats_.multiBlockFiles},
+            {"fragmentedFiles", stats_.fragmentedFiles},
+            {"extents", stats_.extents}
+        }},
+        {"fileSizeHistogram", sizes},
+        {"directoryFanoutHistogram", fanout},
+        {"directoryEntries", stats_.dirEntries},
+        {"maxFanout", stats_.maxFanout},
+        {"errors", findings_.total(Severity::Error)},
+        {"warnings", findings_.total(Severity::Warning)},
+        {"problems", problems},
+        {"threads", threadsUsed_},
+        {"seconds", seconds_}
+    };
+}
+
+void Checker::print(std::ostream& os) const
+{
+    const auto& s = stats_;
+    const std::uint64_t freeBlocks = sb_.dataBlockCount - bitmapUsed_;
+    const auto pct = [](std::uint64_t a, std::uint64_t b) {
+        std::ostringstream o;
+        o << std::fixed << std::setprecision(1) << (b == 0 ? 0.0 : 100.0 * static_cast<double>(a) / static_cast<double>(b))
+          << '%';
+        return o.str();
+    };
+
+    os << "layout: block " << sb_.blockSize << " B, " << sb_.totalBlocks << " blocks ("
+       << humanBytes(static_cast<std::uint64_t>(sb_.totalBlocks) * sb_.blockSize) << "); inode table "
+       << sb_.inodeTableStart << "+" << sb_.inodeTableBlocks << " (" << sb_.inodeCount << " x " << diskSize_
+       << " B); bitmap " << sb_.freeBitmapStart << "+" << sb_.freeBitmapBlocks << "; data " << sb_.dataBlockStart
+       << "+" << sb_.dataBlockCount << '\n';
+    os << "image: " << humanBytes(image_.fileBytes()) << " on disk, " << humanBytes(image_.allocatedBytes())
+       << " allocated\n";
+    os << "inodes: " << s.usedInodes << " / " << sb_.inodeCount << " used (" << pct(s.usedInodes, sb_.inodeCount)
+       << "): " << s.directories << " directories, " << s.files << " files (" << s.inlineFiles << " inline)\n";
+    os << "data blocks: " << bitmapUsed_ << " used, " << freeBlocks << " free (" << pct(freeBlocks, sb_.dataBlockCount)
+       << ", " << humanBytes(freeBlocks * sb_.blockSize) << "); free runs: " << freeRuns_ << ", largest "
+       << largestFreeRun_ << " blocks\n";
+    os << "file data: " << humanBytes(s.fileBytes) << " in " << s.fileBlocks << " blocks; directories use "
+       << s.dirBlocks << " blocks\n";
+    os << "fragmentation: " << s.multiBlockFiles << " multi-block files, " << s.fragmentedFiles << " fragmented, "
+       << s.extents << " extents";
+    if (s.multiBlockFiles > 0)
+    {
+        os << " (" << std::fixed << std::setprecision(2)
+           << static_cast<double>(s.extents) / static_cast<double>(s.multiBlockFiles) << " per file)";
+    }
+    os << '\n';
+
+    const auto sizeLabels = sizeBucketLabels(sb_.blockSize);
+    os << "file sizes:";
+    for (std::size_t i = 0; i < kSizeBuckets; ++i)
+    {
+        os << "  " << sizeLabels[i] << ": " << s.sizeHist[i];
+    }
+    os << "\ndirectory fanout:";
+    for (std::size_t i = 0; i < kFanoutBuckets; ++i)
+    {
+        os << "  " << kFanoutLabels[i] << ": " << s.fanoutHist[i];
+    }
+    os << "  (max " << s.maxFanout << ")\n";
+
+    for (const auto& [kind, k] : findings_.kinds())
+    {
+        os << (k.severity == Severity::Error ? "ERROR " : "WARN  ") << kind << " (" << k.count << ")\n";
+        for (const auto& e : k.examples)
+        {
+            os << "      " << e << '\n';
+        }
+        if (k.count > k.examples.size())
+        {
+            os << "      ... " << (k.count - k.examples.size()) << " more\n";
+        }
+    }
+
+    const auto errors = findings_.total(Severity::Error);
+    const auto warnings = findings_.total(Severity::Warning);
+    os << (errors == 0 ? "result: clean" : "result: " + std::to_string(errors) + " errors") << ", " << warnings
+       << " warnings (checked in " << std::fixed << std::setprecision(1) << seconds_ * 1000.0 << " ms, threads: "
+       << threadsUsed_ << ")\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& opt)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+        try
+        {
+            if (arg == "--threads")
+            {
+                const char* v = next();
+                if (!v) return false;
+                opt.threads = static_cast<unsigned>(std::max(1ul, std::stoul(v)));
+            }
+            else if (arg == "--max-examples")
+            {
+                const char* v = next();
+                if (!v) return false;
+                opt.maxExamples = std::stoul(v);
+            }
+            else if (arg == "--json")
+            {
+                opt.jsonOutput = true;
+            }
+            else if (!arg.empty() && arg[0] != '-' && opt.imagePath.empty())
+            {
+                opt.imagePath = arg;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        catch (...)
+        {
+            return false;
+        }
+    }
+    return !opt.imagePath.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if (!parseOptions(argc, argv, opt))
+    {
+        std::cerr << "Usage: osproj_fsck <image> [--threads N] [--max-examples N] [--json]\n";
+        return 2;
+    }
+
+    Image image;
+    if (!image.open(opt.imagePath))
+    {
+        std::cerr << "osproj_fsck: cannot map image " << opt.imagePath << '\n';
+        return 2;
+    }
+
+    Findings findings(opt.maxExamples);
+    Checker  checker(image, opt, findings);
+    if (!checker.checkSuperBlock())
+    {
+        for (const auto& [kind, k] : findings.kinds())
+        {
+            for (const auto& e : k.examples)
+            {
+                std::cerr << "osproj_fsck: " << kind << ": " << e << '\n';
+            }
+        }
+        return 2;
+    }
+    image.setBlockSize(image.superBlock().blockSize);
+    checker.run();
+
+    if (opt.jsonOutput)
+    {
+        std::cout << checker.toJson().dump(2) << '\n';
+    }
+    else
+    {
+        checker.print(std::cout);
+    }
+    return findings.total(Severity::Error) == 0 ? 0 : 1;
+}
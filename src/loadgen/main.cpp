@@ -0,0 +1,580 @@
+// osproj_loadgen：通过真实 TCP 协议（TcpClient 长连接 + 长度前缀帧）对服务器施压的负载生成器。
+//
+// 用法：osproj_loadgen [--host 127.0.0.1] [--port 5555] [--sessions N] [--duration 秒] [--warmup 秒]
+//                      [--rate 每秒请求数] [--mix LIST_PAPERS=40,GET_PAPER=30,...] [--paper-bytes N]
+//                      [--author user:pwd] [--editor user:pwd] [--reviewer user:pwd] [--timeout-ms N] [--json]
+//
+// - 每个会话一条长连接，启动时分别以 author / editor / reviewer 登录，按 --mix 的权重随机选择命令。
+// - --rate 为 0（默认）时是闭环模式：每个会话收到响应后立即发下一条请求。
+// - --rate > 0 时是开环模式：总速率均分到各会话，请求按固定间隔“计划”发出；
+//   延迟从计划发送时刻开始计算，服务器变慢导致的排队时间也计入延迟，避免 coordinated omission。
+// - 延迟以微秒记录到 HDR 风格直方图，结束时输出每个命令及总体的分位数与吞吐。
+// - 服务器每条连接占用一个工作线程：会话数超过服务器线程池大小时，多出的会话会在超时后
+//   计为错误并重连，可据此观察线程池是否够用。
+
+#include "client/net/tcp_client.hpp"
+#include "common/latency_histogram.hpp"
+#include "common/protocol.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using json = osp::protocol::json;
+using clock_type = std::chrono::steady_clock;
+
+// 支持的命令（顺序即输出顺序）
+enum class Op
+{
+    Login,
+    ListPapers,
+    GetPaper,
+    Submit,
+    Review,
+    Assign,
+};
+
+constexpr Op kAllOps[] = {Op::Login, Op::ListPapers, Op::GetPaper, Op::Submit, Op::Review, Op::Assign};
+
+const char* opName(Op op)
+{
+    switch (op)
+    {
+    case Op::Login: return "LOGIN";
+    case Op::ListPapers: return "LIST_PAPERS";
+    case Op::GetPaper: return "GET_PAPER";
+    case Op::Submit: return "SUBMIT";
+    case Op::Review: return "REVIEW";
+    case Op::Assign: return "ASSIGN";
+    }
+    return "?";
+}
+
+struct Credentials
+{
+    std::string username;
+    std::string password;
+};
+
+struct Options
+{
+    std::string          host{"127.0.0.1"};
+    std::uint16_t        port{5555};
+    std::size_t          sessions{4};
+    double               durationSec{10};
+    double               warmupSec{1};
+    double               rate{0}; // 0 表示闭环
+    std::map<Op, double> mix{{Op::ListPapers, 40}, {Op::GetPaper, 35}, {Op::Submit, 5},
+                             {Op::Review, 10},     {Op::Assign, 5},    {Op::Login, 5}};
+    std::size_t          paperBytes{2048};
+    std::uint32_t        timeoutMs{5000};
+    Credentials          author{"author", "author"};
+    Credentials          editor{"editor", "editor"};
+    Credentials          reviewer{"reviewer", "reviewer"};
+    bool                 jsonOutput{false};
+};
+
+struct OpStats
+{
+    osp::LatencyHistogram latency; // 微秒
+    std::uint64_t         errors{0};
+};
+
+// 所有会话共享的论文 ID 池：GET_PAPER / ASSIGN 从 papers 中挑选，REVIEW 从 assigned 中挑选
+class PaperPool
+{
+public:
+    void addPaper(std::uint32_t id)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        papers_.push_back(id);
+    }
+
+    void addAssigned(std::uint32_t id)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        assigned_.push_back(id);
+    }
+
+    bool pickPaper(std::mt19937& rng, std::uint32_t& out) const { return pick(papers_, rng, out); }
+    bool pickAssigned(std::mt19937& rng, std::uint32_t& out) const { return pick(assigned_, rng, out); }
+
+private:
+    bool pick(const std::vector<std::uint32_t>& from, std::mt19937& rng, std::uint32_t& out) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (from.empty())
+        {
+            return false;
+        }
+        out = from[std::uniform_int_distribution<std::size_t>(0, from.size() - 1)(rng)];
+        return true;
+    }
+
+    mutable std::mutex         mutex_;
+    std::vector<std::uint32_t> papers_;
+    std::vector<std::uint32_t> assigned_;
+};
+
+class Session
+{
+public:
+    Session(const Options& opt, PaperPool& pool, std::size_t index)
+        : opt_(opt)
+        , pool_(pool)
+        , client_(opt.host, opt.port)
+        , rng_(static_cast<std::mt19937::result_type>(0x9e3779b9u * (index + 1)))
+        , index_(index)
+    {
+    }
+
+    bool start()
+    {
+        client_.setTimeout(std::chrono::milliseconds(opt_.timeoutMs));
+        broken_ = false;
+        const bool ok = client_.open() && login(opt_.author, authorSession_) && login(opt_.editor, editorSession_)
+                        && login(opt_.reviewer, reviewerSession_);
+        broken_ = !ok;
+        return ok;
+    }
+
+    // 执行一次 op，返回是否成功（ok == true）
+    bool execute(Op op)
+    {
+        if (broken_)
+        {
+            // 上一次请求超时或连接断开：迟到的响应会打乱请求/响应配对，只能重连并重新登录
+            client_.close();
+            if (!start())
+            {
+                return false;
+            }
+        }
+
+        switch (op)
+        {
+        case Op::Login:
+            return login(opt_.editor, editorSession_);
+        case Op::ListPapers:
+        {
+            auto resp = call("LIST_PAPERS", editorSession_);
+            if (!resp)
+            {
+                return false;
+            }
+            for (const auto& p : (*resp)["data"].value("papers", json::array()))
+            {
+                if (!knownPapersSeeded_)
+                {
+                    pool_.addPaper(p.value("id", 0u));
+                }
+            }
+            knownPapersSeeded_ = true;
+            return true;
+        }
+        case Op::GetPaper:
+        {
+            std::uint32_t pid{};
+            if (!pool_.pickPaper(rng_, pid))
+            {
+                return call("LIST_PAPERS", editorSession_).has_value();
+            }
+            // 只取第一页，与编辑页面的首屏加载一致
+            return call("GET_PAPER " + std::to_string(pid) + " 0 4096", editorSession_).has_value();
+        }
+        case Op::Submit:
+        {
+            const std::string title = "loadgen-" + std::to_string(index_) + "-" + std::to_string(++submitted_);
+            auto resp = call("SUBMIT " + title + " " + paperBody(), authorSession_);
+            if (!resp)
+            {
+                return false;
+            }
+            pool_.addPaper((*resp)["data"].value("paperId", 0u));
+            return true;
+        }
+        case Op::Assign:
+        {
+            std::uint32_t pid{};
+            if (!pool_.pickPaper(rng_, pid))
+            {
+                return false;
+            }
+            auto resp = call("ASSIGN " + std::to_string(pid) + " " + opt_.reviewer.username, editorSession_);
+            if (resp)
+            {
+                pool_.addAssigned(pid);
+            }
+            return resp.has_value();
+        }
+        case Op::Review:
+        {
+            std::uint32_t pid{};
+            if (!pool_.pickAssigned(rng_, pid))
+            {
+                return false;
+            }
+            return call("REVIEW " + std::to_string(pid) + " MINOR generated by osproj_loadgen", reviewerSession_)
+                .has_value();
+        }
+        }
+        return false;
+    }
+
+    [[nodiscard]] std::mt19937& rng() noexcept { return rng_; }
+
+private:
+    bool login(const Credentials& cred, std::string& outSession)
+    {
+        auto resp = call("LOGIN " + cred.username + " " + cred.password, {});
+        if (!resp)
+        {
+            return false;
+        }
+        outSession = (*resp)["data"].value("sessionId", "");
+        return !outSession.empty();
+    }
+
+    // 发送一条命令并等待响应；连接错误或 ok == false 时返回 std::nullopt
+    std::optional<json> call(const std::string& line, const std::string& sessionId)
+    {
+        auto cmd = osp::protocol::parseCommandLine(line);
+        cmd.sessionId = sessionId;
+
+        osp::protocol::Message req;
+        req.type = osp::protocol::MessageType::CommandRequest;
+        req.payload = osp::protocol::commandToJson(cmd);
+
+        if (!client_.send(req))
+        {
+            broken_ = true;
+            return std::nullopt;
+        }
+        auto resp = client_.receive();
+        if (!resp)
+        {
+            broken_ = true;
+            return std::nullopt;
+        }
+        if (!resp->payload.value("ok", false))
+        {
+            return std::nullopt;
+        }
+        return resp->payload;
+    }
+
+    std::string paperBody()
+    {
+        static const char kWords[][8] = {"cache", "block", "inode", "vfs", "lock", "paper", "review", "latency"};
+        std::string body;
+        body.reserve(opt_.paperBytes + 8);
+        while (body.size() < opt_.paperBytes)
+        {
+            body += kWords[std::uniform_int_distribution<int>(0, 7)(rng_)];
+            body += ' ';
+        }
+        return body;
+    }
+
+    const Options&       opt_;
+    PaperPool&           pool_;
+    osp::net::TcpClient  client_;
+    std::mt19937         rng_;
+    std::size_t          index_;
+    std::string          authorSession_;
+    std::string          editorSession_;
+    std::string          reviewerSession_;
+    std::uint64_t        submitted_{0};
+    bool                 knownPapersSeeded_{false};
+    bool                 broken_{false};
+};
+
+struct WorkerResult
+{
+    std::map<Op, OpStats> stats;
+    bool                  connected{false};
+};
+
+void runWorker(const Options& opt, PaperPool& pool, std::size_t index, clock_type::time_point start,
+               clock_type::time_point measureFrom, clock_type::time_point end, WorkerResult& out)
+{
+    // 连接或登录失败时仍按计划参与，由 execute() 重连，失败计入 errors
+    Session session(opt, pool, index);
+    out.connected = session.start();
+    if (out.connected)
+    {
+        session.execute(Op::ListPapers); // 预取论文 ID
+    }
+
+    std::vector<Op>     ops;
+    std::vector<double> weights;
+    for (const auto& [op, w] : opt.mix)
+    {
+        if (w > 0)
+        {
+            ops.push_back(op);
+            weights.push_back(w);
+        }
+    }
+    if (ops.empty())
+    {
+        return;
+    }
+    std::discrete_distribution<std::size_t> pickOp(weights.begin(), weights.end());
+
+    // 开环：每个会话的发送间隔为 sessions / rate，各会话错开起点
+    const bool openLoop = opt.rate > 0;
+    const auto interval = openLoop ? std::chrono::duration_cast<clock_type::duration>(
+                                         std::chrono::duration<double>(static_cast<double>(opt.sessions) / opt.rate))
+                                   : clock_type::duration::zero();
+    clock_type::time_point intended = start + interval * index / std::max<std::size_t>(opt.sessions, 1);
+
+    while (true)
+    {
+        if (openLoop)
+        {
+            if (intended >= end)
+            {
+                break;
+            }
+            std::this_thread::sleep_until(intended);
+        }
+        else if (clock_type::now() >= end)
+        {
+            break;
+        }
+
+        const Op   op = ops[pickOp(session.rng())];
+        const auto sendAt = openLoop ? intended : clock_type::now();
+        const bool ok = session.execute(op);
+        const auto doneAt = clock_type::now();
+
+        if (sendAt >= measureFrom)
+        {
+            auto& st = out.stats[op];
+            st.latency.record(static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(doneAt - sendAt).count()));
+            if (!ok)
+            {
+                ++st.errors;
+            }
+        }
+
+        intended += interval;
+    }
+}
+
+bool parseMix(const std::string& spec, std::map<Op, double>& out)
+{
+    std::map<Op, double> mix;
+    std::size_t          pos = 0;
+    while (pos < spec.size())
+    {
+        const auto comma = spec.find(',', pos);
+        const auto item = spec.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        pos = (comma == std::string::npos) ? spec.size() : comma + 1;
+
+        const auto eq = item.find('=');
+        if (eq == std::string::npos)
+        {
+            return false;
+        }
+        const auto name = item.substr(0, eq);
+        bool       found = false;
+        for (Op op : kAllOps)
+        {
+            if (name == opName(op))
+            {
+                mix[op] = std::stod(item.substr(eq + 1));
+                found = true;
+            }
+        }
+        if (!found)
+        {
+            return false;
+        }
+    }
+    out = std::move(mix);
+    return !out.empty();
+}
+
+bool parseCredentials(const char* s, Credentials& out)
+{
+    const std::string v{s};
+    const auto        colon = v.find(':');
+    if (colon == std::string::npos)
+    {
+        return false;
+    }
+    out.username = v.substr(0, colon);
+    out.password = v.substr(colon + 1);
+    return true;
+}
+
+bool parseOptions(int argc, char** argv, Options& opt)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--json")
+        {
+            opt.jsonOutput = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+        const char* v = argv[++i];
+        try
+        {
+            if (arg == "--host") opt.host = v;
+            else if (arg == "--port") opt.port = static_cast<std::uint16_t>(std::stoul(v));
+            else if (arg == "--sessions") opt.sessions = std::max<std::size_t>(1, std::stoul(v));
+            else if (arg == "--duration") opt.durationSec = std::stod(v);
+            else if (arg == "--warmup") opt.warmupSec = std::stod(v);
+            else if (arg == "--rate") opt.rate = std::stod(v);
+            else if (arg == "--paper-bytes") opt.paperBytes = std::stoul(v);
+            else if (arg == "--timeout-ms") opt.timeoutMs = static_cast<std::uint32_t>(std::stoul(v));
+            else if (arg == "--mix") { if (!parseMix(v, opt.mix)) return false; }
+            else if (arg == "--author") { if (!parseCredentials(v, opt.author)) return false; }
+            else if (arg == "--editor") { if (!parseCredentials(v, opt.editor)) return false; }
+            else if (arg == "--reviewer") { if (!parseCredentials(v, opt.reviewer)) return false; }
+            else return false;
+        }
+        catch (...)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+json histogramJson(const OpStats& st)
+{
+    const auto& h = st.latency;
+    return {
+        {"count", h.count()},
+        {"errors", st.errors},
+        {"meanUs", h.mean()},
+        {"minUs", h.min()},
+        {"p50Us", h.percentile(50)},
+        {"p90Us", h.percentile(90)},
+        {"p99Us", h.percentile(99)},
+        {"p999Us", h.percentile(99.9)},
+        {"maxUs", h.max()}
+    };
+}
+
+void printRow(const std::string& name, const OpStats& st)
+{
+    const auto& h = st.latency;
+    std::cout << std::left << std::setw(14) << name << std::right << std::setw(10) << h.count() << std::setw(8)
+              << st.errors << std::setw(10) << h.percentile(50) << std::setw(10) << h.percentile(90)
+              << std::setw(10) << h.percentile(99) << std::setw(10) << h.percentile(99.9) << std::setw(10)
+              << h.max() << '\n';
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if (!parseOptions(argc, argv, opt))
+    {
+        std::cerr << "Usage: osproj_loadgen [--host H] [--port P] [--sessions N] [--duration S] [--warmup S]\n"
+                     "                      [--rate OPS_PER_SEC] [--mix LIST_PAPERS=40,GET_PAPER=35,...]\n"
+                     "                      [--paper-bytes N] [--author u:p] [--editor u:p] [--reviewer u:p]\n"
+                     "                      [--timeout-ms N] [--json]\n";
+        return 2;
+    }
+
+    // TcpClient 的连接错误日志会刷屏，统计里已有 errors 计数
+    std::clog.rdbuf(nullptr);
+
+    PaperPool                 pool;
+    std::vector<WorkerResult> results(opt.sessions);
+    std::vector<std::thread>  workers;
+
+    const auto start = clock_type::now() + std::chrono::milliseconds(100);
+    const auto measureFrom = start + std::chrono::duration_cast<clock_type::duration>(
+                                         std::chrono::duration<double>(opt.warmupSec));
+    const auto end = measureFrom + std::chrono::duration_cast<clock_type::duration>(
+                                       std::chrono::duration<double>(opt.durationSec));
+
+    for (std::size_t i = 0; i < opt.sessions; ++i)
+    {
+        workers.emplace_back(runWorker, std::cref(opt), std::ref(pool), i, start, measureFrom, end,
+                             std::ref(results[i]));
+    }
+    for (auto& t : workers)
+    {
+        t.join();
+    }
+
+    // 合并各会话的直方图
+    std::map<Op, OpStats> merged;
+    OpStats               total;
+    std::size_t           connected = 0;
+    for (const auto& r : results)
+    {
+        connected += r.connected ? 1 : 0;
+        for (const auto& [op, st] : r.stats)
+        {
+            merged[op].latency.merge(st.latency);
+            merged[op].errors += st.errors;
+            total.latency.merge(st.latency);
+            total.errors += st.errors;
+        }
+    }
+    const double throughput = opt.durationSec > 0 ? static_cast<double>(total.latency.count()) / opt.durationSec : 0;
+
+    if (opt.jsonOutput)
+    {
+        json commands = json::object();
+        for (const auto& [op, st] : merged)
+        {
+            commands[opName(op)] = histogramJson(st);
+        }
+        json report = {
+            {"mode", opt.rate > 0 ? "open" : "closed"},
+            {"sessions", opt.sessions},
+            {"connectedSessions", connected},
+            {"durationSec", opt.durationSec},
+            {"targetRate", opt.rate},
+            {"throughput", throughput},
+            {"overall", histogramJson(total)},
+            {"commands", commands}
+        };
+        std::cout << report.dump(2) << '\n';
+    }
+    else
+    {
+        std::cout << (opt.rate > 0 ? "open loop, target " + std::to_string(opt.rate) + " req/s" : std::string("closed loop"))
+                  << ", " << connected << "/" << opt.sessions << " sessions connected, " << opt.durationSec
+                  << " s measured\n";
+        std::cout << std::left << std::setw(14) << "command" << std::right << std::setw(10) << "count"
+                  << std::setw(8) << "errors" << std::setw(10) << "p50(us)" << std::setw(10) << "p90"
+                  << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(10) << "max" << '\n';
+        for (const auto& [op, st] : merged)
+        {
+            printRow(opName(op), st);
+        }
+        printRow("TOTAL", total);
+        std::cout << "throughput: " << std::fixed << std::setprecision(1) << throughput << " req/s\n";
+    }
+
+    return connected == 0 ? 1 : 0;
+}
@@ -0,0 +1,104 @@
+#include "server/events/event_feed.hpp"
+
+#include <algorithm>
+
+namespace osp::server
+{
+
+EventFeed::EventFeed(std::size_t capacity)
+    : capacity_(std::max<std::size_t>(capacity, 1))
+    , ring_(capacity_)
+{
+}
+
+std::uint64_t EventFeed::publish(std::string type, osp::protocol::json data, std::vector<UserId> audience)
+{
+    const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch());
+
+    std::uint64_t seq{};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        seq = ++lastSeq_;
+
+        FeedEvent& slot = ring_[seq % capacity_];
+        slot.seq = seq;
+        slot.type = std::move(type);
+        slot.timestampMs = now.count();
+        slot.audience = std::move(audience);
+        slot.data = std::move(data);
+    }
+    cv_.notify_all();
+    return seq;
+}
+
+std::vector<FeedEvent> EventFeed::since(std::uint64_t afterSeq, bool& truncated) const
+{
+    std::vector<FeedEvent> out;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    truncated = false;
+    if (afterSeq >= lastSeq_)
+    {
+        return out;
+    }
+
+    // 缓冲区中最旧的事件序号
+    const std::uint64_t oldest = (lastSeq_ >= capacity_) ? lastSeq_ - capacity_ + 1 : 1;
+    std::uint64_t       from = afterSeq + 1;
+    if (from < oldest)
+    {
+        truncated = true;
+        from = oldest;
+    }
+
+    out.reserve(static_cast<std::size_t>(lastSeq_ - from + 1));
+    for (std::uint64_t s = from; s <= lastSeq_; ++s)
+    {
+        out.push_back(ring_[s % capacity_]);
+    }
+    return out;
+}
+
+std::uint64_t EventFeed::waitNewer(std::uint64_t afterSeq, std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait_for(lock, timeout, [&] { return closed_ || lastSeq_ > afterSeq; });
+    return lastSeq_;
+}
+
+std::uint64_t EventFeed::lastSeq() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lastSeq_;
+}
+
+void EventFeed::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    cv_.notify_all();
+}
+
+bool EventFeed::visibleTo(const FeedEvent& e, Role role, UserId userId)
+{
+    if (role == Role::Admin || role == Role::Editor)
+    {
+        return true;
+    }
+    return std::find(e.audience.begin(), e.audience.end(), userId) != e.audience.end();
+}
+
+osp::protocol::json EventFeed::toJson(const FeedEvent& e)
+{
+    return {
+        {"seq", e.seq},
+        {"type", e.type},
+        {"timestampMs", e.timestampMs},
+        {"data", e.data}
+    };
+}
+
+} // namespace osp::server
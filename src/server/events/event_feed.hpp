@@ -0,0 +1,64 @@
+#pragma once
+
+#include "common/protocol.hpp"
+#include "common/types.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace osp::server
+{
+
+// 一条业务变更事件（论文提交、分配审稿人、提交评审、最终决定等）
+struct FeedEvent
+{
+    std::uint64_t       seq{};          // 单调递增序号，从 1 开始
+    std::string         type;           // 例如 PaperSubmitted / ReviewerAssigned
+    std::int64_t        timestampMs{};  // 产生时间（Unix 毫秒）
+    std::vector<UserId> audience;       // 除 Editor/Admin 外，哪些用户可以看到该事件
+    osp::protocol::json data;
+};
+
+// 内存中的变更事件环形缓冲区：
+// - ServerApp 的写命令在成功后 publish() 一条事件；
+// - WATCH 推送线程通过 waitNewer() 阻塞等待新事件，再用 since() 取出增量；
+// - 缓冲区满时覆盖最旧的事件，since() 通过 truncated 告知调用方有事件丢失。
+class EventFeed
+{
+public:
+    explicit EventFeed(std::size_t capacity = 256);
+
+    std::uint64_t publish(std::string type, osp::protocol::json data, std::vector<UserId> audience);
+
+    // 取出所有 seq > afterSeq 的事件（按 seq 升序）
+    std::vector<FeedEvent> since(std::uint64_t afterSeq, bool& truncated) const;
+
+    // 阻塞直到出现 seq > afterSeq 的事件、超时或 close()；返回当前最新 seq
+    std::uint64_t waitNewer(std::uint64_t afterSeq, std::chrono::milliseconds timeout);
+
+    [[nodiscard]] std::uint64_t lastSeq() const;
+
+    // 唤醒所有等待者（服务器关闭时使用）
+    void close();
+
+    // 判断某个会话是否可以看到该事件
+    static bool visibleTo(const FeedEvent& e, Role role, UserId userId);
+
+    static osp::protocol::json toJson(const FeedEvent& e);
+
+private:
+    std::size_t            capacity_;
+    std::vector<FeedEvent> ring_;        // 大小固定为 capacity_，按 seq % capacity_ 存放
+    std::uint64_t          lastSeq_{0};
+    bool                   closed_{false};
+
+    mutable std::mutex      mutex_;
+    std::condition_variable cv_;
+};
+
+} // namespace osp::server
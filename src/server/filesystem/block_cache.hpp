@@ -2,8 +2,12 @@
 
 #include "common/logger.hpp"
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <list>
+#include <optional>
+#include <string_view>
 #include <utility>
 #include <unordered_map>
 #include <vector>
@@ -11,26 +15,95 @@
 namespace osp::fs
 {
 
-// 非持久化简化版 LRU 块缓存；后续可接入真实磁盘文件。
+// 解析字节数："4096" / "64K" / "512M" / "2G"（后缀大小写不敏感，可带 "B"/"iB"，按 1024 进位），非法时返回 std::nullopt
+inline std::optional<std::size_t> parseByteSize(std::string_view s)
+{
+    std::size_t i = 0;
+    std::size_t value = 0;
+    while (i < s.size() && s[i] >= '0' && s[i] <= '9')
+    {
+        const std::size_t next = value * 10 + static_cast<std::size_t>(s[i] - '0');
+        if (next / 10 != value)
+        {
+            return std::nullopt;
+        }
+        value = next;
+        ++i;
+    }
+    if (i == 0)
+    {
+        return std::nullopt;
+    }
+
+    std::size_t shift = 0;
+    if (i < s.size())
+    {
+        switch (s[i] | 0x20)
+        {
+        case 'k': shift = 10; break;
+        case 'm': shift = 20; break;
+        case 'g': shift = 30; break;
+        case 't': shift = 40; break;
+        case 'b': break;
+        default: return std::nullopt;
+        }
+        ++i;
+        std::string_view rest = s.substr(i);
+        if (!rest.empty() && (rest[0] | 0x20) == 'i') rest.remove_prefix(1);
+        if (!rest.empty() && (rest[0] | 0x20) == 'b') rest.remove_prefix(1);
+        if (!rest.empty())
+        {
+            return std::nullopt;
+        }
+    }
+    if (shift > 0 && value > (static_cast<std::size_t>(-1) >> shift))
+    {
+        return std::nullopt;
+    }
+    return value << shift;
+}
+
+// 非持久化简化版 LRU 块缓存，容量按字节预算计（每项计入数据大小与 kEntryOverhead）。
+// 预算可在线调整（resize 立即淘汰到新预算以内），也可开启自动调节：
+// 被淘汰的块号保留在“影子”列表中（只存块号，长度为当前项数的 1/4），
+// 未命中却命中影子列表说明缓存再大 1/4 就能命中，tune() 据此估算扩容的边际收益。
 class BlockCache
 {
 public:
+    // 每项除数据外的额外开销估计：哈希表节点、LRU 链表节点与 vector 头部
+    static constexpr std::size_t kEntryOverhead = 96;
+
+    static constexpr std::size_t entryCost(std::size_t dataBytes) noexcept { return dataBytes + kEntryOverhead; }
+
     struct Stats
     {
         std::size_t hits{0};
         std::size_t misses{0};
-        std::size_t replacements{0}; // evictions
+        std::size_t replacements{0}; // evictions（含 resize 缩容时的淘汰）
         std::size_t entries{0};
-        std::size_t capacity{0};
+        std::size_t bytes{0};         // 当前占用（含每项开销）
+        std::size_t capacityBytes{0}; // 当前预算
+        std::size_t ghostHits{0};     // 未命中但命中影子列表的次数
+        std::size_t resizes{0};       // 预算变更次数（手动与自动）
     };
 
-    explicit BlockCache(std::size_t capacity)
-        : capacity_(capacity)
+    // 自动调节：在 [minBytes, maxBytes] 内按影子命中率扩容，内存紧张时缩容
+    struct AutoTune
+    {
+        bool        enabled{false};
+        std::size_t minBytes{0};
+        std::size_t maxBytes{0};
+    };
+
+    explicit BlockCache(std::size_t capacityBytes)
+        : capacityBytes_(capacityBytes)
     {
     }
 
-    [[nodiscard]] std::size_t capacity() const noexcept { return capacity_; }
+    [[nodiscard]] std::size_t capacityBytes() const noexcept { return capacityBytes_; }
+    [[nodiscard]] std::size_t bytes() const noexcept { return bytes_; }
     [[nodiscard]] std::size_t size() const noexcept { return map_.size(); }
+    [[nodiscard]] const AutoTune& autoTune() const noexcept { return autoTune_; }
 
     [[nodiscard]] Stats stats() const noexcept
     {
@@ -39,20 +112,113 @@ public:
         s.misses = misses_;
         s.replacements = replacements_;
         s.entries = map_.size();
-        s.capacity = capacity_;
+        s.bytes = bytes_;
+        s.capacityBytes = capacityBytes_;
+        s.ghostHits = ghostHits_;
+        s.resizes = resizes_;
         return s;
     }
 
+    // 缓存中的块号，最近使用的在前，最多 n 个（用于保存预热集合）
+    [[nodiscard]] std::vector<std::size_t> hottest(std::size_t n) const
+    {
+        std::vector<std::size_t> ids;
+        ids.reserve(std::min(n, lru_.size()));
+        for (auto it = lru_.begin(); it != lru_.end() && ids.size() < n; ++it)
+        {
+            ids.push_back(*it);
+        }
+        return ids;
+    }
+
     void resetStats() noexcept
     {
         hits_ = 0;
         misses_ = 0;
         replacements_ = 0;
+        ghostHits_ = 0;
+        window_ = {};
+    }
+
+    // 丢弃全部缓存项与影子列表（预算与自动调节设置保留）
+    void clear()
+    {
+        lru_.clear();
+        map_.clear();
+        ghostLru_.clear();
+        ghostMap_.clear();
+        bytes_ = 0;
+        resetStats();
+    }
+
+    // 调整预算；缩小时立即从 LRU 尾部淘汰到预算以内。0 表示关闭缓存
+    void resize(std::size_t capacityBytes)
+    {
+        if (capacityBytes == capacityBytes_)
+        {
+            return;
+        }
+        capacityBytes_ = capacityBytes;
+        ++resizes_;
+        evictTo(capacityBytes_);
+        trimGhosts();
+    }
+
+    void setAutoTune(std::size_t minBytes, std::size_t maxBytes)
+    {
+        autoTune_.enabled = true;
+        autoTune_.minBytes = std::min(minBytes, maxBytes);
+        autoTune_.maxBytes = std::max(minBytes, maxBytes);
+        window_ = {hits_, misses_, ghostHits_, replacements_};
+        resize(std::clamp(capacityBytes_, autoTune_.minBytes, autoTune_.maxBytes));
+    }
+
+    void disableAutoTune() noexcept { autoTune_.enabled = false; }
+
+    // 自动调节的一步，由后台线程定期调用。统计窗口为上次调用以来的访问：
+    // - memoryPressure 为真时缩小 1/4（不低于 minBytes）；
+    // - 否则窗口内有淘汰、且影子命中占访问的 1% 以上时扩大 1/4（不超过 maxBytes）。
+    // 预算有变化时返回新预算
+    std::optional<std::size_t> tune(bool memoryPressure)
+    {
+        if (!autoTune_.enabled)
+        {
+            return std::nullopt;
+        }
+
+        const Window now{hits_, misses_, ghostHits_, replacements_};
+        const std::size_t accesses = (now.hits - window_.hits) + (now.misses - window_.misses);
+        const std::size_t ghostHits = now.ghostHits - window_.ghostHits;
+        const std::size_t evictions = now.replacements - window_.replacements;
+
+        std::size_t target = capacityBytes_;
+        if (memoryPressure)
+        {
+            target = std::max(autoTune_.minBytes, capacityBytes_ - capacityBytes_ / 4);
+        }
+        else if (accesses < kMinTuneAccesses)
+        {
+            // 访问太少，继续累积窗口
+            return std::nullopt;
+        }
+        else if (evictions > 0 && ghostHits * 100 >= accesses)
+        {
+            const std::size_t step = std::max(capacityBytes_ / 4, kMinTuneStep);
+            target = std::min(autoTune_.maxBytes, capacityBytes_ + step);
+        }
+        window_ = {hits_, misses_, ghostHits_, replacements_};
+
+        if (target == capacityBytes_)
+        {
+            return std::nullopt;
+        }
+        resize(target);
+        return target;
     }
 
     std::vector<std::byte> get(std::size_t blockId, bool& hit)
     {
-        if (capacity_ == 0)
+        if (capacityBytes_ == 0)
         {
             hit = false;
             ++misses_;
@@ -64,7 +230,14 @@ public:
         {
             hit = false;
             ++misses_;
-            osp::log(osp::LogLevel::Debug, "BlockCache miss");
+            auto ghost = ghostMap_.find(blockId);
+            if (ghost != ghostMap_.end())
+            {
+                ++ghostHits_;
+                ghostLru_.erase(ghost->second);
+                ghostMap_.erase(ghost);
+            }
+            OSP_LOG(osp::LogLevel::Debug, "BlockCache miss");
             return {};
         }
 
@@ -72,58 +245,118 @@ public:
         lru_.splice(lru_.begin(), lru_, it->second.lruIt);
         hit = true;
         ++hits_;
-        osp::log(osp::LogLevel::Debug, "BlockCache hit");
+        OSP_LOG(osp::LogLevel::Debug, "BlockCache hit");
         return it->second.data;
     }
 
     void put(std::size_t blockId, std::vector<std::byte> data)
     {
-        if (capacity_ == 0)
+        if (capacityBytes_ == 0)
         {
             // cache disabled
             return;
         }
 
+        const std::size_t cost = entryCost(data.size());
         auto it = map_.find(blockId);
         if (it != map_.end())
         {
+            bytes_ = bytes_ - entryCost(it->second.data.size()) + cost;
             it->second.data = std::move(data);
             lru_.splice(lru_.begin(), lru_, it->second.lruIt);
+            evictTo(capacityBytes_);
             return;
         }
-
-        if (map_.size() >= capacity_ && !lru_.empty())
+        if (cost > capacityBytes_)
         {
-            auto victim = lru_.back();
-            lru_.pop_back();
-            map_.erase(victim);
-            ++replacements_;
-            osp::log(osp::LogLevel::Debug, "BlockCache evict");
+            return;
         }
 
+        evictTo(capacityBytes_ - cost);
+
         lru_.push_front(blockId);
         Entry e;
         e.data = std::move(data);
         e.lruIt = lru_.begin();
         map_.emplace(blockId, std::move(e));
+        bytes_ += cost;
     }
 
 private:
+    static constexpr std::size_t kMinTuneAccesses = 256;     // 窗口内访问少于此数时不做决定
+    static constexpr std::size_t kMinTuneStep = 1024 * 1024; // 扩容的最小步长
+    static constexpr std::size_t kMinGhosts = 16;
+
     struct Entry
     {
         std::vector<std::byte> data;
         std::list<std::size_t>::iterator lruIt;
     };
 
-    std::size_t capacity_;
+    struct Window
+    {
+        std::size_t hits{0};
+        std::size_t misses{0};
+        std::size_t ghostHits{0};
+        std::size_t replacements{0};
+    };
+
+    // 从 LRU 尾部淘汰，直到占用不超过 limit；被淘汰的块号进入影子列表
+    void evictTo(std::size_t limit)
+    {
+        while (bytes_ > limit && !lru_.empty())
+        {
+            auto victim = lru_.back();
+            lru_.pop_back();
+            auto it = map_.find(victim);
+            bytes_ -= entryCost(it->second.data.size());
+            map_.erase(it);
+            ++replacements_;
+            rememberGhost(victim);
+            OSP_LOG(osp::LogLevel::Debug, "BlockCache evict");
+        }
+    }
+
+    [[nodiscard]] std::size_t ghostCapacity() const noexcept { return std::max(map_.size() / 4, kMinGhosts); }
+
+    void rememberGhost(std::size_t blockId)
+    {
+        if (ghostMap_.count(blockId) != 0)
+        {
+            return;
+        }
+        ghostLru_.push_front(blockId);
+        ghostMap_.emplace(blockId, ghostLru_.begin());
+        trimGhosts();
+    }
+
+    void trimGhosts()
+    {
+        const std::size_t limit = ghostCapacity();
+        while (ghostMap_.size() > limit)
+        {
+            ghostMap_.erase(ghostLru_.back());
+            ghostLru_.pop_back();
+        }
+    }
+
+    std::size_t capacityBytes_;
+    std::size_t bytes_{0};
     std::list<std::size_t> lru_;
     std::unordered_map<std::size_t, Entry> map_;
 
+    // 影子列表：最近被淘汰的块号（新的在前）
+    std::list<std::size_t> ghostLru_;
+    std::unordered_map<std::size_t, std::list<std::size_t>::iterator> ghostMap_;
+
+    AutoTune autoTune_;
+    Window   window_;
+
     std::size_t hits_{0};
     std::size_t misses_{0};
     std::size_t replacements_{0};
+    std::size_t ghostHits_{0};
+    std::size_t resizes_{0};
 };
 
 } // namespace osp::fs
-
-
@@ -0,0 +1,313 @@
+#include "block_device.hpp"
+
+#include "common/logger.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace osp::fs
+{
+namespace
+{
+constexpr std::size_t kAlign = AlignedBufferPool::kAlignment;
+
+constexpr std::uint64_t alignDown(std::uint64_t v) noexcept
+{
+    return v & ~static_cast<std::uint64_t>(kAlign - 1);
+}
+
+constexpr std::size_t alignUp(std::size_t v) noexcept
+{
+    return (v + kAlign - 1) & ~(kAlign - 1);
+}
+
+bool isAligned(std::uint64_t offset, const void* p, std::size_t len) noexcept
+{
+    return offset % kAlign == 0 && len % kAlign == 0 && reinterpret_cast<std::uintptr_t>(p) % kAlign == 0;
+}
+} // namespace
+
+// ------------ AlignedBufferPool ------------
+
+AlignedBufferPool::AlignedBufferPool(std::size_t bufferBytes, std::size_t maxIdle)
+    : bufferBytes_(alignUp(std::max<std::size_t>(bufferBytes, kAlignment)))
+    , maxIdle_(maxIdle)
+{
+}
+
+AlignedBufferPool::Lease AlignedBufferPool::acquire()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty())
+        {
+            std::byte* p = idle_.back().release();
+            idle_.pop_back();
+            ++stats_.reuses;
+            return Lease(*this, p);
+        }
+        ++stats_.allocations;
+    }
+    void* p = std::aligned_alloc(kAlignment, bufferBytes_);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return Lease(*this, static_cast<std::byte*>(p));
+}
+
+void AlignedBufferPool::release(std::byte* data)
+{
+    Buffer buffer(data);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (idle_.size() < maxIdle_)
+    {
+        idle_.push_back(std::move(buffer));
+    }
+}
+
+AlignedBufferPool::Stats AlignedBufferPool::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+// ------------ BlockDevice ------------
+
+bool BlockDevice::open(const std::string& path, bool direct)
+{
+    close();
+    std::lock_guard<std::mutex> lock(fdMutex_);
+    constexpr int kFlags = O_RDWR | O_CREAT | O_CLOEXEC;
+
+#if defined(O_DIRECT)
+    if (direct)
+    {
+        fd_ = ::open(path.c_str(), kFlags | O_DIRECT, 0644);
+        if (fd_ >= 0)
+        {
+            // 有的文件系统允许带 O_DIRECT 打开，但读写时才报 EINVAL；先做一次对齐读探测
+            auto probe = pool_.acquire();
+            if (::pread(fd_, probe.data(), kAlign, 0) >= 0)
+            {
+                direct_ = true;
+                return true;
+            }
+            ::close(fd_);
+            fd_ = -1;
+        }
+        OSP_LOG(osp::LogLevel::Warn, "BlockDevice: O_DIRECT not supported for " + path + " (" +
+                                         std::strerror(errno) + "), falling back to buffered IO");
+    }
+#else
+    if (direct)
+    {
+        OSP_LOG(osp::LogLevel::Warn, "BlockDevice: O_DIRECT not available on this platform, using buffered IO");
+    }
+#endif
+
+    fd_ = ::open(path.c_str(), kFlags, 0644);
+    direct_ = false;
+    return fd_ >= 0;
+}
+
+void BlockDevice::close()
+{
+    std::lock_guard<std::mutex> lock(fdMutex_);
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    direct_ = false;
+}
+
+std::optional<std::size_t> BlockDevice::preadFull(std::uint64_t offset, void* dst, std::size_t len)
+{
+    auto*       out = static_cast<char*>(dst);
+    std::size_t done = 0;
+    while (done < len)
+    {
+        const ssize_t n = ::pread(fd_, out + done, len - done, static_cast<off_t>(offset + done));
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return std::nullopt;
+        }
+        if (n == 0)
+        {
+            break;
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    return done;
+}
+
+bool BlockDevice::pwriteFull(std::uint64_t offset, const void* src, std::size_t len)
+{
+    const auto* in = static_cast<const char*>(src);
+    std::size_t done = 0;
+    while (done < len)
+    {
+        const ssize_t n = ::pwrite(fd_, in + done, len - done, static_cast<off_t>(offset + done));
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+bool BlockDevice::read(std::uint64_t offset, void* dst, std::size_t len, std::size_t* filled)
+{
+    if (fd_ < 0)
+    {
+        return false;
+    }
+    auto* out = static_cast<std::byte*>(dst);
+
+    if (!direct_ || isAligned(offset, dst, len))
+    {
+        const auto got = preadFull(offset, dst, len);
+        if (!got)
+        {
+            return false;
+        }
+        std::memset(out + *got, 0, len - *got);
+        if (filled != nullptr) *filled = *got;
+        return true;
+    }
+
+    // 经对齐缓冲区中转：每次读取覆盖 [pos, pos + take) 的对齐区间
+    auto        buffer = pool_.acquire();
+    std::size_t done = 0;
+    std::size_t fromFile = 0;
+    bool        eof = false;
+    while (done < len)
+    {
+        const std::uint64_t pos = offset + done;
+        const std::uint64_t start = alignDown(pos);
+        const auto          skip = static_cast<std::size_t>(pos - start);
+        const std::size_t   take = std::min(len - done, buffer.size() - skip);
+        const std::size_t   span = alignUp(skip + take);
+
+        std::size_t got = 0;
+        if (!eof)
+        {
+            const auto n = preadFull(start, buffer.data(), span);
+            if (!n)
+            {
+                return false;
+            }
+            got = *n;
+            eof = got < span;
+        }
+        const std::size_t avail = got > skip ? std::min(got - skip, take) : 0;
+        std::memcpy(out + done, buffer.data() + skip, avail);
+        std::memset(out + done + avail, 0, take - avail);
+        fromFile += avail;
+        done += take;
+    }
+    if (filled != nullptr) *filled = fromFile;
+    return true;
+}
+
+bool BlockDevice::write(std::uint64_t offset, const void* src, std::size_t len)
+{
+    if (fd_ < 0)
+    {
+        return false;
+    }
+    if (!direct_ || isAligned(offset, src, len))
+    {
+        return pwriteFull(offset, src, len);
+    }
+
+    // 经对齐缓冲区中转；首尾不完整的对齐块先读出再覆盖（读-改-写），因此文件可能被补齐到对齐边界
+    const auto* in = static_cast<const std::byte*>(src);
+    auto        buffer = pool_.acquire();
+    std::size_t done = 0;
+    while (done < len)
+    {
+        const std::uint64_t pos = offset + done;
+        const std::uint64_t start = alignDown(pos);
+        const auto          skip = static_cast<std::size_t>(pos - start);
+        const std::size_t   take = std::min(len - done, buffer.size() - skip);
+        const std::size_t   span = alignUp(skip + take);
+
+        if (skip != 0 || take != span)
+        {
+            const auto got = preadFull(start, buffer.data(), span);
+            if (!got)
+            {
+                return false;
+            }
+            std::memset(buffer.data() + *got, 0, span - *got);
+        }
+        std::memcpy(buffer.data() + skip, in + done, take);
+        if (!pwriteFull(start, buffer.data(), span))
+        {
+            return false;
+        }
+        done += take;
+    }
+    return true;
+}
+
+std::optional<std::uint64_t> BlockDevice::size() const
+{
+    struct stat st{};
+    if (fd_ < 0 || ::fstat(fd_, &st) != 0)
+    {
+        return std::nullopt;
+    }
+    return static_cast<std::uint64_t>(st.st_size);
+}
+
+bool BlockDevice::truncate(std::uint64_t bytes)
+{
+    return fd_ >= 0 && ::ftruncate(fd_, static_cast<off_t>(bytes)) == 0;
+}
+
+bool BlockDevice::sync()
+{
+    std::lock_guard<std::mutex> lock(fdMutex_);
+    if (fd_ < 0)
+    {
+        return false;
+    }
+#if defined(__APPLE__)
+    return ::fsync(fd_) == 0;
+#else
+    return ::fdatasync(fd_) == 0;
+#endif
+}
+
+bool BlockDevice::punchHole(std::uint64_t offset, std::uint64_t len)
+{
+#if defined(__linux__) && defined(FALLOC_FL_PUNCH_HOLE)
+    return fd_ >= 0 &&
+           ::fallocate(fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, static_cast<off_t>(offset),
+                       static_cast<off_t>(len)) == 0;
+#else
+    (void)offset;
+    (void)len;
+    return false;
+#endif
+}
+
+} // namespace osp::fs
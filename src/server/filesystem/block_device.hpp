@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace osp::fs
+{
+
+// 按 kAlignment 对齐的 IO 缓冲区池：O_DIRECT 要求用户缓冲区、偏移和长度都按设备逻辑块对齐，
+// 而缓存中的块是普通的 std::vector，因此读写都经由池中的缓冲区中转。归还的缓冲区最多保留 maxIdle 个。
+class AlignedBufferPool
+{
+public:
+    static constexpr std::size_t kAlignment = 4096;
+
+    struct Stats
+    {
+        std::uint64_t allocations{0}; // 新分配的缓冲区数
+        std::uint64_t reuses{0};      // 从池中复用的次数
+    };
+
+    AlignedBufferPool(std::size_t bufferBytes, std::size_t maxIdle);
+
+    class Lease
+    {
+    public:
+        Lease(AlignedBufferPool& pool, std::byte* data)
+            : pool_(&pool)
+            , data_(data)
+        {
+        }
+        ~Lease() { pool_->release(data_); }
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        [[nodiscard]] std::byte* data() const noexcept { return data_; }
+        [[nodiscard]] std::size_t size() const noexcept { return pool_->bufferBytes_; }
+
+    private:
+        AlignedBufferPool* pool_;
+        std::byte*         data_;
+    };
+
+    // 池空时直接分配新缓冲区，不会阻塞
+    [[nodiscard]] Lease acquire();
+
+    [[nodiscard]] std::size_t bufferBytes() const noexcept { return bufferBytes_; }
+    [[nodiscard]] Stats stats() const;
+
+private:
+    struct FreeDeleter
+    {
+        void operator()(std::byte* p) const noexcept { std::free(p); }
+    };
+    using Buffer = std::unique_ptr<std::byte, FreeDeleter>;
+
+    void release(std::byte* data);
+
+    const std::size_t   bufferBytes_;
+    const std::size_t   maxIdle_;
+    mutable std::mutex  mutex_;
+    std::vector<Buffer> idle_;
+    Stats               stats_;
+};
+
+// backing file 的读写接口（pread / pwrite），可选 O_DIRECT 模式绕过内核页缓存：
+// 这样 BlockCache 是唯一的一层缓存，其缺失数即真实的设备读次数。
+// 直接 IO 模式下不对齐的读写经由 AlignedBufferPool 中转，不对齐的写按所在的对齐区间读-改-写。
+class BlockDevice
+{
+public:
+    BlockDevice() = default;
+    ~BlockDevice() { close(); }
+
+    BlockDevice(const BlockDevice&) = delete;
+    BlockDevice& operator=(const BlockDevice&) = delete;
+
+    // 以读写方式打开（不存在则创建）。direct 为 true 但文件系统不支持 O_DIRECT（如 tmpfs）时回退为普通 IO，
+    // 通过 direct() 查看实际模式
+    bool open(const std::string& path, bool direct);
+    void close();
+
+    [[nodiscard]] bool isOpen() const noexcept { return fd_ >= 0; }
+    [[nodiscard]] bool direct() const noexcept { return direct_; }
+    [[nodiscard]] int fd() const noexcept { return fd_; }
+
+    // 读 [offset, offset + len)，文件末尾之后的部分填 0；filled 返回实际从文件读到的字节数。IO 错误时返回 false
+    bool read(std::uint64_t offset, void* dst, std::size_t len, std::size_t* filled = nullptr);
+    bool write(std::uint64_t offset, const void* src, std::size_t len);
+
+    [[nodiscard]] std::optional<std::uint64_t> size() const;
+    bool truncate(std::uint64_t bytes);
+
+    // fdatasync：把已写入的数据（及读回数据所需的元数据，如文件大小）刷到存储设备。
+    // 可以在其它线程读写的同时调用，与 open / close 之间由内部的锁互斥
+    bool sync();
+
+    // 释放 [offset, offset + len) 的磁盘空间（Linux fallocate PUNCH_HOLE，文件大小不变）；不支持时返回 false
+    bool punchHole(std::uint64_t offset, std::uint64_t len);
+
+    [[nodiscard]] AlignedBufferPool::Stats poolStats() const { return pool_.stats(); }
+
+private:
+    static constexpr std::size_t kPoolBufferBytes = 256 * 1024; // 64 个 4 KiB 块，足够一次合并预取的一段
+    static constexpr std::size_t kPoolMaxIdle = 4;
+
+    // 循环 pread 直到读满或到达文件末尾，返回读到的字节数；出错返回 std::nullopt
+    std::optional<std::size_t> preadFull(std::uint64_t offset, void* dst, std::size_t len);
+    bool pwriteFull(std::uint64_t offset, const void* src, std::size_t len);
+
+    int               fd_{-1};
+    bool              direct_{false};
+    std::mutex        fdMutex_; // 只保护 sync() 与 open / close 之间对 fd_ 的并发访问
+    AlignedBufferPool pool_{kPoolBufferBytes, kPoolMaxIdle};
+};
+
+} // namespace osp::fs
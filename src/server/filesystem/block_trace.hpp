@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace osp::fs
+{
+
+// 块访问追踪文件格式（由 Vfs 录制，osproj_cachesim 离线回放）：
+// [0..7]   魔数 "OSPBTRC1"
+// [8..11]  blockSize（uint32，本机字节序）
+// [12..15] totalBlocks（uint32）
+// [16..]   每次访问 4 字节：低 31 位为块号，最高位为 1 表示写（写回缓存），0 表示读（查缓存）
+constexpr char          kBlockTraceMagic[8] = {'O', 'S', 'P', 'B', 'T', 'R', 'C', '1'};
+constexpr std::uint32_t kBlockTraceWriteBit = 1u << 31;
+
+struct BlockTrace
+{
+    std::uint32_t              blockSize{0};
+    std::uint32_t              totalBlocks{0};
+    std::vector<std::uint32_t> records;
+};
+
+// 追加写入追踪记录；记录先攒在内存里，满 kFlushRecords 条再写文件。调用方负责同步（Vfs 内由 Vfs 锁保护）
+class BlockTraceWriter
+{
+public:
+    static constexpr std::size_t kFlushRecords = 16384;
+
+    BlockTraceWriter() = default;
+    ~BlockTraceWriter() { close(); }
+
+    BlockTraceWriter(const BlockTraceWriter&) = delete;
+    BlockTraceWriter& operator=(const BlockTraceWriter&) = delete;
+
+    bool open(const std::string& path, std::uint32_t blockSize, std::uint32_t totalBlocks)
+    {
+        close();
+        out_.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out_.is_open())
+        {
+            return false;
+        }
+        out_.write(kBlockTraceMagic, sizeof(kBlockTraceMagic));
+        out_.write(reinterpret_cast<const char*>(&blockSize), sizeof(blockSize));
+        out_.write(reinterpret_cast<const char*>(&totalBlocks), sizeof(totalBlocks));
+        records_ = 0;
+        buffer_.reserve(kFlushRecords);
+        return static_cast<bool>(out_);
+    }
+
+    [[nodiscard]] bool isOpen() const noexcept { return out_.is_open(); }
+    [[nodiscard]] std::uint64_t records() const noexcept { return records_; }
+
+    void record(std::uint32_t blockId, bool write)
+    {
+        buffer_.push_back((blockId & ~kBlockTraceWriteBit) | (write ? kBlockTraceWriteBit : 0u));
+        ++records_;
+        if (buffer_.size() >= kFlushRecords)
+        {
+            flush();
+        }
+    }
+
+    // 关闭并返回是否全部写入成功
+    bool close()
+    {
+        if (!out_.is_open())
+        {
+            return true;
+        }
+        flush();
+        const bool ok = static_cast<bool>(out_);
+        out_.close();
+        return ok;
+    }
+
+private:
+    void flush()
+    {
+        if (!buffer_.empty())
+        {
+            out_.write(reinterpret_cast<const char*>(buffer_.data()),
+                       static_cast<std::streamsize>(buffer_.size() * sizeof(std::uint32_t)));
+            buffer_.clear();
+        }
+        out_.flush();
+    }
+
+    std::ofstream              out_;
+    std::vector<std::uint32_t> buffer_;
+    std::uint64_t              records_{0};
+};
+
+// 读取整个追踪文件；格式不符时返回 std::nullopt（末尾不完整的记录被忽略）
+inline std::optional<BlockTrace> readBlockTrace(const std::string& path)
+{
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in.is_open())
+    {
+        return std::nullopt;
+    }
+
+    char magic[sizeof(kBlockTraceMagic)]{};
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, kBlockTraceMagic, sizeof(magic)) != 0)
+    {
+        return std::nullopt;
+    }
+
+    BlockTrace trace;
+    in.read(reinterpret_cast<char*>(&trace.blockSize), sizeof(trace.blockSize));
+    in.read(reinterpret_cast<char*>(&trace.totalBlocks), sizeof(trace.totalBlocks));
+    if (!in)
+    {
+        return std::nullopt;
+    }
+
+    std::uint32_t rec = 0;
+    while (in.read(reinterpret_cast<char*>(&rec), sizeof(rec)))
+    {
+        trace.records.push_back(rec);
+    }
+    return trace;
+}
+
+} // namespace osp::fs
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace osp::fs
+{
+
+// 目录项中记录的文件类型（readdir 无需再读取子 inode 即可区分文件与目录）
+enum class FileType : std::uint8_t
+{
+    Unknown = 0,   // 旧版目录项（该字节原本是 name 的结尾 '\0'），需要回退到读取 inode
+    File = 1,
+    Directory = 2,
+};
+
+// 磁盘上的目录项：固定 64 字节，目录数据块就是该结构的顺序数组。
+// 旧版布局为 {inodeId; char name[60]}，name 总以 '\0' 结尾，
+// 因此把最后一个字节用作 type 后，旧目录项的 type 自然读出为 Unknown。
+struct DirEntry
+{
+    std::uint32_t inodeId{};             // 0 表示空槽
+    char          name[59]{};            // UTF-8 名称，最长 58 字节，不足时以 '\0' 结尾
+    FileType      type{FileType::Unknown};
+
+    [[nodiscard]] std::string_view nameView() const noexcept
+    {
+        return {name, ::strnlen(name, sizeof(name))};
+    }
+
+    void setName(const std::string& n) noexcept
+    {
+        std::memset(name, 0, sizeof(name));
+        std::memcpy(name, n.data(), std::min(n.size(), sizeof(name) - 1));
+    }
+};
+
+static_assert(sizeof(DirEntry) == 64, "DirEntry must stay 64 bytes on disk");
+
+} // namespace osp::fs
@@ -0,0 +1,208 @@
+#include "group_commit.hpp"
+
+#include "common/logger.hpp"
+
+#include <algorithm>
+#include <string>
+
+namespace osp::fs
+{
+
+const char* durabilityModeName(DurabilityMode mode) noexcept
+{
+    switch (mode)
+    {
+    case DurabilityMode::Async: return "async";
+    case DurabilityMode::Sync: return "sync";
+    case DurabilityMode::Group: return "group";
+    }
+    return "";
+}
+
+std::optional<DurabilityConfig> parseDurability(std::string_view s)
+{
+    std::string lower;
+    for (char c : s)
+    {
+        lower += static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+    }
+
+    DurabilityConfig config;
+    if (lower == "async")
+    {
+        config.mode = DurabilityMode::Async;
+        return config;
+    }
+    if (lower == "sync")
+    {
+        config.mode = DurabilityMode::Sync;
+        return config;
+    }
+    if (lower.rfind("group", 0) != 0)
+    {
+        return std::nullopt;
+    }
+
+    config.mode = DurabilityMode::Group;
+    std::string rest = lower.substr(5);
+    try
+    {
+        if (!rest.empty())
+        {
+            if (rest[0] != ':')
+            {
+                return std::nullopt;
+            }
+            rest.erase(0, 1);
+            const auto colon = rest.find(':');
+            config.intervalMs = static_cast<std::uint32_t>(std::stoul(rest.substr(0, colon)));
+            if (colon != std::string::npos)
+            {
+                config.maxBatch = static_cast<std::uint32_t>(std::max<unsigned long>(std::stoul(rest.substr(colon + 1)), 1));
+            }
+        }
+    }
+    catch (...)
+    {
+        return std::nullopt;
+    }
+    return config;
+}
+
+GroupCommit::GroupCommit(SyncFn sync)
+    : sync_(std::move(sync))
+{
+}
+
+GroupCommit::~GroupCommit()
+{
+    stop();
+}
+
+void GroupCommit::start()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (config_.mode != DurabilityMode::Group || thread_.joinable())
+    {
+        return;
+    }
+    stop_ = false;
+    running_ = true;
+    thread_ = std::thread([this] { syncLoop(); });
+}
+
+void GroupCommit::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!thread_.joinable())
+        {
+            return;
+        }
+        stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+bool GroupCommit::runSync()
+{
+    const auto start = std::chrono::steady_clock::now();
+    const bool ok = sync_();
+    const auto nanos = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.syncs;
+    stats_.syncNanos += nanos;
+    stats_.maxSyncNanos = std::max(stats_.maxSyncNanos, nanos);
+    if (!ok)
+    {
+        ++stats_.failedSyncs;
+    }
+    return ok;
+}
+
+bool GroupCommit::waitDurable()
+{
+    if (config_.mode == DurabilityMode::Async)
+    {
+        return true;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++stats_.commits;
+    if (config_.mode == DurabilityMode::Sync || !running_)
+    {
+        lock.unlock();
+        const bool ok = runSync();
+        lock.lock();
+        stats_.maxBatch = std::max<std::uint64_t>(stats_.maxBatch, 1);
+        stats_.waitNanos += static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        return ok;
+    }
+
+    if (requested_ == taken_)
+    {
+        pendingSince_ = start;
+    }
+    const std::uint64_t ticket = ++requested_;
+    wake_.notify_one();
+    done_.wait(lock, [&] { return durable_ >= ticket; });
+    stats_.waitNanos += static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    return ticket > failedThrough_;
+}
+
+void GroupCommit::syncLoop()
+{
+    const auto interval = std::chrono::milliseconds(config_.intervalMs);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        wake_.wait(lock, [&] { return stop_ || requested_ > taken_; });
+        if (requested_ == taken_)
+        {
+            // stop_ 且没有等待者；在锁内清除 running_，之后登记的命令由调用方自己同步
+            running_ = false;
+            break;
+        }
+
+        // 攒批：等到组内第一条命令登记满 interval，或等待数达到 maxBatch（停止时不再等）
+        wake_.wait_until(lock, pendingSince_ + interval,
+                         [&] { return stop_ || requested_ - taken_ >= config_.maxBatch; });
+
+        const std::uint64_t target = requested_;
+        const std::uint64_t batch = target - taken_;
+        taken_ = target;
+        lock.unlock();
+        const bool ok = runSync();
+        lock.lock();
+
+        stats_.maxBatch = std::max(stats_.maxBatch, batch);
+        if (!ok)
+        {
+            failedThrough_ = target;
+            OSP_LOG(osp::LogLevel::Error, "GroupCommit: sync failed, " + std::to_string(batch) +
+                                              " commands not durable");
+        }
+        durable_ = target;
+        // 同步期间登记的命令组成下一组；它们已经等了一次同步的时间，下一组立即开始，不再额外等待 interval
+        if (requested_ > taken_)
+        {
+            pendingSince_ = std::chrono::steady_clock::now() - interval;
+        }
+        done_.notify_all();
+    }
+}
+
+GroupCommit::Stats GroupCommit::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace osp::fs
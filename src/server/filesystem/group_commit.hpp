@@ -0,0 +1,102 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+
+namespace osp::fs
+{
+
+// 写入的持久化级别：
+// - Async：不主动 fdatasync，由内核择机回写（掉电可能丢失已确认的写入）；
+// - Sync：每条写命令在应答前各自 fdatasync 一次；
+// - Group：组提交。各工作线程的写命令登记后等待，后台线程每 intervalMs 毫秒或凑满 maxBatch 条时
+//   做一次 fdatasync，覆盖这期间登记的全部命令，完成后统一唤醒。
+enum class DurabilityMode
+{
+    Async,
+    Sync,
+    Group
+};
+
+struct DurabilityConfig
+{
+    DurabilityMode mode{DurabilityMode::Async};
+    std::uint32_t  intervalMs{2};  // Group：组内第一条命令登记后最多再等多久
+    std::uint32_t  maxBatch{32};   // Group：等待的命令达到此数时立即同步
+};
+
+const char* durabilityModeName(DurabilityMode mode) noexcept;
+
+// 解析 "async" / "sync" / "group[:<intervalMs>[:<maxBatch>]]"（大小写不敏感），非法时返回 std::nullopt
+std::optional<DurabilityConfig> parseDurability(std::string_view s);
+
+// 组提交：把多个线程的“等待落盘”合并成一次 sync 调用。
+// 每条写命令登记时领取递增的序号，后台线程每次同步前记下当时最大的序号，同步完成后
+// 所有序号不超过它的命令都已落盘（它们的写入都发生在登记之前，也就发生在这次同步开始之前）。
+class GroupCommit
+{
+public:
+    using SyncFn = std::function<bool()>;
+
+    struct Stats
+    {
+        std::uint64_t commits{0};       // 等待过落盘的写命令数
+        std::uint64_t syncs{0};         // sync 调用次数
+        std::uint64_t failedSyncs{0};
+        std::uint64_t maxBatch{0};      // 单次 sync 覆盖的最多命令数
+        std::uint64_t syncNanos{0};     // sync 调用累计耗时
+        std::uint64_t maxSyncNanos{0};
+        std::uint64_t waitNanos{0};     // 命令等待落盘的累计时间
+    };
+
+    explicit GroupCommit(SyncFn sync);
+    ~GroupCommit();
+
+    GroupCommit(const GroupCommit&) = delete;
+    GroupCommit& operator=(const GroupCommit&) = delete;
+
+    // 需在 start() 之前调用
+    void configure(const DurabilityConfig& config) { config_ = config; }
+    [[nodiscard]] const DurabilityConfig& config() const noexcept { return config_; }
+
+    // Group 模式下启动后台同步线程；其它模式为空操作
+    void start();
+    // 同步剩余的登记后停止后台线程；之后的 waitDurable 退化为调用方自己同步
+    void stop();
+
+    // 写命令应答前调用（调用方不能持有会阻塞 sync 的锁）：阻塞直到本线程此前的写入已落盘。
+    // sync 失败时返回 false；Async 模式立即返回 true
+    bool waitDurable();
+
+    [[nodiscard]] Stats stats() const;
+
+private:
+    bool runSync();
+    void syncLoop();
+
+    SyncFn           sync_;
+    DurabilityConfig config_;
+
+    mutable std::mutex      mutex_;
+    std::condition_variable wake_; // 唤醒同步线程
+    std::condition_variable done_; // 唤醒等待者
+    std::thread             thread_;
+    bool                    running_{false};
+    bool                    stop_{false};
+
+    std::uint64_t                         requested_{0};     // 已发出的最大序号
+    std::uint64_t                         taken_{0};         // 已被某次同步覆盖（进行中或已完成）的最大序号
+    std::uint64_t                         durable_{0};       // 已完成同步的最大序号
+    std::uint64_t                         failedThrough_{0}; // 最近一次失败的同步覆盖到的序号
+    std::chrono::steady_clock::time_point pendingSince_{};   // 当前组第一条命令的登记时间
+
+    Stats stats_;
+};
+
+} // namespace osp::fs
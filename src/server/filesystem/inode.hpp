@@ -1,24 +1,124 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 namespace osp::fs
 {
 
+// Inode::flags 的取值
+constexpr std::uint8_t kInodeFlagUsed = 1u << 0;   // inode 已被分配
+constexpr std::uint8_t kInodeFlagInline = 1u << 1; // 文件内容直接存放在 inlineData 中，不占用数据块
+
 // 简化版 inode 结构：
 // - 本实现仅使用少量直接块指针，不实现间接块，以便代码保持清晰。
-// - 磁盘上的 inode 表就是该结构的顺序数组。
+// - 小文件（不超过 InlineCapacity 字节）的内容直接内联在 inode 中，读取时只需访问 inode 所在的块。
+// - 磁盘上的 inode 表是定长记录的顺序数组，记录长度由 SuperBlock::inodeSize 决定，
+//   读写时通过 decodeInode / encodeInode 按字段编解码（不再直接 memcpy 结构体）。
 struct Inode
 {
     std::uint32_t id{};              // inode 编号（在 inode 表中的索引）
     bool          isDirectory{false};
+    std::uint8_t  flags{0};          // kInodeFlag*
     std::uint32_t size{0};           // 文件大小（字节）
 
     // 直接数据块指针，支持小文件即可满足课程实验需求
     static constexpr std::size_t MaxDirectBlocks = 8;
     std::uint32_t directBlocks[MaxDirectBlocks]{};
+
+    std::uint32_t mtime{0};          // 最后修改时间（Unix 秒），旧版布局中恒为 0
+
+    // 内联数据区（仅当 flags 含 kInodeFlagInline 时有效，此时 directBlocks 全为 0）
+    static constexpr std::size_t InlineCapacity = 80;
+    char inlineData[InlineCapacity]{};
+
+    [[nodiscard]] bool isUsed() const noexcept { return (flags & kInodeFlagUsed) != 0; }
+    [[nodiscard]] bool isInline() const noexcept { return (flags & kInodeFlagInline) != 0; }
 };
 
-} // namespace osp::fs
+// 磁盘上 inode 记录的布局版本：
+// - v1（SuperBlock::inodeSize == 0）：44 字节，即早期直接 memcpy 的结构体布局
+//     [0] id  [4] isDirectory(1 字节 + 3 字节填充)  [8] size  [12] directBlocks[8]
+// - v2（48 字节）：在 v1 之后追加 [44] mtime
+// - 当前版本（128 字节）：[5] flags，[48, 128) 为内联数据区
+// v1/v2 没有 flags 字段，解码时按“有数据块、是目录或大小非 0”推断 inode 是否在用。
+constexpr std::uint32_t kLegacyInodeDiskSize = 44;
+constexpr std::uint32_t kInodeDiskSizeV2 = 48;
+constexpr std::uint32_t kInodeDiskSize = 128;
+
+// SuperBlock::inodeSize 为 0 表示 v1 镜像
+inline std::uint32_t inodeDiskSize(std::uint32_t sbInodeSize)
+{
+    return sbInodeSize == 0 ? kLegacyInodeDiskSize : sbInodeSize;
+}
+
+namespace detail
+{
+inline std::uint32_t loadU32(const std::byte* p)
+{
+    std::uint32_t v{};
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline void storeU32(std::byte* p, std::uint32_t v)
+{
+    std::memcpy(p, &v, sizeof(v));
+}
+} // namespace detail
+
+// 从 diskSize 字节的记录中解码 inode
+inline void decodeInode(const std::byte* p, std::uint32_t diskSize, Inode& out)
+{
+    out = Inode{};
+    out.id = detail::loadU32(p + 0);
+    out.isDirectory = static_cast<std::uint8_t>(p[4]) != 0;
+    out.size = detail::loadU32(p + 8);
+    for (std::size_t i = 0; i < Inode::MaxDirectBlocks; ++i)
+    {
+        out.directBlocks[i] = detail::loadU32(p + 12 + 4 * i);
+    }
+    if (diskSize >= kInodeDiskSizeV2)
+    {
+        out.mtime = detail::loadU32(p + 44);
+    }
 
+    if (diskSize >= kInodeDiskSize)
+    {
+        out.flags = static_cast<std::uint8_t>(p[5]);
+        std::memcpy(out.inlineData, p + 48, Inode::InlineCapacity);
+        return;
+    }
 
+    bool used = out.isDirectory || out.size != 0;
+    for (std::size_t i = 0; i < Inode::MaxDirectBlocks && !used; ++i)
+    {
+        used = out.directBlocks[i] != 0;
+    }
+    out.flags = used ? kInodeFlagUsed : 0;
+}
+
+// 把 inode 编码为 diskSize 字节的记录（填充字节清零）；旧版布局无法表示 flags 与内联数据
+inline void encodeInode(const Inode& in, std::uint32_t diskSize, std::byte* p)
+{
+    std::memset(p, 0, diskSize);
+    detail::storeU32(p + 0, in.id);
+    p[4] = static_cast<std::byte>(in.isDirectory ? 1 : 0);
+    detail::storeU32(p + 8, in.size);
+    for (std::size_t i = 0; i < Inode::MaxDirectBlocks; ++i)
+    {
+        detail::storeU32(p + 12 + 4 * i, in.directBlocks[i]);
+    }
+    if (diskSize >= kInodeDiskSizeV2)
+    {
+        detail::storeU32(p + 44, in.mtime);
+    }
+    if (diskSize >= kInodeDiskSize)
+    {
+        p[5] = static_cast<std::byte>(in.flags);
+        std::memcpy(p + 48, in.inlineData, Inode::InlineCapacity);
+    }
+}
+
+} // namespace osp::fs
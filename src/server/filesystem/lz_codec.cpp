@@ -0,0 +1,173 @@
+#include "lz_codec.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace osp::fs
+{
+namespace
+{
+constexpr std::size_t kMinMatch = 4;
+constexpr std::size_t kMaxOffset = 65535;
+constexpr unsigned    kHashBits = 12;
+
+std::uint32_t read32(const char* p) noexcept
+{
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+std::uint32_t hash4(std::uint32_t v) noexcept
+{
+    return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+void putLength(std::string& out, std::size_t len)
+{
+    while (len >= 255)
+    {
+        out.push_back(static_cast<char>(255));
+        len -= 255;
+    }
+    out.push_back(static_cast<char>(len));
+}
+
+void putSequence(std::string& out, std::string_view literals, std::size_t offset, std::size_t matchLen)
+{
+    const std::size_t litCode = literals.size() < 15 ? literals.size() : 15;
+    const std::size_t matchCode = matchLen == 0 ? 0 : (matchLen - kMinMatch < 15 ? matchLen - kMinMatch : 15);
+    out.push_back(static_cast<char>((litCode << 4) | matchCode));
+    if (litCode == 15)
+    {
+        putLength(out, literals.size() - 15);
+    }
+    out.append(literals);
+    if (matchLen == 0)
+    {
+        return;
+    }
+    out.push_back(static_cast<char>(offset & 0xff));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (matchCode == 15)
+    {
+        putLength(out, matchLen - kMinMatch - 15);
+    }
+}
+
+// 读取扩展长度；越界时返回 false
+bool getLength(std::string_view in, std::size_t& pos, std::size_t& len)
+{
+    while (true)
+    {
+        if (pos >= in.size())
+        {
+            return false;
+        }
+        const auto b = static_cast<unsigned char>(in[pos++]);
+        len += b;
+        if (b != 255)
+        {
+            return true;
+        }
+    }
+}
+} // namespace
+
+std::string lzCompress(std::string_view input)
+{
+    std::string out;
+    out.reserve(input.size() / 2 + 16);
+
+    const char*                n = input.data();
+    const std::size_t          size = input.size();
+    std::vector<std::uint32_t> table(1u << kHashBits, 0); // 位置 + 1，0 表示空
+
+    std::size_t anchor = 0;
+    std::size_t pos = 0;
+    while (pos + kMinMatch <= size)
+    {
+        const std::uint32_t v = read32(n + pos);
+        const std::uint32_t h = hash4(v);
+        const std::size_t   candidate = table[h];
+        table[h] = static_cast<std::uint32_t>(pos + 1);
+
+        if (candidate == 0 || pos - (candidate - 1) > kMaxOffset || read32(n + candidate - 1) != v)
+        {
+            ++pos;
+            continue;
+        }
+
+        const std::size_t ref = candidate - 1;
+        std::size_t       len = kMinMatch;
+        while (pos + len < size && n[ref + len] == n[pos + len])
+        {
+            ++len;
+        }
+        putSequence(out, input.substr(anchor, pos - anchor), pos - ref, len);
+        pos += len;
+        anchor = pos;
+    }
+    putSequence(out, input.substr(anchor), 0, 0);
+    return out;
+}
+
+std::optional<std::string> lzDecompress(std::string_view input, std::size_t rawSize)
+{
+    std::string out;
+    out.reserve(rawSize);
+
+    std::size_t pos = 0;
+    while (pos < input.size())
+    {
+        const auto  token = static_cast<unsigned char>(input[pos++]);
+        std::size_t litLen = token >> 4;
+        if (litLen == 15 && !getLength(input, pos, litLen))
+        {
+            return std::nullopt;
+        }
+        if (litLen > input.size() - pos || out.size() + litLen > rawSize)
+        {
+            return std::nullopt;
+        }
+        out.append(input.substr(pos, litLen));
+        pos += litLen;
+        if (pos == input.size())
+        {
+            break;
+        }
+
+        if (input.size() - pos < 2)
+        {
+            return std::nullopt;
+        }
+        const std::size_t offset = static_cast<unsigned char>(input[pos]) |
+                                   (static_cast<std::size_t>(static_cast<unsigned char>(input[pos + 1])) << 8);
+        pos += 2;
+        std::size_t matchLen = token & 0x0f;
+        if (matchLen == 15 && !getLength(input, pos, matchLen))
+        {
+            return std::nullopt;
+        }
+        matchLen += kMinMatch;
+        if (offset == 0 || offset > out.size() || out.size() + matchLen > rawSize)
+        {
+            return std::nullopt;
+        }
+        // 回溯距离可能小于匹配长度（重复模式），逐字节复制
+        const std::size_t from = out.size() - offset;
+        for (std::size_t i = 0; i < matchLen; ++i)
+        {
+            out.push_back(out[from + i]);
+        }
+    }
+
+    if (out.size() != rawSize)
+    {
+        return std::nullopt;
+    }
+    return out;
+}
+
+} // namespace osp::fs
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace osp::fs
+{
+
+// 简单的 LZ77 字节流压缩（格式与 LZ4 block 类似，不依赖外部库），用于冷数据归档包。
+// 序列 = token（高 4 位字面量长度，低 4 位匹配长度 - 4；取 15 时后接若干 255 累加的扩展字节）
+//      + 字面量 + 2 字节小端回溯距离 + 匹配长度扩展字节；最后一个序列只有字面量。
+std::string lzCompress(std::string_view input);
+
+// 解压；数据损坏或解压后的长度不等于 rawSize 时返回 std::nullopt
+std::optional<std::string> lzDecompress(std::string_view input, std::size_t rawSize);
+
+} // namespace osp::fs
@@ -0,0 +1,346 @@
+#include "pack_file.hpp"
+
+#include "lz_codec.hpp"
+
+#include "common/logger.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace osp::fs
+{
+namespace
+{
+constexpr char          kPackMagic[8] = {'O', 'S', 'P', 'P', 'A', 'C', 'K', '1'};
+constexpr std::uint32_t kPackVersion = 1;
+constexpr std::size_t   kHeaderBytes = 32;
+constexpr std::size_t   kIndexFixedBytes = 2 + 1 + 1 + 4 + 4 + 8 + 4; // 每项除路径外的字节数
+
+constexpr std::uint8_t kFlagRoot = 1u << 0;
+constexpr std::uint8_t kFlagCompressed = 1u << 1;
+
+template <typename T>
+void put(std::string& out, T v)
+{
+    char buf[sizeof(T)];
+    std::memcpy(buf, &v, sizeof(T));
+    out.append(buf, sizeof(T));
+}
+
+template <typename T>
+T get(const char* p)
+{
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    return v;
+}
+
+bool writeAll(int fd, const std::string& bytes)
+{
+    std::size_t done = 0;
+    while (done < bytes.size())
+    {
+        const ssize_t n = ::write(fd, bytes.data() + done, bytes.size() - done);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+} // namespace
+
+std::string PackFile::normalize(std::string_view path)
+{
+    std::string out;
+    std::size_t pos = 0;
+    while (pos < path.size())
+    {
+        const auto slash = path.find('/', pos);
+        const auto end = slash == std::string_view::npos ? path.size() : slash;
+        if (end > pos)
+        {
+            out += '/';
+            out.append(path.substr(pos, end - pos));
+        }
+        pos = end + 1;
+    }
+    return out.empty() ? "/" : out;
+}
+
+bool PackFile::open(const std::string& path)
+{
+    close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < kHeaderBytes)
+    {
+        ::close(fd);
+        OSP_LOG(osp::LogLevel::Warn, "PackFile: " + path + " is too short");
+        return false;
+    }
+    const auto bytes = static_cast<std::size_t>(st.st_size);
+    void*      p = ::mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // 映射建立后不再需要文件描述符
+    if (p == MAP_FAILED)
+    {
+        OSP_LOG(osp::LogLevel::Warn, "PackFile: cannot mmap " + path + ": " + std::strerror(errno));
+        return false;
+    }
+    data_ = static_cast<const char*>(p);
+    fileBytes_ = bytes;
+
+    auto fail = [&](const std::string& why) {
+        OSP_LOG(osp::LogLevel::Warn, "PackFile: " + path + ": " + why);
+        close();
+        return false;
+    };
+
+    if (std::memcmp(data_, kPackMagic, sizeof(kPackMagic)) != 0 || get<std::uint32_t>(data_ + 8) != kPackVersion)
+    {
+        return fail("bad magic or version");
+    }
+    const auto count = get<std::uint32_t>(data_ + 12);
+    const auto indexOffset = get<std::uint64_t>(data_ + 16);
+    const auto indexBytes = get<std::uint64_t>(data_ + 24);
+    if (indexOffset < kHeaderBytes || indexOffset > fileBytes_ || indexBytes > fileBytes_ - indexOffset)
+    {
+        return fail("index out of range");
+    }
+
+    entries_.reserve(count);
+    const char* q = data_ + indexOffset;
+    const char* end = q + indexBytes;
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        if (static_cast<std::size_t>(end - q) < kIndexFixedBytes)
+        {
+            return fail("truncated index");
+        }
+        const auto pathLen = get<std::uint16_t>(q);
+        if (static_cast<std::size_t>(end - q) < kIndexFixedBytes + pathLen)
+        {
+            return fail("truncated index");
+        }
+        Entry e;
+        e.path = std::string_view(q + 2, pathLen);
+        q += 2 + pathLen;
+        e.type = static_cast<FileType>(get<std::uint8_t>(q));
+        const auto flags = get<std::uint8_t>(q + 1);
+        e.root = (flags & kFlagRoot) != 0;
+        e.compressed = (flags & kFlagCompressed) != 0;
+        e.mtime = get<std::uint32_t>(q + 2);
+        e.size = get<std::uint32_t>(q + 6);
+        e.offset = get<std::uint64_t>(q + 10);
+        e.storedSize = get<std::uint32_t>(q + 18);
+        q += kIndexFixedBytes - 2;
+        if (e.offset > indexOffset || e.storedSize > indexOffset - e.offset ||
+            (!entries_.empty() && !(entries_.back().path < e.path)))
+        {
+            return fail("corrupt index entry " + std::string(e.path));
+        }
+        entries_.push_back(e);
+        rootCount_ += e.root ? 1 : 0;
+        rawBytes_ += e.size;
+    }
+
+    // 归档包访问随机，内核不必预读
+    ::madvise(p, fileBytes_, MADV_RANDOM);
+    return true;
+}
+
+void PackFile::close()
+{
+    if (data_ != nullptr)
+    {
+        ::munmap(const_cast<char*>(data_), fileBytes_);
+    }
+    data_ = nullptr;
+    fileBytes_ = 0;
+    entries_.clear();
+    rootCount_ = 0;
+    rawBytes_ = 0;
+}
+
+const PackFile::Entry* PackFile::find(std::string_view path) const
+{
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), path,
+                               [](const Entry& e, std::string_view p) { return e.path < p; });
+    return it != entries_.end() && it->path == path ? &*it : nullptr;
+}
+
+const PackFile::Entry* PackFile::rootOf(std::string_view path) const
+{
+    if (entries_.empty())
+    {
+        return nullptr;
+    }
+    // 依次检查 /a、/a/b、/a/b/c ...
+    for (std::size_t pos = path.find('/', 1);; pos = path.find('/', pos + 1))
+    {
+        const auto* e = find(path.substr(0, pos));
+        if (e != nullptr && e->root)
+        {
+            return e;
+        }
+        if (pos == std::string_view::npos)
+        {
+            return nullptr;
+        }
+    }
+}
+
+std::vector<const PackFile::Entry*> PackFile::children(std::string_view dir) const
+{
+    std::string prefix(dir);
+    if (prefix.back() != '/')
+    {
+        prefix += '/';
+    }
+
+    std::vector<const Entry*> out;
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), std::string_view(prefix),
+                               [](const Entry& e, std::string_view p) { return e.path < p; });
+    for (; it != entries_.end() && it->path.compare(0, prefix.size(), prefix) == 0; ++it)
+    {
+        if (it->path.find('/', prefix.size()) == std::string_view::npos)
+        {
+            out.push_back(&*it);
+        }
+    }
+    return out;
+}
+
+std::string_view PackFile::stored(const Entry& e) const
+{
+    return {data_ + e.offset, e.storedSize};
+}
+
+std::optional<std::string> PackFile::read(const Entry& e) const
+{
+    if (!e.compressed)
+    {
+        return std::string(stored(e));
+    }
+    return lzDecompress(stored(e), e.size);
+}
+
+// ------------ Builder ------------
+
+void PackFile::Builder::addDirectory(std::string path, std::uint32_t mtime, bool root)
+{
+    Item item;
+    item.path = std::move(path);
+    item.type = FileType::Directory;
+    item.root = root;
+    item.mtime = mtime;
+    items_.push_back(std::move(item));
+}
+
+void PackFile::Builder::addFile(std::string path, std::string_view data, std::uint32_t mtime)
+{
+    Item item;
+    item.path = std::move(path);
+    item.mtime = mtime;
+    item.size = static_cast<std::uint32_t>(data.size());
+    item.data = lzCompress(data);
+    item.compressed = item.data.size() < data.size();
+    if (!item.compressed)
+    {
+        item.data.assign(data);
+    }
+    rawBytes_ += data.size();
+    storedBytes_ += item.data.size();
+    items_.push_back(std::move(item));
+}
+
+void PackFile::Builder::copy(const PackFile& from, const Entry& e)
+{
+    Item item;
+    item.path = std::string(e.path);
+    item.type = e.type;
+    item.root = e.root;
+    item.compressed = e.compressed;
+    item.mtime = e.mtime;
+    item.size = e.size;
+    item.data = std::string(from.stored(e));
+    rawBytes_ += e.size;
+    storedBytes_ += item.data.size();
+    items_.push_back(std::move(item));
+}
+
+bool PackFile::Builder::write(const std::string& path) const
+{
+    std::vector<const Item*> sorted;
+    sorted.reserve(items_.size());
+    for (const auto& item : items_)
+    {
+        sorted.push_back(&item);
+    }
+    // 同一路径加入多次时保留最先加入的一项（稳定排序保证结果确定）
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Item* a, const Item* b) { return a->path < b->path; });
+    sorted.erase(std::unique(sorted.begin(), sorted.end(),
+                             [](const Item* a, const Item* b) { return a->path == b->path; }),
+                 sorted.end());
+
+    std::string out(kHeaderBytes, '\0');
+    std::string index;
+    for (const Item* item : sorted)
+    {
+        const std::uint64_t offset = out.size();
+        out += item->data;
+
+        put<std::uint16_t>(index, static_cast<std::uint16_t>(item->path.size()));
+        index += item->path;
+        put<std::uint8_t>(index, static_cast<std::uint8_t>(item->type));
+        put<std::uint8_t>(index, static_cast<std::uint8_t>((item->root ? kFlagRoot : 0) |
+                                                          (item->compressed ? kFlagCompressed : 0)));
+        put<std::uint32_t>(index, item->mtime);
+        put<std::uint32_t>(index, item->size);
+        put<std::uint64_t>(index, offset);
+        put<std::uint32_t>(index, static_cast<std::uint32_t>(item->data.size()));
+    }
+
+    std::string header;
+    header.append(kPackMagic, sizeof(kPackMagic));
+    put<std::uint32_t>(header, kPackVersion);
+    put<std::uint32_t>(header, static_cast<std::uint32_t>(sorted.size()));
+    put<std::uint64_t>(header, out.size());
+    put<std::uint64_t>(header, index.size());
+    out.replace(0, kHeaderBytes, header);
+    out += index;
+
+    const std::string tmpPath = path + ".tmp";
+    const int         fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+    const bool ok = writeAll(fd, out) && ::fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || std::rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace osp::fs
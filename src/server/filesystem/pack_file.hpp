@@ -0,0 +1,109 @@
+#pragma once
+
+#include "dir_entry.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace osp::fs
+{
+
+// 冷数据归档包：若干棵目录子树（如已定稿的论文目录）的只读快照，生成后不再修改。
+// 文件格式（小端）：
+//   头部 32 字节：magic "OSPPACK1"，uint32 version，uint32 entryCount，uint64 indexOffset，uint64 indexBytes
+//   数据区：各文件内容，LZ 压缩（见 lz_codec.hpp）或压缩无收益时原样存放
+//   索引：entryCount 项，按路径排序，每项 uint16 pathLen + path + uint8 type + uint8 flags
+//         + uint32 mtime + uint32 size + uint64 offset + uint32 storedSize
+// 打开时整个文件以 mmap 只读映射，索引中的路径直接指向映射区，读取时从映射区解压。
+class PackFile
+{
+public:
+    struct Entry
+    {
+        std::string_view path;           // 规范化的绝对路径（如 /papers/12/meta.txt）
+        FileType         type{FileType::File};
+        bool             root{false};    // 归档子树的根目录
+        bool             compressed{false};
+        std::uint32_t    mtime{0};
+        std::uint32_t    size{0};        // 原始字节数
+        std::uint64_t    offset{0};      // 数据在包文件中的偏移
+        std::uint32_t    storedSize{0};  // 包内字节数
+    };
+
+    PackFile() = default;
+    ~PackFile() { close(); }
+
+    PackFile(const PackFile&) = delete;
+    PackFile& operator=(const PackFile&) = delete;
+
+    // 映射并校验包文件；文件不存在或格式不对时返回 false
+    bool open(const std::string& path);
+    void close();
+
+    [[nodiscard]] bool isOpen() const noexcept { return data_ != nullptr; }
+    [[nodiscard]] const std::vector<Entry>& entries() const noexcept { return entries_; }
+    [[nodiscard]] std::uint64_t fileBytes() const noexcept { return fileBytes_; }
+    [[nodiscard]] std::size_t rootCount() const noexcept { return rootCount_; }
+    [[nodiscard]] std::uint64_t rawBytes() const noexcept { return rawBytes_; } // 文件内容解压后的总字节数
+
+    // path 需已规范化（见 normalize）
+    [[nodiscard]] const Entry* find(std::string_view path) const;
+    // 包含 path 的归档子树的根（path 本身或其祖先目录），不在包内时返回 nullptr
+    [[nodiscard]] const Entry* rootOf(std::string_view path) const;
+    // 目录 dir 的直接子项，按名字排序
+    [[nodiscard]] std::vector<const Entry*> children(std::string_view dir) const;
+
+    // 文件内容；数据损坏时返回 std::nullopt
+    [[nodiscard]] std::optional<std::string> read(const Entry& e) const;
+    // 包内原样的（压缩后的）字节，重写包时直接复制而不必重新压缩
+    [[nodiscard]] std::string_view stored(const Entry& e) const;
+
+    // "/a//b/" -> "/a/b"，根目录为 "/"
+    static std::string normalize(std::string_view path);
+
+    // 生成新的包文件：条目先收集在内存中，write 时排序写出
+    class Builder
+    {
+    public:
+        void addDirectory(std::string path, std::uint32_t mtime, bool root);
+        void addFile(std::string path, std::string_view data, std::uint32_t mtime);
+        // 复制已有包中的条目（不重新压缩）
+        void copy(const PackFile& from, const Entry& e);
+
+        // 先写到 path + ".tmp" 并 fsync，再原子地替换 path
+        bool write(const std::string& path) const;
+
+        [[nodiscard]] std::size_t size() const noexcept { return items_.size(); }
+        [[nodiscard]] std::uint64_t rawBytes() const noexcept { return rawBytes_; }
+        [[nodiscard]] std::uint64_t storedBytes() const noexcept { return storedBytes_; }
+
+    private:
+        struct Item
+        {
+            std::string   path;
+            FileType      type{FileType::File};
+            bool          root{false};
+            bool          compressed{false};
+            std::uint32_t mtime{0};
+            std::uint32_t size{0};
+            std::string   data; // 包内字节
+        };
+
+        std::vector<Item> items_;
+        std::uint64_t     rawBytes_{0};
+        std::uint64_t     storedBytes_{0};
+    };
+
+private:
+    const char*        data_{nullptr};
+    std::size_t        fileBytes_{0};
+    std::vector<Entry> entries_;
+    std::size_t        rootCount_{0};
+    std::uint64_t      rawBytes_{0};
+};
+
+} // namespace osp::fs
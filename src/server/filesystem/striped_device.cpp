@@ -0,0 +1,290 @@
+#include "striped_device.hpp"
+
+#include "common/logger.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <future>
+
+namespace osp::fs
+{
+
+bool StripedDevice::open(const std::string& path, bool direct)
+{
+    close();
+    direct_ = direct;
+    return primary_.open(path, direct);
+}
+
+void StripedDevice::close()
+{
+    std::lock_guard<std::mutex> lock(membersMutex_);
+    primary_.close();
+    others_.clear();
+    layout_ = Layout{};
+}
+
+bool StripedDevice::attach(const SuperBlock& sb, const std::vector<std::string>& memberPaths, bool create)
+{
+    const bool striped = (sb.features & kFeatureStriped) != 0 && sb.stripeCount > 1;
+
+    Layout layout;
+    layout.blockSize = sb.blockSize;
+    layout.dataBlockStart = sb.dataBlockStart;
+    layout.count = striped ? sb.stripeCount : 1;
+    layout.unitBlocks = striped ? std::max<std::uint32_t>(sb.stripeUnitBlocks, 1) : 1;
+    if (layout.blockSize == 0 || layout.count > kMaxStripeMembers || memberPaths.size() < layout.count)
+    {
+        return false;
+    }
+
+    std::vector<std::unique_ptr<BlockDevice>> others;
+    for (std::uint32_t i = 1; i < layout.count; ++i)
+    {
+        // 挂载已有条带集时成员必须已存在（BlockDevice::open 会创建不存在的文件）
+        std::error_code ec;
+        if (!create && !std::filesystem::exists(memberPaths[i], ec))
+        {
+            OSP_LOG(osp::LogLevel::Error, "StripedDevice: stripe member " + memberPaths[i] + " is missing");
+            return false;
+        }
+        auto dev = std::make_unique<BlockDevice>();
+        if (!dev->open(memberPaths[i], direct_))
+        {
+            OSP_LOG(osp::LogLevel::Error, "StripedDevice: cannot open stripe member " + memberPaths[i]);
+            return false;
+        }
+
+        StripeMemberHeader expected;
+        expected.setId = sb.stripeSetId;
+        expected.index = i;
+        expected.count = layout.count;
+        expected.unitBlocks = layout.unitBlocks;
+        expected.blockSize = layout.blockSize;
+        if (create)
+        {
+            // 成员头独占第 0 块，按整块写入以满足 O_DIRECT 的对齐要求
+            std::vector<std::byte> block(layout.blockSize, std::byte{0});
+            std::memcpy(block.data(), &expected, sizeof(expected));
+            if (!dev->truncate(0) || !dev->write(0, block.data(), block.size()))
+            {
+                OSP_LOG(osp::LogLevel::Error, "StripedDevice: cannot initialize stripe member " + memberPaths[i]);
+                return false;
+            }
+        }
+        else
+        {
+            StripeMemberHeader actual;
+            std::size_t        filled = 0;
+            if (!dev->read(0, &actual, sizeof(actual), &filled) || filled != sizeof(actual) ||
+                std::memcmp(&actual, &expected, sizeof(actual)) != 0)
+            {
+                OSP_LOG(osp::LogLevel::Error, "StripedDevice: " + memberPaths[i] + " is not member " +
+                                                  std::to_string(i) + " of this stripe set");
+                return false;
+            }
+        }
+        others.push_back(std::move(dev));
+    }
+
+    std::lock_guard<std::mutex> lock(membersMutex_);
+    others_ = std::move(others);
+    layout_ = layout;
+    return true;
+}
+
+StripedDevice::Location StripedDevice::locate(std::uint32_t blockId) const noexcept
+{
+    const std::uint64_t bs = layout_.blockSize;
+    if (layout_.count <= 1 || blockId < layout_.dataBlockStart)
+    {
+        return {0, blockId * bs};
+    }
+
+    const std::uint64_t d = blockId - layout_.dataBlockStart;
+    const std::uint64_t unit = d / layout_.unitBlocks;
+    const auto          m = static_cast<std::uint32_t>(unit % layout_.count);
+    const std::uint64_t local = (unit / layout_.count) * layout_.unitBlocks + d % layout_.unitBlocks;
+    // 成员 0 的数据接在元数据区之后；其它成员的第 0 块是成员头
+    return {m, (m == 0 ? layout_.dataBlockStart + local : 1 + local) * bs};
+}
+
+std::uint64_t StripedDevice::memberExtent(std::uint32_t m, std::uint32_t blocks) const noexcept
+{
+    const std::uint64_t bs = layout_.blockSize;
+    if (layout_.count <= 1)
+    {
+        return blocks * bs;
+    }
+    if (blocks <= layout_.dataBlockStart)
+    {
+        return m == 0 ? blocks * bs : bs;
+    }
+
+    const std::uint64_t d = blocks - layout_.dataBlockStart;
+    const std::uint64_t round = static_cast<std::uint64_t>(layout_.unitBlocks) * layout_.count;
+    const std::uint64_t rem = d % round;
+    const std::uint64_t first = static_cast<std::uint64_t>(m) * layout_.unitBlocks;
+    const std::uint64_t owned =
+        (d / round) * layout_.unitBlocks + (rem > first ? std::min<std::uint64_t>(rem - first, layout_.unitBlocks) : 0);
+    return (m == 0 ? layout_.dataBlockStart + owned : 1 + owned) * bs;
+}
+
+bool StripedDevice::readBlock(std::uint32_t blockId, void* dst, std::size_t* filled)
+{
+    const auto loc = locate(blockId);
+    return member(loc.member).read(loc.offset, dst, layout_.blockSize, filled);
+}
+
+bool StripedDevice::writeBlock(std::uint32_t blockId, const void* src)
+{
+    const auto loc = locate(blockId);
+    return member(loc.member).write(loc.offset, src, layout_.blockSize);
+}
+
+bool StripedDevice::readBlocks(const std::vector<std::uint32_t>& ids, std::byte* dst)
+{
+    const std::size_t bs = layout_.blockSize;
+
+    // 按成员分组，组内按文件偏移排序
+    struct Item
+    {
+        std::uint64_t offset;
+        std::size_t   slot; // 在 ids / dst 中的位置
+    };
+    std::vector<std::vector<Item>> perMember(layout_.count);
+    for (std::size_t i = 0; i < ids.size(); ++i)
+    {
+        const auto loc = locate(ids[i]);
+        perMember[loc.member].push_back({loc.offset, i});
+    }
+
+    auto readMember = [&](std::uint32_t m) -> bool {
+        auto& items = perMember[m];
+        std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) { return a.offset < b.offset; });
+
+        BlockDevice&           dev = member(m);
+        std::vector<std::byte> run;
+        for (std::size_t i = 0; i < items.size();)
+        {
+            std::size_t j = i + 1;
+            while (j < items.size() && items[j].offset == items[j - 1].offset + bs)
+            {
+                ++j;
+            }
+            if (j - i == 1)
+            {
+                if (!dev.read(items[i].offset, dst + items[i].slot * bs, bs))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                run.resize((j - i) * bs);
+                if (!dev.read(items[i].offset, run.data(), run.size()))
+                {
+                    return false;
+                }
+                for (std::size_t k = i; k < j; ++k)
+                {
+                    std::memcpy(dst + items[k].slot * bs, run.data() + (k - i) * bs, bs);
+                }
+            }
+            i = j;
+        }
+        return true;
+    };
+
+    // 第一个有数据的成员在当前线程读，其余成员各用一个线程并行读
+    std::vector<std::future<bool>> pending;
+    std::optional<std::uint32_t>   local;
+    for (std::uint32_t m = 0; m < layout_.count; ++m)
+    {
+        if (perMember[m].empty())
+        {
+            continue;
+        }
+        if (!local)
+        {
+            local = m;
+        }
+        else
+        {
+            pending.push_back(std::async(std::launch::async, readMember, m));
+        }
+    }
+
+    bool ok = !local || readMember(*local);
+    for (auto& f : pending)
+    {
+        ok = f.get() && ok;
+    }
+    return ok;
+}
+
+bool StripedDevice::punchBlock(std::uint32_t blockId)
+{
+    const auto loc = locate(blockId);
+    return member(loc.member).punchHole(loc.offset, layout_.blockSize);
+}
+
+bool StripedDevice::sync()
+{
+    std::lock_guard<std::mutex> lock(membersMutex_);
+    bool ok = primary_.sync();
+    for (auto& dev : others_)
+    {
+        ok = dev->sync() && ok;
+    }
+    return ok;
+}
+
+std::optional<std::uint64_t> StripedDevice::size() const
+{
+    auto total = primary_.size();
+    for (const auto& dev : others_)
+    {
+        const auto bytes = dev->size();
+        if (!total || !bytes)
+        {
+            return std::nullopt;
+        }
+        *total += *bytes;
+    }
+    return total;
+}
+
+bool StripedDevice::fitBlocks(std::uint32_t blocks, bool grow)
+{
+    for (std::uint32_t m = 0; m < layout_.count; ++m)
+    {
+        BlockDevice& dev = member(m);
+        const auto   current = dev.size();
+        const auto   wanted = memberExtent(m, blocks);
+        if (!current)
+        {
+            return false;
+        }
+        if ((grow ? *current < wanted : *current > wanted) && !dev.truncate(wanted))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+AlignedBufferPool::Stats StripedDevice::poolStats() const
+{
+    auto total = primary_.poolStats();
+    for (const auto& dev : others_)
+    {
+        const auto s = dev->poolStats();
+        total.allocations += s.allocations;
+        total.reuses += s.reuses;
+    }
+    return total;
+}
+
+} // namespace osp::fs
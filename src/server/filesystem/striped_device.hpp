@@ -0,0 +1,97 @@
+#pragma once
+
+#include "block_device.hpp"
+#include "superblock.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace osp::fs
+{
+
+// 按块寻址的 backing store：单文件，或按条带分布在多个成员文件（可位于不同磁盘）上。
+// 成员 0 是主 backing file，存放 superblock / inode 表 / 位图等元数据区以及它那一份数据块；
+// 数据区按 unitBlocks 块为一个条带单元轮流分配给各成员：第 d 个数据块属于成员 (d / unit) % count。
+// 每个成员所分到的块在该成员文件中是连续存放的，因此一段连续的块号在每个成员上各是一段连续区间。
+class StripedDevice
+{
+public:
+    struct Layout
+    {
+        std::uint32_t blockSize{0};
+        std::uint32_t dataBlockStart{0};
+        std::uint32_t count{1};      // 成员数，1 表示单文件
+        std::uint32_t unitBlocks{1};
+    };
+
+    // 打开主 backing file（不存在则创建），此时按单文件布局寻址，blockSize 需随后由 attach 设置
+    bool open(const std::string& path, bool direct);
+    void close();
+
+    // 按 sb 设置布局并打开成员 1..count-1（memberPaths[i] 对应成员 i，[0] 不使用）。
+    // create 为 true 时清空成员文件并写入成员头，否则核对成员头与 sb 一致
+    bool attach(const SuperBlock& sb, const std::vector<std::string>& memberPaths, bool create);
+
+    [[nodiscard]] bool isOpen() const noexcept { return primary_.isOpen(); }
+    // 实际生效的 IO 模式（以主 backing file 为准，见 BlockDevice::open）
+    [[nodiscard]] bool direct() const noexcept { return primary_.direct(); }
+    [[nodiscard]] const Layout& layout() const noexcept { return layout_; }
+    [[nodiscard]] std::uint32_t members() const noexcept { return layout_.count; }
+
+    // 主 backing file，用于按字节偏移读写块 0 中的 superblock 与条带表
+    [[nodiscard]] BlockDevice& primary() noexcept { return primary_; }
+
+    // 读一个块；filled 返回实际从文件读到的字节数（文件末尾之后填 0）
+    bool readBlock(std::uint32_t blockId, void* dst, std::size_t* filled = nullptr);
+    bool writeBlock(std::uint32_t blockId, const void* src);
+
+    // 读取 ids 中的块到 dst（按 ids 顺序依次存放）。同一成员上相邻的块合并为一次读取，
+    // 涉及多个成员时各成员的读取并行进行
+    bool readBlocks(const std::vector<std::uint32_t>& ids, std::byte* dst);
+
+    bool punchBlock(std::uint32_t blockId);
+
+    // 依次 fdatasync 所有成员；可与读写并发调用
+    bool sync();
+
+    // 所有成员文件的大小之和
+    [[nodiscard]] std::optional<std::uint64_t> size() const;
+
+    // 把各成员文件调整为恰好容纳块 [0, blocks) 的大小：grow 为 true 时只扩不缩，否则只缩不扩
+    bool fitBlocks(std::uint32_t blocks, bool grow);
+
+    [[nodiscard]] AlignedBufferPool::Stats poolStats() const;
+
+private:
+    struct Location
+    {
+        std::uint32_t member;
+        std::uint64_t offset;
+    };
+
+    [[nodiscard]] Location locate(std::uint32_t blockId) const noexcept;
+    [[nodiscard]] BlockDevice& member(std::uint32_t index) noexcept
+    {
+        return index == 0 ? primary_ : *others_[index - 1];
+    }
+    [[nodiscard]] const BlockDevice& member(std::uint32_t index) const noexcept
+    {
+        return index == 0 ? primary_ : *others_[index - 1];
+    }
+
+    // 成员 m 上容纳块 [0, blocks) 中属于它的块所需的文件大小
+    [[nodiscard]] std::uint64_t memberExtent(std::uint32_t m, std::uint32_t blocks) const noexcept;
+
+    BlockDevice                               primary_;
+    std::vector<std::unique_ptr<BlockDevice>> others_;   // 成员 1..count-1
+    Layout                                    layout_;
+    bool                                      direct_{false}; // open 时请求的模式，成员沿用
+    mutable std::mutex                        membersMutex_;  // 只保护 sync() 与 attach / close 之间对 others_ 的并发访问
+};
+
+} // namespace osp::fs
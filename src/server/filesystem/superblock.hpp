@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 namespace osp::fs
@@ -13,6 +14,7 @@ namespace osp::fs
 // [dataBlockStart .. totalBlocks - 1]                         : data blocks
 //
 // 具体块数可在挂载/格式化时固定为一组常量以满足课程要求。
+// 条带镜像（kFeatureStriped）的块号空间不变，只是数据块分布在多个成员文件中（见 StripedDevice）。
 struct SuperBlock
 {
     std::uint32_t magic{0x20251205};     // 文件系统魔数，用于校验是否为本 FS
@@ -34,6 +36,50 @@ struct SuperBlock
 
     // 根目录 inode 号（后续实现目录时可使用）
     std::uint32_t rootInodeId{0};
+
+    // 磁盘上每条 inode 记录的字节数；0 表示最早的 44 字节布局。
+    // 旧布局挂载时会被迁移为当前布局（见 inode.hpp 中的 kInodeDiskSize）
+    std::uint32_t inodeSize{0};
+
+    // 兼容特性位（见下方 kFeature*），旧版镜像为 0
+    std::uint32_t features{0};
+
+    // 条带（kFeatureStriped）：成员文件数（含本文件）、条带单元块数、条带集标识。单文件镜像均为 0
+    std::uint32_t stripeCount{0};
+    std::uint32_t stripeUnitBlocks{0};
+    std::uint32_t stripeSetId{0};
+
+    // inode 表迁移进行中（见 Vfs::migrateInodeTable）：新布局的整张 inode 表已暂存在从该块号开始的
+    // inodeTableBlocks 个空闲数据块中，挂载时据此重做迁移。0 表示没有进行中的迁移
+    std::uint32_t inodeMigrationStaging{0};
+};
+
+// 所有目录项都已在 DirEntry::type 中记录文件类型（旧版镜像挂载时补齐后置位）
+constexpr std::uint32_t kFeatureTypedDirEntries = 1u << 0;
+
+// 数据块按条带分布在多个成员文件中（见 StripeTable 与 StripedDevice）
+constexpr std::uint32_t kFeatureStriped = 1u << 1;
+
+// 条带集的成员文件路径表，位于块 0 的 kStripeTableOffset 处（superblock 之后）。
+// 成员 0 即主 backing file，paths[0] 不使用；相对路径相对于主 backing file 所在目录
+constexpr std::uint32_t kMaxStripeMembers = 8;
+constexpr std::size_t   kStripePathMax = 256;
+constexpr std::size_t   kStripeTableOffset = 1024;
+
+struct StripeTable
+{
+    char paths[kMaxStripeMembers][kStripePathMax]{};
+};
+
+// 成员 1..N-1 的文件头（占成员文件的第 0 块），挂载时与 superblock 核对，防止接错文件
+struct StripeMemberHeader
+{
+    char          magic[8]{'O', 'S', 'P', 'S', 'T', 'R', 'P', '1'};
+    std::uint32_t setId{0};
+    std::uint32_t index{0};
+    std::uint32_t count{0};
+    std::uint32_t unitBlocks{0};
+    std::uint32_t blockSize{0};
 };
 
 } // namespace osp::fs
@@ -1,14 +1,26 @@
 #pragma once
 
+#include "common/timed_mutex.hpp"
+
 #include "block_cache.hpp"
+#include "block_trace.hpp"
+#include "dir_entry.hpp"
 #include "inode.hpp"
+#include "pack_file.hpp"
+#include "striped_device.hpp"
 #include "superblock.hpp"
 
+#include <algorithm>
 #include <cstddef>
 #include <functional>
 #include <fstream>
+#include <map>
+#include <mutex>
 #include <optional>
+#include <set>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace osp::fs
@@ -20,25 +32,171 @@ namespace osp::fs
 class Vfs
 {
 public:
-    explicit Vfs(std::size_t cacheCapacity)
-        : cache_(cacheCapacity)
+    // cacheBytes：块缓存的字节预算（见 BlockCache）
+    explicit Vfs(std::size_t cacheBytes)
+        : cache_(cacheBytes)
     {
     }
 
     // 挂载或初始化文件系统；如果 backingFile 不存在或不是合法的本项目文件系统，则自动格式化。
     bool mount(const std::string& backingFile);
 
-    // 刷新底层文件（用于 BACKUP/RESTORE 前确保落盘）
+    // 刷新底层文件（用于 BACKUP/RESTORE 前确保落盘）：fdatasync 并保存缓存预热集合
     bool sync();
 
+    // 只做 fdatasync（条带镜像依次同步各成员），供组提交线程在不持有 Vfs 锁时调用
+    //（与 remount 的关闭 / 重开由 StripedDevice / BlockDevice 内部互斥）
+    bool syncData() { return device_.sync(); }
+
+    // 缓存预热：把缓存中的块号（最近使用的在前）写入 <backingFile>.warm。sync()、remount() 时自动保存，
+    // 服务器也会定期保存；mount 已有镜像时读取该文件，按块号顺序合并相邻块成批读入缓存。调用方需持有 Vfs 锁
+    bool saveWarmSet();
+    void setWarmCache(bool enabled) noexcept { warmCache_ = enabled; }
+
     // 重新挂载（会关闭并重开 backingFile_，并重置 BlockCache）
     // beforeOpen: 在关闭旧文件后、重新打开前执行（可用于外部覆盖 backingFile_ 内容，例如 RESTORE）
     bool remount(const std::function<bool(const std::string& backingFile)>& beforeOpen = {});
 
+    // 释放数据块时是否对 backing file 打洞（Linux fallocate PUNCH_HOLE），使其磁盘占用随数据减少。
+    // 其它平台上打洞为空操作。释放的块先排队，在下一次 fdatasync 成功之后才打洞（sync() 或 punchFreedBlocks()）
+    void setPunchHoles(bool enabled) noexcept { punchHoles_ = enabled; }
+
+    // 对排队中的已释放块打洞：先 fdatasync 使释放落盘，再打洞；没有排队的块时不做同步。
+    // 调用方需持有 Vfs 锁（服务器定期调用），事务中调用为空操作
+    bool punchFreedBlocks();
+
+    // 以 O_DIRECT 打开 backing file（需在 mount 之前设置）：绕过内核页缓存，BlockCache 成为唯一的缓存层。
+    // 文件系统不支持时回退为普通 IO，directIo() 返回实际生效的模式
+    void setDirectIo(bool enabled) noexcept { directIoRequested_ = enabled; }
+    [[nodiscard]] bool directIo() const noexcept { return device_.direct(); }
+    [[nodiscard]] AlignedBufferPool::Stats ioBufferStats() const { return device_.poolStats(); }
+
+    // 条带布局（需在 mount 之前设置）：members 为主 backing file 之外的成员文件路径（可位于不同磁盘，
+    // 相对路径相对于主 backing file 所在目录），数据块以 unitBlocks 块为单位轮流分布到各成员。
+    // 新镜像直接按条带格式化；已有的单文件镜像在挂载时转换（RESTORE 的单文件备份同样会被转换）；
+    // 已是条带布局的镜像沿用其 superblock 中的描述。members 为空表示单文件
+    void setStripe(std::vector<std::string> members, std::uint32_t unitBlocks)
+    {
+        stripeMembers_ = std::move(members);
+        stripeUnitBlocks_ = std::max<std::uint32_t>(unitBlocks, 1);
+    }
+    [[nodiscard]] std::uint32_t stripeMembers() const noexcept { return device_.members(); }
+    [[nodiscard]] std::uint32_t stripeUnitBlocks() const noexcept { return device_.layout().unitBlocks; }
+
+    // ------------ 冷数据归档 ------------
+    // 归档包 <backingFile>.pack（见 PackFile）保存整棵移出热镜像的目录子树（如已定稿的论文目录），只读 mmap。
+    // 路径在热镜像中不存在时，readFile / readFileRange / stat / exists / openDirectory 透明地回退到归档包，
+    // 目录列表合并两者（热镜像中的同名项优先）。写操作（创建、写入、删除）落在归档子树内时，
+    // 先把整棵子树复制回热镜像，再生成不含该子树的新归档包（事务内在 commit 之后进行）。
+
+    // 归档包中条目的 inodeId（DirEntryInfo / FileStat 中）
+    static constexpr std::uint32_t kArchivedInodeId = 0xffffffffu;
+
+    static std::string packPathFor(const std::string& backingFile) { return backingFile + ".pack"; }
+
+    struct ArchiveResult
+    {
+        std::uint32_t roots{0};        // 本次归档的子树数
+        std::uint32_t files{0};
+        std::uint64_t rawBytes{0};     // 这些文件的原始字节数
+        std::uint64_t packBytes{0};    // 归档后包文件的大小
+    };
+
+    // 把 roots（热镜像中的目录）连同其全部内容写入新的归档包，替换旧包后再从热镜像中删除。
+    // 写包失败时热镜像不变；删除中途失败时热镜像中的副本仍优先于包内数据，下次归档会再处理。
+    // 调用方需持有 Vfs 锁，且不能处于 Transaction 中
+    std::optional<ArchiveResult> archive(const std::vector<std::string>& roots);
+
+    struct ArchiveStats
+    {
+        std::size_t   roots{0};          // 包内子树数
+        std::size_t   entries{0};        // 包内条目数（文件与目录）
+        std::uint64_t rawBytes{0};       // 包内文件解压后的总字节数
+        std::uint64_t packBytes{0};      // 包文件大小
+        std::uint64_t archivedRoots{0};  // 累计归档的子树数
+        std::uint64_t restoredRoots{0};  // 累计因写入而复制回热镜像的子树数
+    };
+    [[nodiscard]] ArchiveStats archiveStats() const noexcept;
+
+    // 把当前镜像导出为单文件镜像（条带镜像会被合并，导出的 superblock 不带条带描述），供 BACKUP 使用；
+    // 导出的文件可直接交给 osproj_fsck 检查或由 RESTORE 恢复；存在归档包时一并复制为 <path>.pack。
+    // 调用方需持有 Vfs 锁，且不能处于 Transaction 中
+    bool exportImage(const std::string& path);
+
+    struct CompactStats
+    {
+        std::uint32_t liveBlocks{0};       // 在用数据块数
+        std::uint32_t movedBlocks{0};      // 被搬移的数据块数
+        std::uint64_t fileBytesBefore{0};  // backing file 逻辑大小
+        std::uint64_t fileBytesAfter{0};
+    };
+
+    // 在线压缩：把最靠后的在用数据块搬进最靠前的空闲块，然后截断 backing file 末尾的空闲区域。
+    // 分三批进行，每批之间 fdatasync：占用新块并复制数据 -> 改 inode -> 释放旧块、打洞与截断；
+    // 掉电时 inode 只会指向旧块或已落盘的新块，最坏情况是泄漏本次搬移的块（osproj_fsck 可发现）。
+    // 调用方需持有 Vfs 锁，且不能处于 Transaction 中。
+    std::optional<CompactStats> compact();
+
+    // 碎片化程度：只统计占用 2 个及以上数据块的普通文件
+    struct FragmentationStats
+    {
+        std::uint32_t multiBlockFiles{0};  // 占用 >= 2 个数据块的文件数
+        std::uint32_t fragmentedFiles{0};  // 其中数据块不连续的文件数
+        std::uint32_t extents{0};          // 这些文件的连续区段总数（全部连续时等于 multiBlockFiles）
+        std::uint32_t blocks{0};           // 这些文件占用的数据块总数
+    };
+    FragmentationStats fragmentation();
+
+    // 后台碎片整理的累计结果
+    struct DefragStats
+    {
+        std::uint64_t passes{0};       // 完整扫描过的轮数
+        std::uint64_t movedFiles{0};
+        std::uint64_t movedBlocks{0};
+    };
+    [[nodiscard]] DefragStats defragStats() const noexcept { return defragStats_; }
+
+    // 碎片整理的一步：处理 inode 号 >= cursor 的下一个目录，把其中不连续或远离目录块的文件
+    // 搬到紧跟目录块之后的连续空闲区。每步只处理一个目录，便于调用方在两步之间释放锁、限速。
+    // 返回 true 表示本轮扫描结束（cursor 被重置为 0）。调用方需持有 Vfs 锁，且不能处于 Transaction 中。
+    bool defragmentStep(std::uint32_t& cursor);
+
     [[nodiscard]] const SuperBlock& superBlock() const noexcept { return sb_; }
+    // 事务提交中途写盘失败后为 true：此时拒绝一切块写入，mount / remount 后恢复
+    [[nodiscard]] bool readOnly() const noexcept { return readOnly_; }
     [[nodiscard]] BlockCache::Stats cacheStats() const noexcept { return cache_.stats(); }
-    [[nodiscard]] std::size_t cacheCapacity() const noexcept { return cache_.capacity(); }
+    [[nodiscard]] std::size_t cacheCapacityBytes() const noexcept { return cache_.capacityBytes(); }
     [[nodiscard]] std::size_t cacheSize() const noexcept { return cache_.size(); }
+    [[nodiscard]] const BlockCache::AutoTune& cacheAutoTune() const noexcept { return cache_.autoTune(); }
+
+    // 在线调整块缓存预算（缩小时立即淘汰），不需要 remount；会关闭自动调节。调用方需持有 Vfs 锁
+    void resizeCache(std::size_t bytes)
+    {
+        cache_.disableAutoTune();
+        cache_.resize(bytes);
+    }
+    // 在 [minBytes, maxBytes] 内自动调节块缓存预算，由调用方定期调用 tuneCache。调用方需持有 Vfs 锁
+    void setCacheAutoTune(std::size_t minBytes, std::size_t maxBytes) { cache_.setAutoTune(minBytes, maxBytes); }
+    void disableCacheAutoTune() noexcept { cache_.disableAutoTune(); }
+    std::optional<std::size_t> tuneCache(bool memoryPressure) { return cache_.tune(memoryPressure); }
+
+    // 当前线程触发的块读写计数（线程局部，只增不减），调用方在请求前后取差值得到单个请求的 IO 量
+    struct IoCounters
+    {
+        std::uint64_t blockReads{0};  // readBlock 次数（含缓存命中）
+        std::uint64_t diskReads{0};   // 其中未命中缓存、实际读盘的次数
+        std::uint64_t blockWrites{0}; // 实际写盘的块数（事务内的写在 commit 时计入）
+        std::uint64_t vfsCalls{0};    // 公开文件操作（createFile / readFile / listDirectory 等）的调用次数，含操作间的嵌套调用
+    };
+    static const IoCounters& threadIoCounters() noexcept;
+
+    // 块访问追踪：开启后每次经过缓存的块读（含命中）与块写回各追加一条 4 字节记录到 path，
+    // 供 osproj_cachesim 离线回放、绘制缺失率曲线。事务内读到暂存块的访问不经过缓存，不记录。
+    bool startBlockTrace(const std::string& path);
+    // 停止追踪并返回记录条数；未在追踪时返回 std::nullopt
+    std::optional<std::uint64_t> stopBlockTrace();
+    [[nodiscard]] bool blockTraceActive() const noexcept { return blockTrace_.isOpen(); }
+    [[nodiscard]] std::uint64_t blockTraceRecords() const noexcept { return blockTrace_.records(); }
 
     // ------------ 高层文件/目录接口（带路径解析） ------------
 
@@ -51,42 +209,197 @@ public:
     // 把一个字符串整体写入指定路径的文件（不存在则创建，存在则覆盖）
     bool writeFile(const std::string& path, const std::string& data);
 
+    // 在文件末尾追加数据（不存在则创建）。只改写最后一个未写满的块和新分配的块，
+    // 不会像 writeFile 那样释放并重写全部数据块。
+    bool appendFile(const std::string& path, const std::string& data);
+
+    // 从 offset 处覆盖写入 data（不存在则创建）；offset 超过文件末尾时中间补 0。
+    bool writeAt(const std::string& path, std::size_t offset, const std::string& data);
+
+    // 把文件截断/扩展到 newSize 字节：缩小时释放多余的块，扩展时补 0。
+    bool truncate(const std::string& path, std::size_t newSize);
+
     // 从指定路径读取整个文件内容为字符串
     std::optional<std::string> readFile(const std::string& path);
 
+    // 读取 [offset, offset + length) 区间（超出文件末尾的部分被截掉），只读取覆盖该区间的块。
+    // outFileSize 非空时返回文件总大小，便于调用方分页。
+    std::optional<std::string> readFileRange(const std::string& path,
+                                             std::size_t        offset,
+                                             std::size_t        length,
+                                             std::size_t*       outFileSize = nullptr);
+
     // 删除普通文件（不支持递归删目录）
     bool removeFile(const std::string& path);
 
     // 删除空目录（不允许删除根目录，也不做递归删除）
     bool removeDirectory(const std::string& path);
 
-    // 列出目录项，返回简单的字符串列表（每行一个名字），失败返回 std::nullopt
+    // 文件/目录的元信息（只来自目录项与 inode，不读取数据块）
+    struct FileStat
+    {
+        std::uint32_t inodeId{};
+        bool          isDirectory{false};
+        std::uint32_t size{0};
+        std::uint32_t mtime{0}; // Unix 秒；旧版镜像迁移而来的 inode 为 0（未知）
+        bool          archived{false}; // 来自归档包（inodeId 为 kArchivedInodeId）
+    };
+
+    // 查询路径的元信息：只解析路径上的目录项并读取目标 inode，不读取文件内容
+    std::optional<FileStat> stat(const std::string& path);
+
+    // 路径是否存在（文件或目录）
+    bool exists(const std::string& path);
+
+    // readdir 风格的目录项
+    struct DirEntryInfo
+    {
+        std::string_view name;     // 指向 DirIterator 内部缓冲区，迭代器销毁前有效
+        std::uint32_t    inodeId{};
+        FileType         type{FileType::Unknown};
+        bool             archived{false}; // 来自归档包
+    };
+
+    // 目录迭代器：openDirectory 时读取一次目录块（旧版目录项的类型也在此时补齐），
+    // 之后 next() 只在内存中逐项返回，不再访问 Vfs，可以在释放 Vfs 锁之后继续迭代。
+    class DirIterator
+    {
+    public:
+        bool next(DirEntryInfo& out);
+
+    private:
+        friend class Vfs;
+        std::vector<DirEntry> entries_;
+        std::size_t           pos_{0};
+    };
+
+    // 打开目录用于迭代；路径不存在或不是目录时返回 std::nullopt
+    std::optional<DirIterator> openDirectory(const std::string& path);
+
+    // 列出目录项，返回简单的字符串列表（每行一个名字，目录名后追加 '/'），失败返回 std::nullopt
     std::optional<std::string> listDirectory(const std::string& path);
 
-private:
-    // 目录项结构：只支持 60 字节以内的 UTF-8 名称
-    struct DirEntry
+    // 多操作事务：构造时获取调用方传入的互斥锁，在一次加锁内完成一组读写，通过 operator-> 调用 Vfs 接口。
+    // - 事务内写入的块暂存在内存中（事务内的读能看到），commit() 时按“文件数据 -> 位图 -> inode 表 -> 目录块”
+    //   的依赖顺序一次写回（只 pwrite，不 fdatasync；持久化由 DurabilityMode / sync() 负责）；
+    //   写回中途失败时丢弃块缓存并把文件系统置为只读（readOnly()），直到重新挂载；
+    // - 未 commit 就析构（例如处理函数中途出错返回）时丢弃全部暂存写入，磁盘保持事务开始前的状态；
+    // - 事务内解析过的路径前缀会被缓存，后续操作不必再从根目录逐级查找。
+    // 注意：commit() 之后锁仍然持有到析构，此后的写入不再属于事务（直接落盘）。
+    class Transaction
     {
-        std::uint32_t inodeId{}; // 0 表示空槽
-        char name[60]{};         // 以 '\0' 结尾的字符串
+    public:
+        Transaction(Vfs& vfs, osp::TimedMutex& mutex);
+        ~Transaction();
+
+        Transaction(const Transaction&) = delete;
+        Transaction& operator=(const Transaction&) = delete;
+
+        Vfs* operator->() noexcept { return &vfs_; }
+
+        // 写回全部暂存块；写盘失败返回 false（此后文件系统只读）
+        bool commit();
+
+        // 丢弃全部暂存写入
+        void rollback();
+
+    private:
+        Vfs&                         vfs_;
+        std::unique_lock<osp::TimedMutex> lock_;
+        bool                              active_{true};
     };
 
+private:
     // --- 低层工具函数：块读写 & inode/位图管理 ---
     bool loadSuperBlock();
     bool flushSuperBlock();
     bool formatNewFileSystem();
 
+    // 把旧版（v1 44 字节 / v2 48 字节）inode 表原地改写为当前布局，并把已有小文件改为内联存放
+    bool migrateInodeTable();
+
+    // 遍历整棵目录树，为旧版目录项（type == Unknown）补齐文件类型
+    bool upgradeDirEntryTypes();
+
+    // 读取 <backingFile>.warm 并预取其中的块，返回放入缓存的块数
+    std::size_t prefetchWarmSet();
+
+    // 按 sb_ 打开条带成员（单文件镜像只设置布局）；条带镜像的成员缺失或不匹配时返回 false
+    bool attachStripeSet();
+
+    // 把已挂载的单文件镜像转换为 setStripe 指定的条带布局：先写好各成员与新的主文件（临时文件），
+    // 全部落盘后再替换主 backing file，中途失败或崩溃时原镜像保持不变
+    bool restripe();
+
+    // 归档包中 path 对应的条目：只在热镜像中找不到时使用；packBypass_ 为真或所在子树已复制回热镜像时返回 nullptr
+    const PackFile::Entry* archivedEntry(const std::string& path) const;
+
+    // 写操作前调用：path 落在归档子树内时先把整棵子树复制回热镜像
+    bool unarchiveFor(const std::string& path);
+
+    // 先 fdatasync 热镜像，再生成不含 unarchived_ 中子树的新归档包并重新映射
+    bool dropUnarchived();
+
+    // 归档时收集 / 删除热镜像中的子树（需在 packBypass_ 下调用）
+    bool collectSubtree(const std::string& path, bool root, PackFile::Builder& builder, ArchiveResult& result);
+    bool removeSubtree(const std::string& path);
+
+    // 按 setStripe 的配置生成条带表（路径过长或成员过多时返回 std::nullopt）
+    std::optional<StripeTable> makeStripeTable() const;
+
+    // 把条带表中的成员路径解析为实际路径，[0] 为主 backing file
+    std::vector<std::string> stripeMemberPaths(const StripeTable& table, std::uint32_t count) const;
+
+    // 事务进行中时 readBlock 优先返回暂存块，writeBlock 只写入暂存区
     std::vector<std::byte> readBlock(std::uint32_t blockId);
     bool writeBlock(std::uint32_t blockId, const std::vector<std::byte>& data);
 
+    // 批量版 readBlock：未命中的块经 StripedDevice::readBlocks 一次读取（相邻块合并，不同成员并行），
+    // 返回与 ids 一一对应的块，读失败的为空
+    std::vector<std::vector<std::byte>> readBlocks(const std::vector<std::uint32_t>& ids);
+
+    // --- 事务（见 Transaction） ---
+    void beginTransaction();
+    bool commitTransaction();
+    void rollbackTransaction();
+
     bool loadInode(std::uint32_t id, Inode& out);
     bool storeInode(const Inode& ino);
 
     bool allocDataBlock(std::uint32_t& outBlockId);
     bool freeDataBlock(std::uint32_t blockId);
 
+    // 直接设置/清除某个数据块在空闲位图中的占用位
+    bool setDataBlockBit(std::uint32_t blockId, bool used);
+
+    // 读取整个空闲位图，used[i] 对应数据块 dataBlockStart + i
+    bool loadDataBitmap(std::vector<bool>& used);
+
+    // 查找 count 个连续空闲数据块，优先选择 goal 之后最近的位置
+    bool findFreeRun(std::uint32_t count, std::uint32_t goal, std::uint32_t& outStart);
+
+    // 把文件的全部数据块搬到从 start 开始的连续空闲块（调用方保证这些块空闲）；
+    // 复制数据后与改写 inode 后各 fdatasync 一次，之后才释放旧块
+    bool relocateFile(Inode& ino, std::uint32_t start);
+
+    // 对给定数据块所在区间打洞（不改变文件逻辑大小）；调用方需保证释放这些块的修改已经落盘
+    void punchHoles(const std::set<std::uint32_t>& blockIds);
+
     bool findFreeInode(std::uint32_t& outInodeId);
 
+    // 当前镜像布局是否支持内联数据，且 size 字节放得进 inode 的内联区
+    [[nodiscard]] bool canInline(std::size_t size) const noexcept;
+
+    // 把 data 整体内联存放到 ino 中（释放原有数据块）并写回 inode
+    bool storeInline(Inode& ino, const std::string& data);
+
+    // 把 data 写入 ino 的 [offset, offset + data.size()) 区间，只读写受影响的块；
+    // 成功后更新 ino.size 并写回 inode。
+    bool writeRange(Inode& ino, std::size_t offset, const std::string& data);
+
+    // 读取 ino 的 [offset, offset + length) 区间，调用方需保证区间不超过 ino.size
+    std::optional<std::string> readRange(const Inode& ino, std::size_t offset, std::size_t length);
+
     // --- 路径解析与目录操作 ---
 
     // 把 "/a/b/c" 切成 {"a","b","c"}，返回是否成功
@@ -95,6 +408,12 @@ private:
     // 解析绝对路径，返回末尾组件对应的 inodeId（不创建）
     bool resolvePath(const std::string& path, std::uint32_t& outInodeId);
 
+    // 逐级解析 comps 的前 count 段；事务内会复用并记录已解析的前缀
+    bool resolveComponents(const std::vector<std::string>& comps, std::size_t count, std::uint32_t& outInodeId);
+
+    // 删除路径后使事务内缓存的该路径及其子路径的解析结果失效
+    void forgetResolved(const std::string& path);
+
     // 解析父目录路径，得到父目录 inodeId 和最后一段名字（用于创建）
     bool resolveParentDirectory(const std::string& path,
                                 std::uint32_t& outParentInodeId,
@@ -104,13 +423,42 @@ private:
     bool readDirectory(const Inode& dirInode, std::vector<DirEntry>& entries);
 
     // 写回目录内容（仅使用 directBlocks[0]，不支持超过一个块的超大目录）
-    bool writeDirectory(Inode& dirInode, const std::vector<DirEntry>& entries);
+    // touchMtime 为 false 时不更新目录的 mtime（用于格式升级等非用户修改）
+    bool writeDirectory(Inode& dirInode, const std::vector<DirEntry>& entries, bool touchMtime = true);
 
 private:
     SuperBlock sb_{};
     BlockCache cache_;
     std::string backingFile_;
-    std::fstream file_;
+    StripedDevice            device_;
+    bool                     directIoRequested_{false};
+    std::vector<std::string> stripeMembers_;      // setStripe 配置，或当前条带镜像的成员（供 RESTORE 后沿用）
+    std::uint32_t            stripeUnitBlocks_{1};
+
+    // 冷数据归档包与其覆盖状态
+    PackFile              pack_;
+    std::set<std::string> unarchived_;   // 已复制回热镜像、待从归档包移除的子树根
+    std::set<std::string> txUnarchived_; // 其中本事务新增的（回滚时撤销）
+    bool                  packBypass_{false};
+    std::uint64_t         archivedRoots_{0};
+    std::uint64_t         restoredRoots_{0};
+
+    // 事务状态：暂存块按块号存放，提交时按依赖顺序写回；路径缓存的键为规范化路径（如 "/papers/3"）
+    bool                                            inTransaction_{false};
+    std::map<std::uint32_t, std::vector<std::byte>> txDirtyBlocks_;
+    std::set<std::uint32_t>                         txDirBlocks_;   // 其中的目录块（提交时最后写回）
+    std::unordered_map<std::string, std::uint32_t>  txResolved_;
+    std::set<std::uint32_t>                         txFreedBlocks_; // 事务内释放、提交后转入 pendingPunches_ 的块
+
+    std::set<std::uint32_t> pendingPunches_; // 已释放、等待下一次 fdatasync 之后打洞的块（重新分配时移除）
+
+    bool punchHoles_{false};
+    bool readOnly_{false};
+    bool warmCache_{true};
+
+    DefragStats defragStats_{};
+
+    BlockTraceWriter blockTrace_;
 };
 
 } // namespace osp::fs
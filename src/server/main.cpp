@@ -1,8 +1,15 @@
 #include "server_app.hpp"
 
+#include "common/logger.hpp"
+#include "common/trace.hpp"
+
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace
 {
@@ -22,6 +29,16 @@ std::size_t parseSizeOrDefault(const char* s, std::size_t def)
     }
 }
 
+bool parseFlagOrDefault(const char* s, bool def)
+{
+    if (!s || *s == '\0')
+    {
+        return def;
+    }
+    const std::string v{s};
+    return v == "1" || v == "true" || v == "on" || v == "yes";
+}
+
 std::uint16_t parsePortOrDefault(const char* s, std::uint16_t def)
 {
     if (!s || *s == '\0')
@@ -43,10 +60,34 @@ std::uint16_t parsePortOrDefault(const char* s, std::uint16_t def)
 
 int main(int argc, char** argv)
 {
-    // 用法：osproj_server [port] [cacheCapacity]
-    // 也可通过环境变量 OSP_CACHE_CAPACITY 覆盖默认缓存容量。
+    // 用法：osproj_server [port] [cacheCapacity] [threadPoolSize]
+    // 也可通过环境变量 OSP_CACHE_CAPACITY / OSP_THREADS 覆盖默认缓存容量（块数）与线程池大小；
+    // OSP_CACHE_BYTES=<size>（如 512M、2G）直接按字节设置缓存预算，优先于块数；
+    // OSP_CACHE_AUTO=<min>:<max>（如 16M:4G）在该范围内自动调节缓存预算；
+    // OSP_PUNCH_HOLES=1 时释放的数据块会在 backing file 中打洞；
+    // OSP_DURABILITY=async|sync|group[:<ms>[:<n>]] 设置写命令的持久化级别（默认 async，见 README）；
+    // OSP_DIRECT_IO=1 时以 O_DIRECT 读写 backing file（不经过内核页缓存，BlockCache 为唯一缓存）；
+    // OSP_STRIPE=<file>[,<file>...] 把数据块按条带分布到 data.fs 与这些文件上（可位于不同磁盘），
+    // OSP_STRIPE_UNIT=<blocks> 设置条带单元的块数（默认 1）；
+    // OSP_DEFRAG=1 时开启后台碎片整理线程（默认关闭）；
+    // OSP_TIER_INTERVAL=<秒> 开启后台冷数据归档并设置检查间隔（默认 0，即关闭），
+    // OSP_TIER_MIN_AGE=<秒> 设置已定稿论文多久未修改后归档（默认 3600）；
+    // OSP_METRICS_PORT=<port> 时在 127.0.0.1:<port>/metrics 提供 Prometheus 指标；
+    // OSP_LOCK_SAMPLE=<N> 设置锁竞争分析的采样间隔（每线程每 N 次加锁采样一次，0 关闭，默认 64）；
+    // OSP_TRACE=1 时启动即开始记录请求追踪（需以 -DOSP_ENABLE_TRACING=ON 编译，也可用 TRACE ON 开启）；
+    // OSP_BLOCK_TRACE=<file> 时挂载后即开始录制块访问追踪（供 osproj_cachesim 分析）；
+    // OSP_LOG_LEVEL=debug|info|warn|error 设置日志级别阈值（默认 info），日志由后台线程异步写出；
+    // OSP_SLOW_REQUEST_MS=<ms> 设置慢请求日志阈值（默认 100，SLOW_LOG 命令查看）；
+    // OSP_WARM_CACHE=0 时不保存 / 预取缓存预热集合（data.fs.warm）。
+    if (const char* level = std::getenv("OSP_LOG_LEVEL"))
+    {
+        osp::setLogLevel(osp::parseLogLevel(level, osp::LogLevel::Info));
+    }
+    osp::startAsyncLogging();
+
     std::uint16_t port = 5555;
     std::size_t   cacheCapacity = parseSizeOrDefault(std::getenv("OSP_CACHE_CAPACITY"), 64);
+    std::size_t   threadPoolSize = parseSizeOrDefault(std::getenv("OSP_THREADS"), 4);
 
     if (argc >= 2)
     {
@@ -56,9 +97,88 @@ int main(int argc, char** argv)
     {
         cacheCapacity = parseSizeOrDefault(argv[2], cacheCapacity);
     }
+    if (argc >= 4)
+    {
+        threadPoolSize = parseSizeOrDefault(argv[3], threadPoolSize);
+    }
+    // 连接为长连接，每个工作线程同一时刻只服务一个客户端，至少保留 1 个
+    threadPoolSize = std::max<std::size_t>(threadPoolSize, 1);
+
+    // 块数按 4096 字节的数据块（含每项开销）换算为字节预算
+    std::size_t cacheBytes = cacheCapacity * osp::fs::BlockCache::entryCost(4096);
+    if (const char* s = std::getenv("OSP_CACHE_BYTES"); s && *s != '\0')
+    {
+        if (const auto bytes = osp::fs::parseByteSize(s))
+        {
+            cacheBytes = *bytes;
+        }
+        else
+        {
+            OSP_LOG(osp::LogLevel::Warn, std::string("Ignoring invalid OSP_CACHE_BYTES=") + s);
+        }
+    }
 
-    osp::server::ServerApp app(port, cacheCapacity);
+    osp::server::ServerApp app(port, cacheBytes, threadPoolSize);
+    if (const char* s = std::getenv("OSP_CACHE_AUTO"); s && *s != '\0')
+    {
+        const std::string_view v{s};
+        const auto             colon = v.find(':');
+        const auto minBytes = colon == std::string_view::npos ? std::nullopt : osp::fs::parseByteSize(v.substr(0, colon));
+        const auto maxBytes = colon == std::string_view::npos ? std::nullopt : osp::fs::parseByteSize(v.substr(colon + 1));
+        if (minBytes && maxBytes && *minBytes <= *maxBytes)
+        {
+            app.setCacheAutoTune(*minBytes, *maxBytes);
+        }
+        else
+        {
+            OSP_LOG(osp::LogLevel::Warn, std::string("Ignoring invalid OSP_CACHE_AUTO=") + s + " (expected <min>:<max>)");
+        }
+    }
+    app.setPunchHoles(parseFlagOrDefault(std::getenv("OSP_PUNCH_HOLES"), false));
+    app.setDirectIo(parseFlagOrDefault(std::getenv("OSP_DIRECT_IO"), false));
+    if (const char* s = std::getenv("OSP_STRIPE"); s && *s != '\0')
+    {
+        std::vector<std::string> members;
+        std::string_view         rest{s};
+        while (!rest.empty())
+        {
+            const auto comma = rest.find(',');
+            const auto item = rest.substr(0, comma);
+            if (!item.empty())
+            {
+                members.emplace_back(item);
+            }
+            rest = comma == std::string_view::npos ? std::string_view{} : rest.substr(comma + 1);
+        }
+        app.setStripe(std::move(members),
+                      static_cast<std::uint32_t>(parseSizeOrDefault(std::getenv("OSP_STRIPE_UNIT"), 1)));
+    }
+    if (const char* s = std::getenv("OSP_DURABILITY"); s && *s != '\0')
+    {
+        if (const auto durability = osp::fs::parseDurability(s))
+        {
+            app.setDurability(*durability);
+        }
+        else
+        {
+            OSP_LOG(osp::LogLevel::Warn, std::string("Ignoring invalid OSP_DURABILITY=") + s);
+        }
+    }
+    app.setBackgroundDefrag(parseFlagOrDefault(std::getenv("OSP_DEFRAG"), false));
+    app.setTiering(static_cast<std::uint32_t>(parseSizeOrDefault(std::getenv("OSP_TIER_INTERVAL"), 0)),
+                   static_cast<std::uint32_t>(parseSizeOrDefault(std::getenv("OSP_TIER_MIN_AGE"), 3600)));
+    app.setWarmCache(parseFlagOrDefault(std::getenv("OSP_WARM_CACHE"), true));
+    app.setMetricsPort(parsePortOrDefault(std::getenv("OSP_METRICS_PORT"), 0));
+    osp::TimedMutex::sampleEvery().store(
+        static_cast<std::uint32_t>(parseSizeOrDefault(std::getenv("OSP_LOCK_SAMPLE"), 64)));
+    osp::trace::setEnabled(parseFlagOrDefault(std::getenv("OSP_TRACE"), false));
+    app.setSlowRequestThresholdMs(parseSizeOrDefault(std::getenv("OSP_SLOW_REQUEST_MS"), 100));
+    if (const char* blockTrace = std::getenv("OSP_BLOCK_TRACE"))
+    {
+        app.setBlockTracePath(blockTrace);
+    }
     app.run();
+    osp::stopAsyncLogging();
     return 0;
 }
 
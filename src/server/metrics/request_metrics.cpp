@@ -0,0 +1,346 @@
+#include "request_metrics.hpp"
+
+#include "common/timed_mutex.hpp"
+#include "server/filesystem/vfs.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace osp::server
+{
+namespace
+{
+// 与 ServerApp::handleCommand 中的命令一一对应，最后一项 OTHER 收纳未知命令
+constexpr std::array<std::string_view, 39> kCommandNames{
+    "PING", "LOGIN", "LIST_PAPERS", "SUBMIT", "GET_PAPER", "ASSIGN", "REVIEW", "LIST_REVIEWS",
+    "DECISION", "REVISE", "SET_PAPER_FIELDS", "SEARCH", "RECOMMEND_REVIEWERS", "ASSIGN_REVIEWER",
+    "VIEW_REVIEW_STATUS", "MAKE_FINAL_DECISION", "MANAGE_USERS", "BACKUP", "RESTORE", "COMPACT",
+    "VIEW_SYSTEM_STATUS", "METRICS", "LOCK_PROFILE", "SLOW_LOG", "CACHE_CONFIG", "ARCHIVE", "TRACE", "BLOCK_TRACE", "EVENTS", "WATCH", "MKDIR", "WRITE", "APPEND", "READ", "STAT",
+    "RM", "RMDIR", "LIST", "OTHER"};
+
+// Prometheus histogram 的桶边界（微秒）；LatencyHistogram 的桶更细，导出时按上界归并
+constexpr std::array<std::uint64_t, 14> kPrometheusBucketsUs{
+    50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000};
+
+std::atomic<std::uint64_t> nextInstanceId{1};
+
+// 分片只由所属线程写入，用 load + store 代替 fetch_add，避免带 lock 前缀的原子指令
+void bump(std::atomic<std::uint64_t>& counter, std::uint64_t delta) noexcept
+{
+    counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+std::uint64_t nanosToMicros(std::uint64_t nanos) noexcept
+{
+    return nanos / 1000;
+}
+
+std::string formatSeconds(double seconds)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", seconds);
+    return buf;
+}
+
+std::string formatLe(std::uint64_t micros)
+{
+    return formatSeconds(static_cast<double>(micros) / 1e6);
+}
+} // namespace
+
+RequestMetrics::RequestMetrics()
+    : instanceId_(nextInstanceId.fetch_add(1, std::memory_order_relaxed))
+    , started_(std::chrono::steady_clock::now())
+    , histograms_(std::make_unique<Histograms[]>(kCommandCount))
+{
+    static_assert(kCommandNames.size() == kCommandCount, "kCommandNames out of sync with kCommandCount");
+}
+
+RequestMetrics::Probe RequestMetrics::begin() noexcept
+{
+    const auto& waits = osp::TimedMutex::threadWaitStats();
+    const auto& io = osp::fs::Vfs::threadIoCounters();
+
+    Probe p;
+    p.start = std::chrono::steady_clock::now();
+    p.lockAcquisitions = waits.acquisitions;
+    p.lockWaitNanos = waits.waitNanos;
+    p.lockContended = waits.contended;
+    p.blockReads = io.blockReads;
+    p.diskReads = io.diskReads;
+    p.blockWrites = io.blockWrites;
+    p.vfsCalls = io.vfsCalls;
+    return p;
+}
+
+RequestMetrics::Sample RequestMetrics::finish(const Probe& probe) noexcept
+{
+    const auto  end = std::chrono::steady_clock::now();
+    const auto& waits = osp::TimedMutex::threadWaitStats();
+    const auto& io = osp::fs::Vfs::threadIoCounters();
+
+    Sample s;
+    s.durationNs = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - probe.start).count());
+    s.lockAcquisitions = waits.acquisitions - probe.lockAcquisitions;
+    s.lockWaitNanos = waits.waitNanos - probe.lockWaitNanos;
+    s.lockContended = waits.contended - probe.lockContended;
+    s.blockReads = io.blockReads - probe.blockReads;
+    s.diskReads = io.diskReads - probe.diskReads;
+    s.blockWrites = io.blockWrites - probe.blockWrites;
+    s.vfsCalls = io.vfsCalls - probe.vfsCalls;
+    return s;
+}
+
+void RequestMetrics::record(std::string_view command, const Sample& sample, bool error)
+{
+    const auto index = commandIndex(command);
+
+    auto& c = localShard().commands[index];
+    bump(c.requests, 1);
+    if (error)
+    {
+        bump(c.errors, 1);
+    }
+    bump(c.lockAcquisitions, sample.lockAcquisitions);
+    bump(c.lockWaitNanos, sample.lockWaitNanos);
+    bump(c.lockContended, sample.lockContended);
+    bump(c.blockReads, sample.blockReads);
+    bump(c.diskReads, sample.diskReads);
+    bump(c.blockWrites, sample.blockWrites);
+
+    auto& h = histograms_[index];
+    h.latencyUs.record(nanosToMicros(sample.durationNs));
+    h.lockWaitUs.record(nanosToMicros(sample.lockWaitNanos));
+}
+
+osp::protocol::json RequestMetrics::toJson() const
+{
+    using osp::protocol::json;
+
+    const auto sums = totals();
+
+    json commands = json::object();
+    std::uint64_t totalRequests = 0;
+    std::uint64_t totalErrors = 0;
+    for (std::size_t i = 0; i < kCommandCount; ++i)
+    {
+        const auto& t = sums[i];
+        const auto& h = histograms_[i];
+        if (t.requests == 0 && h.latencyUs.count() == 0)
+        {
+            continue;
+        }
+        totalRequests += t.requests;
+        totalErrors += t.errors;
+
+        const double n = t.requests == 0 ? 1.0 : static_cast<double>(t.requests);
+        commands[std::string(kCommandNames[i])] = {
+            {"count", t.requests},
+            {"errors", t.errors},
+            {"latencyUs", {
+                {"mean", h.latencyUs.mean()},
+                {"p50", h.latencyUs.percentile(50)},
+                {"p90", h.latencyUs.percentile(90)},
+                {"p99", h.latencyUs.percentile(99)},
+                {"p999", h.latencyUs.percentile(99.9)},
+                {"max", h.latencyUs.max()}
+            }},
+            {"lockWait", {
+                {"acquisitions", t.lockAcquisitions},
+                {"acquisitionsPerRequest", static_cast<double>(t.lockAcquisitions) / n},
+                {"contended", t.lockContended},
+                {"totalUs", nanosToMicros(t.lockWaitNanos)},
+                {"p99Us", h.lockWaitUs.percentile(99)},
+                {"maxUs", h.lockWaitUs.max()}
+            }},
+            {"blockReads", t.blockReads},
+            {"diskReads", t.diskReads},
+            {"blockWrites", t.blockWrites},
+            {"blockReadsPerRequest", static_cast<double>(t.blockReads) / n},
+            {"blockWritesPerRequest", static_cast<double>(t.blockWrites) / n}
+        };
+    }
+
+    return {
+        {"uptimeSeconds", std::chrono::duration_cast<std::chrono::seconds>(
+                              std::chrono::steady_clock::now() - started_).count()},
+        {"requests", totalRequests},
+        {"errors", totalErrors},
+        {"commands", commands}
+    };
+}
+
+std::string RequestMetrics::toPrometheus() const
+{
+    const auto sums = totals();
+
+    std::string out;
+    out.reserve(16 * 1024);
+
+    auto counterFamily = [&](const char* name, const char* help, auto value) {
+        out += "# HELP ";
+        out += name;
+        out += ' ';
+        out += help;
+        out += "\n# TYPE ";
+        out += name;
+        out += " counter\n";
+        for (std::size_t i = 0; i < kCommandCount; ++i)
+        {
+            if (sums[i].requests == 0)
+            {
+                continue;
+            }
+            out += name;
+            out += "{command=\"";
+            out += kCommandNames[i];
+            out += "\"} ";
+            out += value(sums[i]);
+            out += '\n';
+        }
+    };
+
+    out += "# HELP osp_request_duration_seconds Time spent handling a request, by command.\n"
+           "# TYPE osp_request_duration_seconds histogram\n";
+    for (std::size_t i = 0; i < kCommandCount; ++i)
+    {
+        const auto& h = histograms_[i].latencyUs;
+        if (h.count() == 0)
+        {
+            continue;
+        }
+
+        // LatencyHistogram 的桶上界落在 le 之内即计入该 le（累计分布）
+        std::array<std::uint64_t, kPrometheusBucketsUs.size()> cumulative{};
+        std::uint64_t                                           total = 0;
+        h.forEachBucket([&](std::uint64_t upperBound, std::uint64_t count) {
+            total += count;
+            for (std::size_t b = 0; b < kPrometheusBucketsUs.size(); ++b)
+            {
+                if (upperBound <= kPrometheusBucketsUs[b])
+                {
+                    cumulative[b] += count;
+                }
+            }
+        });
+
+        const std::string label = std::string("command=\"") + std::string(kCommandNames[i]) + "\"";
+        for (std::size_t b = 0; b < kPrometheusBucketsUs.size(); ++b)
+        {
+            out += "osp_request_duration_seconds_bucket{" + label + ",le=\"" + formatLe(kPrometheusBucketsUs[b])
+                   + "\"} " + std::to_string(cumulative[b]) + "\n";
+        }
+        out += "osp_request_duration_seconds_bucket{" + label + ",le=\"+Inf\"} " + std::to_string(total) + "\n";
+        out += "osp_request_duration_seconds_sum{" + label + "} "
+               + formatSeconds(static_cast<double>(h.sum()) / 1e6) + "\n";
+        out += "osp_request_duration_seconds_count{" + label + "} " + std::to_string(total) + "\n";
+    }
+
+    counterFamily("osp_request_errors_total", "Requests answered with an error response.",
+                  [](const Totals& t) { return std::to_string(t.errors); });
+    counterFamily("osp_request_lock_acquisitions_total", "Acquisitions of vfsMutex_/authMutex_.",
+                  [](const Totals& t) { return std::to_string(t.lockAcquisitions); });
+    counterFamily("osp_request_lock_wait_seconds_total", "Time spent waiting for vfsMutex_/authMutex_.",
+                  [](const Totals& t) { return formatSeconds(static_cast<double>(t.lockWaitNanos) / 1e9); });
+    counterFamily("osp_request_lock_contended_total", "Lock acquisitions that had to wait.",
+                  [](const Totals& t) { return std::to_string(t.lockContended); });
+    counterFamily("osp_request_block_reads_total", "Vfs block reads, including cache hits.",
+                  [](const Totals& t) { return std::to_string(t.blockReads); });
+    counterFamily("osp_request_disk_reads_total", "Vfs block reads that missed the cache.",
+                  [](const Totals& t) { return std::to_string(t.diskReads); });
+    counterFamily("osp_request_block_writes_total", "Blocks written to the backing file.",
+                  [](const Totals& t) { return std::to_string(t.blockWrites); });
+
+    out += "# HELP osp_uptime_seconds Seconds since the server started.\n"
+           "# TYPE osp_uptime_seconds gauge\n"
+           "osp_uptime_seconds "
+           + std::to_string(std::chrono::duration_cast<std::chrono::seconds>(
+                                std::chrono::steady_clock::now() - started_).count())
+           + "\n";
+    return out;
+}
+
+void RequestMetrics::reset()
+{
+    {
+        std::lock_guard<std::mutex> lock(shardsMutex_);
+        for (auto& shard : shards_)
+        {
+            for (auto& c : shard->commands)
+            {
+                c.requests.store(0, std::memory_order_relaxed);
+                c.errors.store(0, std::memory_order_relaxed);
+                c.lockAcquisitions.store(0, std::memory_order_relaxed);
+                c.lockWaitNanos.store(0, std::memory_order_relaxed);
+                c.lockContended.store(0, std::memory_order_relaxed);
+                c.blockReads.store(0, std::memory_order_relaxed);
+                c.diskReads.store(0, std::memory_order_relaxed);
+                c.blockWrites.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+    for (std::size_t i = 0; i < kCommandCount; ++i)
+    {
+        histograms_[i].latencyUs.reset();
+        histograms_[i].lockWaitUs.reset();
+    }
+}
+
+std::string_view RequestMetrics::commandName(std::string_view command) noexcept
+{
+    return kCommandNames[commandIndex(command)];
+}
+
+std::size_t RequestMetrics::commandIndex(std::string_view command) noexcept
+{
+    for (std::size_t i = 0; i + 1 < kCommandCount; ++i)
+    {
+        if (kCommandNames[i] == command)
+        {
+            return i;
+        }
+    }
+    return kCommandCount - 1;
+}
+
+RequestMetrics::Shard& RequestMetrics::localShard()
+{
+    // 每个线程缓存自己在哪个实例上注册的分片；用实例编号而不是地址判断，避免实例重建后误用旧分片
+    thread_local std::uint64_t ownerId = 0;
+    thread_local Shard*        shard = nullptr;
+
+    if (ownerId != instanceId_)
+    {
+        std::lock_guard<std::mutex> lock(shardsMutex_);
+        shards_.push_back(std::make_unique<Shard>());
+        shard = shards_.back().get();
+        ownerId = instanceId_;
+    }
+    return *shard;
+}
+
+std::array<RequestMetrics::Totals, RequestMetrics::kCommandCount> RequestMetrics::totals() const
+{
+    std::array<Totals, kCommandCount> sums{};
+    std::lock_guard<std::mutex>       lock(shardsMutex_);
+    for (const auto& shard : shards_)
+    {
+        for (std::size_t i = 0; i < kCommandCount; ++i)
+        {
+            const auto& c = shard->commands[i];
+            auto&       t = sums[i];
+            t.requests += c.requests.load(std::memory_order_relaxed);
+            t.errors += c.errors.load(std::memory_order_relaxed);
+            t.lockAcquisitions += c.lockAcquisitions.load(std::memory_order_relaxed);
+            t.lockWaitNanos += c.lockWaitNanos.load(std::memory_order_relaxed);
+            t.lockContended += c.lockContended.load(std::memory_order_relaxed);
+            t.blockReads += c.blockReads.load(std::memory_order_relaxed);
+            t.diskReads += c.diskReads.load(std::memory_order_relaxed);
+            t.blockWrites += c.blockWrites.load(std::memory_order_relaxed);
+        }
+    }
+    return sums;
+}
+
+} // namespace osp::server
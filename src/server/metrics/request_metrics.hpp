@@ -0,0 +1,133 @@
+#pragma once
+
+#include "common/latency_histogram.hpp"
+#include "common/protocol.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace osp::server
+{
+
+// 按命令统计的请求指标：处理耗时、锁等待、块读写次数与错误数。
+// - 延迟与锁等待使用共享的 LatencyHistogram（原子桶，记录无锁）；
+// - 计数器按线程分片：每个工作线程只写自己的分片，读取（METRICS / Prometheus）时再把所有分片相加，
+//   热路径上没有跨线程共享的写入。
+class RequestMetrics
+{
+public:
+    // 请求开始时的快照：起始时间 + 当前线程的锁等待与块 IO 累计值
+    struct Probe
+    {
+        std::chrono::steady_clock::time_point start;
+        std::uint64_t                         lockAcquisitions{0};
+        std::uint64_t                         lockWaitNanos{0};
+        std::uint64_t                         lockContended{0};
+        std::uint64_t                         blockReads{0};
+        std::uint64_t                         diskReads{0};
+        std::uint64_t                         blockWrites{0};
+        std::uint64_t                         vfsCalls{0};
+    };
+
+    // 单个请求的开销：请求结束时的累计值与 Probe 之差
+    struct Sample
+    {
+        std::uint64_t durationNs{0};
+        std::uint64_t lockAcquisitions{0};
+        std::uint64_t lockWaitNanos{0};
+        std::uint64_t lockContended{0};
+        std::uint64_t blockReads{0};
+        std::uint64_t diskReads{0};
+        std::uint64_t blockWrites{0};
+        std::uint64_t vfsCalls{0};
+        std::uint64_t syncWaitNanos{0}; // 应答前等待落盘的时间（由调用方填写，包含在 durationNs 中）
+    };
+
+    RequestMetrics();
+
+    RequestMetrics(const RequestMetrics&) = delete;
+    RequestMetrics& operator=(const RequestMetrics&) = delete;
+
+    [[nodiscard]] static Probe begin() noexcept;
+
+    // 请求结束时调用：取当前线程的累计值与 probe 的差
+    [[nodiscard]] static Sample finish(const Probe& probe) noexcept;
+
+    // 规范化的命令名（静态存储，未知命令为 "OTHER"），可用作 TimedMutex::ScopedTag 的标签
+    [[nodiscard]] static std::string_view commandName(std::string_view command) noexcept;
+
+    // 把一次请求的开销计入 command 对应的统计（未知命令计入 OTHER）
+    void record(std::string_view command, const Sample& sample, bool error);
+
+    // METRICS 命令的返回数据（只包含有请求的命令）
+    [[nodiscard]] osp::protocol::json toJson() const;
+
+    // Prometheus 文本格式（text/plain; version=0.0.4）
+    [[nodiscard]] std::string toPrometheus() const;
+
+    // 清零全部统计（与并发的 record() 之间只保证近似一致）
+    void reset();
+
+private:
+    static constexpr std::size_t kCommandCount = 39; // 已知命令数 + OTHER
+
+    struct Counters
+    {
+        std::atomic<std::uint64_t> requests{0};
+        std::atomic<std::uint64_t> errors{0};
+        std::atomic<std::uint64_t> lockAcquisitions{0};
+        std::atomic<std::uint64_t> lockWaitNanos{0};
+        std::atomic<std::uint64_t> lockContended{0};
+        std::atomic<std::uint64_t> blockReads{0};
+        std::atomic<std::uint64_t> diskReads{0};
+        std::atomic<std::uint64_t> blockWrites{0};
+    };
+
+    // 一个线程的全部计数器；由 shards_ 持有，线程退出后计数仍保留
+    struct Shard
+    {
+        std::array<Counters, kCommandCount> commands;
+    };
+
+    struct Histograms
+    {
+        LatencyHistogram latencyUs;
+        LatencyHistogram lockWaitUs;
+    };
+
+    // 合并所有分片后的计数快照
+    struct Totals
+    {
+        std::uint64_t requests{0};
+        std::uint64_t errors{0};
+        std::uint64_t lockAcquisitions{0};
+        std::uint64_t lockWaitNanos{0};
+        std::uint64_t lockContended{0};
+        std::uint64_t blockReads{0};
+        std::uint64_t diskReads{0};
+        std::uint64_t blockWrites{0};
+    };
+
+    static std::size_t commandIndex(std::string_view command) noexcept;
+
+    Shard&                            localShard();
+    std::array<Totals, kCommandCount> totals() const;
+
+    const std::uint64_t                         instanceId_;
+    const std::chrono::steady_clock::time_point started_;
+
+    mutable std::mutex                  shardsMutex_; // 只在线程首次记录（注册分片）与读取时使用
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    std::unique_ptr<Histograms[]> histograms_; // kCommandCount 个，放在堆上（每个直方图约 18KB）
+};
+
+} // namespace osp::server
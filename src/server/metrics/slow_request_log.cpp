@@ -0,0 +1,122 @@
+#include "server/metrics/slow_request_log.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace osp::server
+{
+
+SlowRequestLog::SlowRequestLog(std::size_t capacity, std::uint64_t thresholdUs)
+    : capacity_(std::max<std::size_t>(capacity, 1))
+    , thresholdUs_(thresholdUs)
+    , ring_(capacity_)
+{
+}
+
+void SlowRequestLog::maybeRecord(std::string_view command, const std::vector<std::string>& args, std::string_view role,
+                                 bool error, const RequestMetrics::Sample& sample)
+{
+    if (sample.durationNs / 1000 < thresholdUs_.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    // 锁外完成脱敏与拷贝，临界区只做一次移动
+    SlowRequest entry;
+    entry.timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::system_clock::now().time_since_epoch())
+                            .count();
+    entry.command = std::string(command);
+    entry.args = redactArgs(command, args);
+    entry.role = std::string(role);
+    entry.error = error;
+    entry.sample = sample;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    entry.seq = ++lastSeq_;
+    ring_[entry.seq % capacity_] = std::move(entry);
+}
+
+osp::protocol::json SlowRequestLog::toJson() const
+{
+    using osp::protocol::json;
+
+    json entries = json::array();
+    std::uint64_t recorded = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        recorded = lastSeq_ - clearedSeq_;
+        const std::uint64_t oldest = std::max<std::uint64_t>(
+            clearedSeq_ + 1, lastSeq_ >= capacity_ ? lastSeq_ - capacity_ + 1 : 1);
+        for (std::uint64_t s = lastSeq_; s >= oldest && s > 0; --s)
+        {
+            const auto& e = ring_[s % capacity_];
+            const auto& m = e.sample;
+            entries.push_back({
+                {"seq", e.seq},
+                {"timestampMs", e.timestampMs},
+                {"command", e.command},
+                {"args", e.args},
+                {"role", e.role},
+                {"error", e.error},
+                {"durationUs", m.durationNs / 1000},
+                {"lockAcquisitions", m.lockAcquisitions},
+                {"lockContended", m.lockContended},
+                {"lockWaitUs", m.lockWaitNanos / 1000},
+                {"cacheHits", m.blockReads - m.diskReads},
+                {"cacheMisses", m.diskReads},
+                {"blockWrites", m.blockWrites},
+                {"vfsCalls", m.vfsCalls},
+                {"syncWaitUs", m.syncWaitNanos / 1000}
+            });
+        }
+    }
+
+    return {
+        {"thresholdMs", static_cast<double>(thresholdUs()) / 1000.0},
+        {"capacity", capacity_},
+        {"recorded", recorded},
+        {"entries", std::move(entries)}
+    };
+}
+
+void SlowRequestLog::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    clearedSeq_ = lastSeq_;
+}
+
+std::vector<std::string> SlowRequestLog::redactArgs(std::string_view command, const std::vector<std::string>& args)
+{
+    std::vector<std::string> out;
+    out.reserve(args.size());
+    for (const auto& a : args)
+    {
+        if (a.size() <= kMaxArgBytes)
+        {
+            out.push_back(a);
+        }
+        else
+        {
+            out.push_back(a.substr(0, kMaxArgBytes) + "...(" + std::to_string(a.size()) + " bytes)");
+        }
+    }
+
+    // LOGIN <user> <password>；MANAGE_USERS ADD <user> <password> <role>；MANAGE_USERS RESET_PASSWORD <user> <password>
+    std::size_t secret = out.size();
+    if (command == "LOGIN")
+    {
+        secret = 1;
+    }
+    else if (command == "MANAGE_USERS" && !args.empty() && (args[0] == "ADD" || args[0] == "RESET_PASSWORD"))
+    {
+        secret = 2;
+    }
+    if (secret < out.size())
+    {
+        out[secret] = "***";
+    }
+    return out;
+}
+
+} // namespace osp::server
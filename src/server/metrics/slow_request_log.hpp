@@ -0,0 +1,62 @@
+#pragma once
+
+#include "common/protocol.hpp"
+#include "server/metrics/request_metrics.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace osp::server
+{
+
+// 一条慢请求记录：命令与参数（已脱敏、截断）、会话角色，以及该请求的开销明细
+struct SlowRequest
+{
+    std::uint64_t            seq{};         // 单调递增序号，从 1 开始
+    std::int64_t             timestampMs{}; // 完成时间（Unix 毫秒）
+    std::string              command;
+    std::vector<std::string> args;
+    std::string              role;          // 未登录时为空
+    bool                     error{false};
+    RequestMetrics::Sample   sample;
+};
+
+// 慢请求日志：处理时间超过阈值的请求写入固定容量的环形缓冲区，供 SLOW_LOG 命令查看。
+// 未超过阈值的请求只有一次原子读和一次比较；超过阈值的请求才格式化参数并加锁写入。
+class SlowRequestLog
+{
+public:
+    static constexpr std::size_t kMaxArgBytes = 64; // 单个参数最多保留的字节数
+
+    explicit SlowRequestLog(std::size_t capacity = 128, std::uint64_t thresholdUs = 100000);
+
+    void setThresholdUs(std::uint64_t us) noexcept { thresholdUs_.store(us, std::memory_order_relaxed); }
+    [[nodiscard]] std::uint64_t thresholdUs() const noexcept { return thresholdUs_.load(std::memory_order_relaxed); }
+
+    // 请求结束时调用；未超过阈值时直接返回
+    void maybeRecord(std::string_view command, const std::vector<std::string>& args, std::string_view role,
+                     bool error, const RequestMetrics::Sample& sample);
+
+    // 最近的慢请求（新的在前）与阈值、累计条数
+    [[nodiscard]] osp::protocol::json toJson() const;
+
+    void clear();
+
+    // 参数脱敏：LOGIN 的密码、MANAGE_USERS ADD / RESET_PASSWORD 的密码替换为 "***"，过长的参数截断
+    static std::vector<std::string> redactArgs(std::string_view command, const std::vector<std::string>& args);
+
+private:
+    std::size_t                 capacity_;
+    std::atomic<std::uint64_t>  thresholdUs_;
+    std::vector<SlowRequest>    ring_; // 大小固定为 capacity_，按 seq % capacity_ 存放
+    std::uint64_t               lastSeq_{0};
+    std::uint64_t               clearedSeq_{0}; // clear() 时的 lastSeq_，此前的记录不再返回
+    mutable std::mutex          mutex_;
+};
+
+} // namespace osp::server
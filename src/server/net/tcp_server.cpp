@@ -1,5 +1,7 @@
 #include "server/net/tcp_server.hpp"
 
+#include "common/trace.hpp"
+
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
@@ -29,7 +31,8 @@ bool TcpServer::sendAll(int fd, const void* buf, std::size_t len)
     std::size_t sent = 0;
     while (sent < len)
     {
-        const auto n = ::send(fd, p + sent, len - sent, 0);
+        // 对端已关闭（如 WATCH 客户端断开）时返回 EPIPE，而不是以 SIGPIPE 终止整个进程
+        const auto n = ::send(fd, p + sent, len - sent, MSG_NOSIGNAL);
         if (n <= 0)
         {
             return false;
@@ -57,7 +60,12 @@ bool TcpServer::recvAll(int fd, void* buf, std::size_t len)
 
 bool TcpServer::sendMessage(int fd, const osp::protocol::Message& msg)
 {
-    const std::string data = osp::protocol::serialize(msg);
+    OSP_TRACE_SPAN("TcpServer::sendMessage");
+    std::string data;
+    {
+        OSP_TRACE_SPAN("protocol::serialize");
+        data = osp::protocol::serialize(msg);
+    }
     std::uint32_t len = static_cast<std::uint32_t>(data.size());
     len = htonl(len);
     if (!sendAll(fd, &len, sizeof(len)))
@@ -80,6 +88,8 @@ std::optional<osp::protocol::Message> TcpServer::recvMessage(int fd)
         return std::nullopt;
     }
 
+    // 长度前缀之前是连接空闲等待，只追踪收到长度之后的正文接收与解析
+    OSP_TRACE_SPAN("TcpServer::recvMessage");
     std::string data;
     data.resize(len);
     if (!recvAll(fd, data.data(), data.size()))
@@ -87,12 +97,13 @@ std::optional<osp::protocol::Message> TcpServer::recvMessage(int fd)
         return std::nullopt;
     }
 
+    OSP_TRACE_SPAN("protocol::deserialize");
     return osp::protocol::deserialize(data);
 }
 
-void TcpServer::handleClient(int clientFd, const RequestHandler& handler)
+void TcpServer::handleClient(int clientFd, const RequestHandler& handler, const ConnectionHook& hook)
 {
-    osp::log(osp::LogLevel::Info, "TcpServer: handling client on fd " + std::to_string(clientFd));
+    OSP_LOG(osp::LogLevel::Info, "TcpServer: handling client on fd " + std::to_string(clientFd));
 
     // 循环处理该客户端的多个请求（支持持久连接）
     while (running_.load())
@@ -100,31 +111,38 @@ void TcpServer::handleClient(int clientFd, const RequestHandler& handler)
         auto maybeReq = recvMessage(clientFd);
         if (!maybeReq)
         {
-            osp::log(osp::LogLevel::Info, "TcpServer: client disconnected (fd " + std::to_string(clientFd) + ")");
+            OSP_LOG(osp::LogLevel::Info, "TcpServer: client disconnected (fd " + std::to_string(clientFd) + ")");
             break;
         }
 
         const auto& req = *maybeReq;
-        osp::log(osp::LogLevel::Debug, "TcpServer: received request from fd " + std::to_string(clientFd));
+        OSP_LOG(osp::LogLevel::Debug, "TcpServer: received request from fd " + std::to_string(clientFd));
+
+        if (hook && hook(clientFd, req))
+        {
+            // 连接已被接管，fd 的生命周期由接管方负责
+            OSP_LOG(osp::LogLevel::Info, "TcpServer: connection fd " + std::to_string(clientFd) + " handed off");
+            return;
+        }
 
         const auto resp = handler(req);
         if (!sendMessage(clientFd, resp))
         {
-            osp::log(osp::LogLevel::Warn, "TcpServer: failed to send response to fd " + std::to_string(clientFd));
+            OSP_LOG(osp::LogLevel::Warn, "TcpServer: failed to send response to fd " + std::to_string(clientFd));
             break;
         }
     }
 
     ::close(clientFd);
-    osp::log(osp::LogLevel::Debug, "TcpServer: closed client fd " + std::to_string(clientFd));
+    OSP_LOG(osp::LogLevel::Debug, "TcpServer: closed client fd " + std::to_string(clientFd));
 }
 
-void TcpServer::start(const RequestHandler& handler)
+void TcpServer::start(const RequestHandler& handler, const ConnectionHook& hook)
 {
     listenFd_ = ::socket(AF_INET, SOCK_STREAM, 0);
     if (listenFd_ < 0)
     {
-        osp::log(osp::LogLevel::Error, "TcpServer: failed to create socket");
+        OSP_LOG(osp::LogLevel::Error, "TcpServer: failed to create socket");
         return;
     }
 
@@ -138,7 +156,7 @@ void TcpServer::start(const RequestHandler& handler)
 
     if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
     {
-        osp::log(osp::LogLevel::Error, "TcpServer: bind failed");
+        OSP_LOG(osp::LogLevel::Error, "TcpServer: bind failed");
         ::close(listenFd_);
         listenFd_ = -1;
         return;
@@ -147,14 +165,14 @@ void TcpServer::start(const RequestHandler& handler)
     // 增加 backlog 以支持更多并发连接
     if (::listen(listenFd_, 128) < 0)
     {
-        osp::log(osp::LogLevel::Error, "TcpServer: listen failed");
+        OSP_LOG(osp::LogLevel::Error, "TcpServer: listen failed");
         ::close(listenFd_);
         listenFd_ = -1;
         return;
     }
 
     running_.store(true);
-    osp::log(osp::LogLevel::Info,
+    OSP_LOG(osp::LogLevel::Info,
              "TcpServer: listening on port " + std::to_string(port_)
                  + " with thread pool size " + std::to_string(poolSize_));
 
@@ -171,7 +189,7 @@ void TcpServer::start(const RequestHandler& handler)
         {
             if (running_.load())
             {
-                osp::log(osp::LogLevel::Warn, "TcpServer: accept failed");
+                OSP_LOG(osp::LogLevel::Warn, "TcpServer: accept failed");
             }
             continue;
         }
@@ -179,17 +197,17 @@ void TcpServer::start(const RequestHandler& handler)
         // 获取客户端地址信息
         char clientIp[INET_ADDRSTRLEN];
         inet_ntop(AF_INET, &clientAddr.sin_addr, clientIp, INET_ADDRSTRLEN);
-        osp::log(osp::LogLevel::Info,
+        OSP_LOG(osp::LogLevel::Info,
                  "TcpServer: accepted connection from " + std::string(clientIp)
                      + ":" + std::to_string(ntohs(clientAddr.sin_port)));
 
         // 提交到线程池处理
-        pool.enqueue([this, clientFd, &handler]() {
-            handleClient(clientFd, handler);
+        pool.enqueue([this, clientFd, &handler, &hook]() {
+            handleClient(clientFd, handler, hook);
         });
     }
 
-    osp::log(osp::LogLevel::Info, "TcpServer: stopped accepting connections");
+    OSP_LOG(osp::LogLevel::Info, "TcpServer: stopped accepting connections");
 }
 
 void TcpServer::stop()
@@ -210,7 +228,7 @@ bool TcpServer::serveOnce(const RequestHandler& handler)
     const int sockFd = ::socket(AF_INET, SOCK_STREAM, 0);
     if (sockFd < 0)
     {
-        osp::log(osp::LogLevel::Error, "TcpServer: failed to create socket");
+        OSP_LOG(osp::LogLevel::Error, "TcpServer: failed to create socket");
         return false;
     }
 
@@ -224,24 +242,24 @@ bool TcpServer::serveOnce(const RequestHandler& handler)
 
     if (::bind(sockFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
     {
-        osp::log(osp::LogLevel::Error, "TcpServer: bind failed");
+        OSP_LOG(osp::LogLevel::Error, "TcpServer: bind failed");
         ::close(sockFd);
         return false;
     }
 
     if (::listen(sockFd, 1) < 0)
     {
-        osp::log(osp::LogLevel::Error, "TcpServer: listen failed");
+        OSP_LOG(osp::LogLevel::Error, "TcpServer: listen failed");
         ::close(sockFd);
         return false;
     }
 
-    osp::log(osp::LogLevel::Info, "TcpServer: waiting for connection...");
+    OSP_LOG(osp::LogLevel::Info, "TcpServer: waiting for connection...");
 
     const int clientFd = ::accept(sockFd, nullptr, nullptr);
     if (clientFd < 0)
     {
-        osp::log(osp::LogLevel::Error, "TcpServer: accept failed");
+        OSP_LOG(osp::LogLevel::Error, "TcpServer: accept failed");
         ::close(sockFd);
         return false;
     }
@@ -249,14 +267,14 @@ bool TcpServer::serveOnce(const RequestHandler& handler)
     auto maybeReq = recvMessage(clientFd);
     if (!maybeReq)
     {
-        osp::log(osp::LogLevel::Error, "TcpServer: failed to receive message");
+        OSP_LOG(osp::LogLevel::Error, "TcpServer: failed to receive message");
         ::close(clientFd);
         ::close(sockFd);
         return false;
     }
 
     const auto& req = *maybeReq;
-    osp::log(osp::LogLevel::Info, "TcpServer: received request");
+    OSP_LOG(osp::LogLevel::Info, "TcpServer: received request");
 
     const auto resp = handler(req);
     const bool ok = sendMessage(clientFd, resp);
@@ -18,6 +18,10 @@ class TcpServer
 public:
     using RequestHandler = std::function<osp::protocol::Message(const osp::protocol::Message&)>;
 
+    // 连接接管钩子：在 handler 之前调用；返回 true 表示该连接已被调用方接管
+    // （例如 WATCH 长连接推送），TcpServer 不再读写也不会关闭该 fd。
+    using ConnectionHook = std::function<bool(int fd, const osp::protocol::Message&)>;
+
     explicit TcpServer(std::uint16_t port, std::size_t poolSize = 4) noexcept;
     ~TcpServer();
 
@@ -27,7 +31,7 @@ public:
 
     // 启动服务器，持续监听并处理客户端连接
     // handler 会在线程池中的工作线程上被调用
-    void start(const RequestHandler& handler);
+    void start(const RequestHandler& handler, const ConnectionHook& hook = {});
 
     // 停止服务器
     void stop();
@@ -38,15 +42,17 @@ public:
     // 旧接口（保持兼容，但内部会转发到新实现）
     bool serveOnce(const RequestHandler& handler);
 
+    // 按长度前缀格式发送一条消息（也供接管连接的调用方推送消息使用）
+    static bool sendMessage(int fd, const osp::protocol::Message& msg);
+
 private:
     // 处理单个客户端连接
-    void handleClient(int clientFd, const RequestHandler& handler);
+    void handleClient(int clientFd, const RequestHandler& handler, const ConnectionHook& hook);
 
     // 内部辅助：发送/接收完整缓冲区
     static bool sendAll(int fd, const void* buf, std::size_t len);
     static bool recvAll(int fd, void* buf, std::size_t len);
 
-    static bool sendMessage(int fd, const osp::protocol::Message& msg);
     static std::optional<osp::protocol::Message> recvMessage(int fd);
 
     std::uint16_t     port_{};
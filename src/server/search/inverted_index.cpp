@@ -0,0 +1,693 @@
+#include "server/search/inverted_index.hpp"
+
+#include "common/logger.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+
+namespace osp::search
+{
+
+namespace
+{
+constexpr const char*   kIndexDir = "/system/search";
+constexpr const char*   kStatsPath = "/system/search/stats";
+constexpr const char*   kDeltaDir = "/system/search/delta";
+constexpr std::size_t   kBucketCount = 32;     // 目录为单块（最多 64 项），桶数需小于该值
+constexpr std::size_t   kDeltaMergeBytes = 16 * 1024; // 增量文件超过该大小时合并进主文件
+constexpr std::uint32_t kTitleWeight = 3;      // 标题中出现的词按 3 倍词频计
+constexpr std::size_t   kMaxTermBytes = 32;
+constexpr double        kBm25K1 = 1.2;
+
+void putVarint(std::string& out, std::uint32_t v)
+{
+    while (v >= 0x80)
+    {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+bool getVarint(const std::string& in, std::size_t& pos, std::uint32_t& v)
+{
+    v = 0;
+    for (unsigned shift = 0; shift < 35; shift += 7)
+    {
+        if (pos >= in.size())
+        {
+            return false;
+        }
+        const auto byte = static_cast<std::uint8_t>(in[pos++]);
+        v |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 从 meta.txt（id\nauthorId\nstatus\ntitle）中取出标题
+std::string titleFromMeta(const std::string& meta)
+{
+    std::stringstream ss(meta);
+    std::string       line;
+    for (int i = 0; i < 3 && std::getline(ss, line); ++i)
+    {
+    }
+    std::string title;
+    std::getline(ss, title);
+    return title;
+}
+} // namespace
+
+std::vector<std::string> InvertedIndex::tokenize(const std::string& text)
+{
+    std::vector<std::string> tokens;
+    std::string              word;
+
+    auto flushWord = [&]() {
+        if (word.size() >= 2)
+        {
+            if (word.size() > kMaxTermBytes)
+            {
+                word.resize(kMaxTermBytes);
+            }
+            tokens.push_back(word);
+        }
+        word.clear();
+    };
+
+    for (std::size_t i = 0; i < text.size();)
+    {
+        const auto c = static_cast<unsigned char>(text[i]);
+        if (c < 0x80)
+        {
+            if (std::isalnum(c))
+            {
+                word.push_back(static_cast<char>(std::tolower(c)));
+            }
+            else
+            {
+                flushWord();
+            }
+            ++i;
+            continue;
+        }
+
+        // 非 ASCII：按 UTF-8 首字节确定字符长度，整个字符作为一个词
+        flushWord();
+        std::size_t len = 1;
+        if ((c & 0xE0) == 0xC0) len = 2;
+        else if ((c & 0xF0) == 0xE0) len = 3;
+        else if ((c & 0xF8) == 0xF0) len = 4;
+        if (i + len > text.size())
+        {
+            break;
+        }
+        tokens.push_back(text.substr(i, len));
+        i += len;
+    }
+    flushWord();
+    return tokens;
+}
+
+InvertedIndex::TermFreqs InvertedIndex::termFrequencies(const std::string& title, const std::string& content)
+{
+    TermFreqs tf;
+    for (const auto& t : tokenize(title))
+    {
+        tf[t] += kTitleWeight;
+    }
+    for (const auto& t : tokenize(content))
+    {
+        tf[t] += 1;
+    }
+    return tf;
+}
+
+std::size_t InvertedIndex::bucketOf(const std::string& term)
+{
+    // FNV-1a
+    std::uint32_t h = 2166136261u;
+    for (char ch : term)
+    {
+        h ^= static_cast<std::uint8_t>(ch);
+        h *= 16777619u;
+    }
+    return h % kBucketCount;
+}
+
+std::string InvertedIndex::bucketPath(std::size_t bucket, std::size_t part)
+{
+    std::string path = std::string(kIndexDir) + "/b";
+    if (bucket < 10)
+    {
+        path.push_back('0');
+    }
+    path += std::to_string(bucket);
+    if (part != 0)
+    {
+        path += "." + std::to_string(part);
+    }
+    return path + ".idx";
+}
+
+std::string InvertedIndex::deltaPath(std::size_t bucket)
+{
+    std::string path = std::string(kDeltaDir) + "/b";
+    if (bucket < 10)
+    {
+        path.push_back('0');
+    }
+    return path + std::to_string(bucket);
+}
+
+bool InvertedIndex::ensureDirectories()
+{
+    vfs_.createDirectory("/system");
+    vfs_.createDirectory(kIndexDir);
+    vfs_.createDirectory(kDeltaDir);
+    const auto st = vfs_.stat(kDeltaDir);
+    return st && st->isDirectory;
+}
+
+bool InvertedIndex::initialized()
+{
+    return vfs_.exists(kStatsPath);
+}
+
+std::uint32_t InvertedIndex::loadDocCount()
+{
+    auto data = vfs_.readFile(kStatsPath);
+    if (!data)
+    {
+        return 0;
+    }
+    try
+    {
+        return static_cast<std::uint32_t>(std::stoul(*data));
+    }
+    catch (...)
+    {
+        return 0;
+    }
+}
+
+bool InvertedIndex::storeDocCount(std::uint32_t n)
+{
+    return vfs_.writeFile(kStatsPath, std::to_string(n));
+}
+
+bool InvertedIndex::loadBucket(std::size_t bucket, Bucket& out)
+{
+    out.clear();
+    for (std::size_t part = 0;; ++part)
+    {
+        auto data = vfs_.readFile(bucketPath(bucket, part));
+        if (!data)
+        {
+            break; // 桶尚未创建（视为空）或已读完全部续接文件
+        }
+        if (!decodeBucket(*data, out))
+        {
+            return false;
+        }
+    }
+
+    auto delta = vfs_.readFile(deltaPath(bucket));
+    return !delta || replayDelta(*delta, nullptr, out);
+}
+
+bool InvertedIndex::replayDelta(const std::string& in, const std::string* onlyTerm, Bucket& out)
+{
+    std::size_t pos = 0;
+    while (pos < in.size())
+    {
+        std::uint32_t termLen{};
+        std::uint32_t docId{};
+        std::uint32_t tf{};
+        if (!getVarint(in, pos, termLen) || pos + termLen > in.size())
+        {
+            return false;
+        }
+        const std::size_t termPos = pos;
+        pos += termLen;
+        if (!getVarint(in, pos, docId) || !getVarint(in, pos, tf))
+        {
+            return false;
+        }
+        if (onlyTerm && in.compare(termPos, termLen, *onlyTerm) != 0)
+        {
+            continue;
+        }
+        applyPosting(out[in.substr(termPos, termLen)], docId, tf);
+    }
+    return true;
+}
+
+void InvertedIndex::applyPosting(std::vector<Posting>& postings, PaperId id, std::uint32_t tf)
+{
+    auto it = std::lower_bound(postings.begin(), postings.end(), id,
+                               [](const Posting& p, PaperId v) { return p.docId < v; });
+    const bool present = (it != postings.end() && it->docId == id);
+    if (tf == 0)
+    {
+        if (present)
+        {
+            postings.erase(it);
+        }
+    }
+    else if (present)
+    {
+        it->tf = tf;
+    }
+    else
+    {
+        postings.insert(it, {id, tf});
+    }
+}
+
+bool InvertedIndex::decodeBucket(const std::string& in, Bucket& out)
+{
+    std::size_t pos = 0;
+    while (pos < in.size())
+    {
+        std::uint32_t termLen{};
+        if (!getVarint(in, pos, termLen) || pos + termLen > in.size())
+        {
+            return false;
+        }
+        std::string term = in.substr(pos, termLen);
+        pos += termLen;
+
+        std::uint32_t df{};
+        if (!getVarint(in, pos, df))
+        {
+            return false;
+        }
+
+        auto&   postings = out[term];
+        PaperId prev = 0;
+        postings.reserve(df);
+        for (std::uint32_t i = 0; i < df; ++i)
+        {
+            std::uint32_t delta{};
+            std::uint32_t tf{};
+            if (!getVarint(in, pos, delta) || !getVarint(in, pos, tf))
+            {
+                return false;
+            }
+            prev += delta;
+            postings.push_back({prev, tf});
+        }
+    }
+    return true;
+}
+
+bool InvertedIndex::storeBucket(std::size_t bucket, const Bucket& b)
+{
+    // 单个文件最多 MaxDirectBlocks 个块；按词项记录切分，每个续接文件都能独立解码
+    const std::size_t maxBytes =
+        static_cast<std::size_t>(vfs_.superBlock().blockSize) * osp::fs::Inode::MaxDirectBlocks;
+
+    std::vector<std::string> parts(1);
+    for (const auto& [term, postings] : b)
+    {
+        if (postings.empty())
+        {
+            continue;
+        }
+        std::string record;
+        putVarint(record, static_cast<std::uint32_t>(term.size()));
+        record += term;
+        putVarint(record, static_cast<std::uint32_t>(postings.size()));
+        PaperId prev = 0;
+        for (const auto& p : postings)
+        {
+            putVarint(record, p.docId - prev);
+            putVarint(record, p.tf);
+            prev = p.docId;
+        }
+
+        if (record.size() > maxBytes)
+        {
+            OSP_LOG(osp::LogLevel::Error, "InvertedIndex: postings of term '" + term + "' (" +
+                                              std::to_string(record.size()) + " bytes) exceed the file size limit");
+            return false;
+        }
+        if (parts.back().size() + record.size() > maxBytes)
+        {
+            parts.emplace_back();
+        }
+        parts.back() += record;
+    }
+
+    for (std::size_t part = 0; part < parts.size(); ++part)
+    {
+        if (!vfs_.writeFile(bucketPath(bucket, part), parts[part]))
+        {
+            OSP_LOG(osp::LogLevel::Error, "InvertedIndex: failed to write bucket " + std::to_string(bucket) + " part " +
+                                              std::to_string(part) + " (" + std::to_string(parts[part].size()) +
+                                              " bytes)");
+            return false;
+        }
+    }
+
+    // 桶变小后多出来的旧续接文件
+    for (std::size_t part = parts.size(); vfs_.exists(bucketPath(bucket, part)); ++part)
+    {
+        if (!vfs_.removeFile(bucketPath(bucket, part)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void InvertedIndex::removeBucket(std::size_t bucket)
+{
+    for (std::size_t part = 0; vfs_.exists(bucketPath(bucket, part)); ++part)
+    {
+        vfs_.removeFile(bucketPath(bucket, part));
+    }
+    if (vfs_.exists(deltaPath(bucket)))
+    {
+        vfs_.removeFile(deltaPath(bucket));
+    }
+}
+
+bool InvertedIndex::loadPostings(const std::string& term, std::vector<Posting>& out)
+{
+    out.clear();
+    const std::size_t bucket = bucketOf(term);
+    for (std::size_t part = 0;; ++part)
+    {
+        auto data = vfs_.readFile(bucketPath(bucket, part));
+        if (!data)
+        {
+            break;
+        }
+        bool found = false;
+        if (!scanPostings(*data, term, out, found))
+        {
+            needsRebuild_ = true;
+            return false;
+        }
+        if (found)
+        {
+            break; // 每个词项只存放在一个文件中
+        }
+    }
+
+    // 再叠加尚未合并的增量记录
+    auto delta = vfs_.readFile(deltaPath(bucket));
+    if (!delta)
+    {
+        return true;
+    }
+    Bucket b;
+    b[term] = std::move(out);
+    if (!replayDelta(*delta, &term, b))
+    {
+        needsRebuild_ = true;
+        out.clear();
+        return false;
+    }
+    out = std::move(b[term]);
+    return true;
+}
+
+bool InvertedIndex::scanPostings(const std::string& in, const std::string& term, std::vector<Posting>& out, bool& found)
+{
+    // 顺序扫描，只解码目标词项，其余词项的倒排表直接跳过
+    std::size_t pos = 0;
+    while (pos < in.size())
+    {
+        std::uint32_t termLen{};
+        if (!getVarint(in, pos, termLen) || pos + termLen > in.size())
+        {
+            return false;
+        }
+        const bool match = (termLen == term.size()) && in.compare(pos, termLen, term) == 0;
+        pos += termLen;
+
+        std::uint32_t df{};
+        if (!getVarint(in, pos, df))
+        {
+            return false;
+        }
+
+        PaperId prev = 0;
+        for (std::uint32_t i = 0; i < df; ++i)
+        {
+            std::uint32_t delta{};
+            std::uint32_t tf{};
+            if (!getVarint(in, pos, delta) || !getVarint(in, pos, tf))
+            {
+                return false;
+            }
+            prev += delta;
+            if (match)
+            {
+                out.push_back({prev, tf});
+            }
+        }
+        if (match)
+        {
+            found = true;
+            return true;
+        }
+    }
+    return true;
+}
+
+bool InvertedIndex::applyDelta(PaperId id, const TermFreqs& before, const TermFreqs& after, int docDelta)
+{
+    if (!ensureDirectories())
+    {
+        return false;
+    }
+
+    // 按桶聚合需要修改的词项：新词频（0 表示删除该文档的 posting）
+    std::unordered_map<std::size_t, std::map<std::string, std::uint32_t>> changes;
+    for (const auto& [term, tf] : before)
+    {
+        if (after.find(term) == after.end())
+        {
+            changes[bucketOf(term)][term] = 0;
+        }
+    }
+    for (const auto& [term, tf] : after)
+    {
+        auto it = before.find(term);
+        if (it == before.end() || it->second != tf)
+        {
+            changes[bucketOf(term)][term] = tf;
+        }
+    }
+
+    bool ok = true;
+    for (const auto& [bucket, terms] : changes)
+    {
+        ok = appendDelta(id, bucket, terms) && ok;
+    }
+
+    if (docDelta != 0)
+    {
+        const std::int64_t n = static_cast<std::int64_t>(loadDocCount()) + docDelta;
+        ok = storeDocCount(static_cast<std::uint32_t>(std::max<std::int64_t>(0, n))) && ok;
+    }
+    else if (!initialized())
+    {
+        ok = storeDocCount(0) && ok;
+    }
+    return ok;
+}
+
+bool InvertedIndex::appendDelta(PaperId id, std::size_t bucket, const TermFreqs& terms)
+{
+    std::string record;
+    for (const auto& [term, tf] : terms)
+    {
+        putVarint(record, static_cast<std::uint32_t>(term.size()));
+        record += term;
+        putVarint(record, id);
+        putVarint(record, tf);
+    }
+
+    const std::string path = deltaPath(bucket);
+    const auto        st = vfs_.stat(path);
+    const std::size_t size = st ? st->size : 0;
+    if (size + record.size() <= kDeltaMergeBytes)
+    {
+        if (!vfs_.appendFile(path, record))
+        {
+            OSP_LOG(osp::LogLevel::Error, "InvertedIndex: failed to append delta of bucket " + std::to_string(bucket));
+            return false;
+        }
+        return true;
+    }
+
+    // 增量过大：读出主文件与增量，合并本次变更后整体写回，再清空增量
+    Bucket b;
+    if (!loadBucket(bucket, b))
+    {
+        // 读不出来的桶不能覆盖写回，否则会丢掉其中其它词项的倒排表；交给下一次 SEARCH 全量重建
+        OSP_LOG(osp::LogLevel::Error,
+                "InvertedIndex: corrupted bucket " + std::to_string(bucket) + ", index will be rebuilt");
+        needsRebuild_ = true;
+        return false;
+    }
+    for (const auto& [term, tf] : terms)
+    {
+        applyPosting(b[term], id, tf);
+    }
+    return storeBucket(bucket, b) && (size == 0 || vfs_.removeFile(path));
+}
+
+bool InvertedIndex::addDocument(PaperId id, const std::string& title, const std::string& content)
+{
+    return applyDelta(id, {}, termFrequencies(title, content), +1);
+}
+
+bool InvertedIndex::updateDocument(PaperId            id,
+                                   const std::string& oldTitle,
+                                   const std::string& oldContent,
+                                   const std::string& newTitle,
+                                   const std::string& newContent)
+{
+    return applyDelta(id, termFrequencies(oldTitle, oldContent), termFrequencies(newTitle, newContent), 0);
+}
+
+bool InvertedIndex::rebuild()
+{
+    if (!ensureDirectories())
+    {
+        return false;
+    }
+
+    // 清空旧桶（含续接文件）
+    for (std::size_t b = 0; b < kBucketCount; ++b)
+    {
+        removeBucket(b);
+    }
+
+    std::vector<Bucket> buckets(kBucketCount);
+    std::uint32_t       docCount = 0;
+
+    if (auto listing = vfs_.openDirectory("/papers"))
+    {
+        osp::fs::Vfs::DirEntryInfo entry;
+        while (listing->next(entry))
+        {
+            if (entry.type != osp::fs::FileType::Directory)
+            {
+                continue;
+            }
+            const std::string pidStr(entry.name);
+            PaperId           pid{};
+            try
+            {
+                pid = static_cast<PaperId>(std::stoul(pidStr));
+            }
+            catch (...)
+            {
+                continue;
+            }
+
+            auto meta = vfs_.readFile("/papers/" + pidStr + "/meta.txt");
+            if (!meta)
+            {
+                continue;
+            }
+            auto content = vfs_.readFile("/papers/" + pidStr + "/content.txt");
+
+            for (const auto& [term, tf] : termFrequencies(titleFromMeta(*meta), content ? *content : ""))
+            {
+                buckets[bucketOf(term)][term].push_back({pid, tf});
+            }
+            ++docCount;
+        }
+    }
+
+    bool ok = true;
+    for (std::size_t b = 0; b < kBucketCount; ++b)
+    {
+        if (buckets[b].empty())
+        {
+            continue;
+        }
+        for (auto& [term, postings] : buckets[b])
+        {
+            std::sort(postings.begin(), postings.end(),
+                      [](const Posting& x, const Posting& y) { return x.docId < y.docId; });
+        }
+        ok = storeBucket(b, buckets[b]) && ok;
+    }
+
+    ok = storeDocCount(docCount) && ok;
+    OSP_LOG(osp::LogLevel::Info, "InvertedIndex: rebuilt index for " + std::to_string(docCount) + " papers");
+    if (ok)
+    {
+        needsRebuild_ = false;
+    }
+    return ok;
+}
+
+std::vector<InvertedIndex::Hit> InvertedIndex::search(const std::string& query, std::size_t limit)
+{
+    std::vector<Hit> hits;
+
+    std::set<std::string> terms;
+    for (auto& t : tokenize(query))
+    {
+        terms.insert(std::move(t));
+    }
+    if (terms.empty())
+    {
+        return hits;
+    }
+
+    const double                          n = static_cast<double>(loadDocCount());
+    std::unordered_map<PaperId, double>   scores;
+    std::vector<Posting>                  postings;
+
+    for (const auto& term : terms)
+    {
+        if (!loadPostings(term, postings) || postings.empty())
+        {
+            continue;
+        }
+
+        const double df = static_cast<double>(postings.size());
+        const double idf = std::log(1.0 + (std::max(n, df) - df + 0.5) / (df + 0.5));
+        for (const auto& p : postings)
+        {
+            const double tf = static_cast<double>(p.tf);
+            scores[p.docId] += idf * (tf * (kBm25K1 + 1.0)) / (tf + kBm25K1);
+        }
+    }
+
+    hits.reserve(scores.size());
+    for (const auto& [docId, score] : scores)
+    {
+        hits.push_back({docId, score});
+    }
+    std::sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) {
+        if (a.score != b.score) return a.score > b.score;
+        return a.paperId < b.paperId;
+    });
+    if (limit > 0 && hits.size() > limit)
+    {
+        hits.resize(limit);
+    }
+    return hits;
+}
+
+} // namespace osp::search
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "common/types.hpp"
+#include "server/filesystem/vfs.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace osp::search
+{
+
+// 论文全文倒排索引（持久化在 VFS 中）：
+// - 标题与正文切词后按词项建立倒排表（posting list），标题词频加权；
+// - 词项按哈希分桶存放在 /system/search/b<NN>.idx，每个桶是一段二进制记录：
+//     varint(termLen) term varint(df) { varint(docId 差值) varint(tf) } * df
+//   docId 升序存储，差值 + varint 编码使倒排表保持紧凑；
+//   单个文件最多 8 个直接块，编码后超过该上限的桶在词项边界处拆分到续接文件 b<NN>.<k>.idx（k = 1, 2, ...），
+//   每个词项只出现在其中一个文件里；
+// - 新增 / 修改论文时不重写桶，而是把变更追加到增量文件 /system/search/delta/b<NN>：
+//     { varint(termLen) term varint(docId) varint(tf) } *（tf 为 0 表示删除该文档的 posting）
+//   读取时在主文件之上按顺序重放；增量超过 16 KiB 时才合并进主文件并清空；
+// - /system/search/stats 记录已索引的文档数（用于 idf）。
+// 查询时只读取涉及词项所在的桶文件，不读取任何论文正文。
+//
+// 线程安全：本类不加锁，调用方需持有保护 Vfs 的互斥锁。
+class InvertedIndex
+{
+public:
+    struct Hit
+    {
+        PaperId paperId{};
+        double  score{0.0};
+    };
+
+    explicit InvertedIndex(osp::fs::Vfs& vfs)
+        : vfs_(vfs)
+    {
+    }
+
+    // 索引是否已在 VFS 中建立（stats 文件存在）
+    [[nodiscard]] bool initialized();
+
+    // 新增一篇论文（以下写操作失败时返回 false，调用方应回滚所在事务）
+    bool addDocument(PaperId id, const std::string& title, const std::string& content);
+
+    // 论文内容变更（REVISE）：只改写受影响词项所在的桶
+    bool updateDocument(PaperId            id,
+                        const std::string& oldTitle,
+                        const std::string& oldContent,
+                        const std::string& newTitle,
+                        const std::string& newContent);
+
+    // 从 /papers 全量重建索引（在索引缺失时于启动阶段调用，或在 needsRebuild() 时调用）
+    bool rebuild();
+
+    // 遇到无法解码的桶文件后置位（此时写操作返回 false 且不会覆盖该桶），rebuild 成功后清除
+    [[nodiscard]] bool needsRebuild() const noexcept { return needsRebuild_; }
+
+    // 按 BM25（不做长度归一化）打分，返回得分降序的论文 ID
+    std::vector<Hit> search(const std::string& query, std::size_t limit);
+
+    // 切词：ASCII 字母数字连续串（转小写，长度 >= 2）作为一个词；
+    // 非 ASCII 的 UTF-8 字符（如中文）逐字作为一个词。
+    static std::vector<std::string> tokenize(const std::string& text);
+
+private:
+    using TermFreqs = std::map<std::string, std::uint32_t>;
+
+    struct Posting
+    {
+        PaperId       docId{};
+        std::uint32_t tf{};
+    };
+    using Bucket = std::map<std::string, std::vector<Posting>>;
+
+    static TermFreqs termFrequencies(const std::string& title, const std::string& content);
+    static std::size_t bucketOf(const std::string& term);
+    // part 为 0 时是桶的主文件，否则为第 part 个续接文件
+    static std::string bucketPath(std::size_t bucket, std::size_t part = 0);
+    static std::string deltaPath(std::size_t bucket);
+
+    bool ensureDirectories();
+    // 读取主文件、全部续接文件并重放增量
+    bool loadBucket(std::size_t bucket, Bucket& out);
+    // 解码一个桶文件（主文件或续接文件）中的全部词项，追加到 out
+    static bool decodeBucket(const std::string& in, Bucket& out);
+    // 写回整个桶（按需拆分为续接文件并删除多余的旧续接文件）。失败时已写入的部分不会回退，
+    // 调用方应在 Vfs::Transaction 中调用并在失败时回滚，使旧桶保持完整
+    bool storeBucket(std::size_t bucket, const Bucket& b);
+    // 删除桶的主文件、全部续接文件与增量文件
+    void removeBucket(std::size_t bucket);
+    bool loadPostings(const std::string& term, std::vector<Posting>& out);
+    // 在一个桶文件中查找 term，找到时 found 置为 true
+    static bool scanPostings(const std::string& in, const std::string& term, std::vector<Posting>& out, bool& found);
+
+    // 重放增量记录到 out；onlyTerm 非空时只处理该词项
+    static bool replayDelta(const std::string& in, const std::string* onlyTerm, Bucket& out);
+    // 在 docId 升序的倒排表中插入 / 更新 / 删除（tf 为 0）一个文档
+    static void applyPosting(std::vector<Posting>& postings, PaperId id, std::uint32_t tf);
+
+    // 把 (旧词频 -> 新词频) 的差异应用到各个桶；docDelta 为文档数变化
+    bool applyDelta(PaperId id, const TermFreqs& before, const TermFreqs& after, int docDelta);
+    // 把一个桶的变更（tf 为 0 表示删除）追加到增量文件，增量过大时合并进主文件
+    bool appendDelta(PaperId id, std::size_t bucket, const TermFreqs& terms);
+
+    std::uint32_t loadDocCount();
+    bool storeDocCount(std::uint32_t n);
+
+    osp::fs::Vfs& vfs_;
+    bool          needsRebuild_{false};
+};
+
+} // namespace osp::search
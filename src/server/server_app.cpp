@@ -4,13 +4,24 @@
 #include "domain/permissions.hpp"
 #include "domain/review.hpp"
 
+#include "common/trace.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
 #include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <set>
 #include <vector>
 #include <sstream>
 #include <cstdlib>
 #include <filesystem>
+#include <fstream>
 
 namespace osp::server
 {
@@ -39,12 +50,39 @@ osp::Role stringToRole(const std::string& s)
     return osp::Role::Author;
 }
 
-std::size_t clampCacheCapacity(std::size_t v)
+// 块缓存预算上限：物理内存的一半（取不到时按 16 MiB），防止配置错误把机器内存吃光
+std::size_t maxCacheBytes()
+{
+    const long pages = ::sysconf(_SC_PHYS_PAGES);
+    const long pageSize = ::sysconf(_SC_PAGESIZE);
+    if (pages <= 0 || pageSize <= 0)
+    {
+        return std::size_t{16} * 1024 * 1024;
+    }
+    return static_cast<std::size_t>(pages) / 2 * static_cast<std::size_t>(pageSize);
+}
+
+std::size_t clampCacheBytes(std::size_t v)
 {
-    // 防止极端值导致内存占用过大；课程项目里给一个温和上限即可
-    constexpr std::size_t kMax = 4096;
-    if (v > kMax) return kMax;
-    return v;
+    return std::min(v, maxCacheBytes());
+}
+
+// 内存紧张：/proc/meminfo 中 MemAvailable 低于 MemTotal 的 10%（读不到时视为不紧张）
+bool memoryPressure()
+{
+    std::ifstream in("/proc/meminfo");
+    std::uint64_t total = 0;
+    std::uint64_t available = 0;
+    std::string   key;
+    std::uint64_t value = 0;
+    std::string   unit;
+    while (in >> key >> value >> unit)
+    {
+        if (key == "MemTotal:") total = value;
+        else if (key == "MemAvailable:") available = value;
+        if (total != 0 && available != 0) break;
+    }
+    return total != 0 && available != 0 && available * 10 < total;
 }
 
 std::string trimCopy(const std::string& s)
@@ -99,6 +137,119 @@ std::vector<std::string> splitFieldsCsv(const std::string& csv)
     return unique;
 }
 
+// 从 meta.txt（id\nauthorId\nstatus\ntitle）中取出作者 ID，失败返回 0
+osp::UserId authorIdFromMeta(const std::string& meta)
+{
+    std::stringstream metaSS(meta);
+    std::uint32_t     p_id{};
+    std::uint32_t     p_authorId{};
+    if (!(metaSS >> p_id >> p_authorId))
+    {
+        return 0;
+    }
+    return p_authorId;
+}
+
+// 从 meta.txt 中取出论文 ID（事件中的 paperId 统一用它，与 SUBMIT 应答一样为整数），失败返回 0
+std::uint32_t paperIdFromMeta(const std::string& meta)
+{
+    std::stringstream metaSS(meta);
+    std::uint32_t     p_id{};
+    if (!(metaSS >> p_id))
+    {
+        return 0;
+    }
+    return p_id;
+}
+
+// 从 meta.txt 中取出状态字符串（Submitted / UnderReview / Accepted / Rejected），失败返回空串
+std::string statusFromMeta(const std::string& meta)
+{
+    std::stringstream metaSS(meta);
+    std::uint32_t     p_id{};
+    std::uint32_t     p_authorId{};
+    std::string       p_status;
+    if (!(metaSS >> p_id >> p_authorId >> p_status))
+    {
+        return {};
+    }
+    return p_status;
+}
+
+// 子树中最近一次修改的时间（目录与文件 mtime 的最大值），路径不存在时返回 std::nullopt
+std::optional<std::uint32_t> newestMtime(osp::fs::Vfs& vfs, const std::string& path)
+{
+    const auto st = vfs.stat(path);
+    if (!st)
+    {
+        return std::nullopt;
+    }
+    std::uint32_t newest = st->mtime;
+    if (!st->isDirectory)
+    {
+        return newest;
+    }
+
+    auto it = vfs.openDirectory(path);
+    if (!it)
+    {
+        return std::nullopt;
+    }
+    std::vector<std::string>   names;
+    osp::fs::Vfs::DirEntryInfo e;
+    while (it->next(e))
+    {
+        names.emplace_back(e.name);
+    }
+    for (const auto& name : names)
+    {
+        const auto child = newestMtime(vfs, path + "/" + name);
+        if (!child)
+        {
+            return std::nullopt;
+        }
+        newest = std::max(newest, *child);
+    }
+    return newest;
+}
+
+// GET_PAPER 分页时每页的默认字节数
+constexpr std::size_t kPaperPageBytes = 16 * 1024;
+
+// 从按字节截取的 buf 中取出不超过 maxLen 字节、且首尾都落在 UTF-8 字符边界上的片段：
+// 跳过开头残缺字符的续字节（数量写入 outSkipped），结尾不截断多字节字符。
+// 调用方需比 maxLen 多读 4 个字节（除非已到文件末尾），以便判断结尾处的字符边界。
+std::string utf8Slice(const std::string& buf, std::size_t maxLen, std::size_t& outSkipped)
+{
+    auto isCont = [&](std::size_t i) {
+        return i < buf.size() && (static_cast<unsigned char>(buf[i]) & 0xC0) == 0x80;
+    };
+
+    std::size_t begin = 0;
+    while (begin < 3 && isCont(begin))
+    {
+        ++begin;
+    }
+
+    std::size_t end = std::min(buf.size(), begin + maxLen);
+    while (end > begin && isCont(end))
+    {
+        --end;
+    }
+    if (end == begin && begin < buf.size())
+    {
+        // maxLen 不足一个字符时至少返回一个完整字符，避免分页原地打转
+        ++end;
+        while (isCont(end))
+        {
+            ++end;
+        }
+    }
+
+    outSkipped = begin;
+    return buf.substr(begin, end - begin);
+}
+
 std::set<std::string> toFieldSet(const std::vector<std::string>& v)
 {
     return std::set<std::string>(v.begin(), v.end());
@@ -113,12 +264,56 @@ std::vector<std::string> intersectionFields(const std::set<std::string>& a, cons
     }
     return out;
 }
+
+double nanosToMicros(std::uint64_t nanos)
+{
+    return static_cast<double>(nanos) / 1000.0;
+}
+
+// LOCK_PROFILE 输出：采样值按 sampleEvery 放大为估计总量，时间单位为微秒
+osp::protocol::json lockProfileToJson(const osp::TimedMutex::Profile& p)
+{
+    using osp::protocol::json;
+
+    const double scale = p.sampleEvery == 0 ? 0.0 : static_cast<double>(p.sampleEvery);
+    json sites = json::array();
+    for (const auto& s : p.sites)
+    {
+        sites.push_back({
+            {"site", s.site},
+            {"samples", s.samples},
+            {"contended", s.contended},
+            {"estimatedAcquisitions", static_cast<std::uint64_t>(static_cast<double>(s.samples) * scale)},
+            {"wait", {
+                {"meanUs", nanosToMicros(static_cast<std::uint64_t>(s.waitNs.mean()))},
+                {"p99Us", nanosToMicros(s.waitNs.percentile(99))},
+                {"maxUs", nanosToMicros(s.waitNs.max())},
+                {"estimatedTotalMs", nanosToMicros(s.waitNs.sum()) * scale / 1000.0}
+            }},
+            {"hold", {
+                {"meanUs", nanosToMicros(static_cast<std::uint64_t>(s.holdNs.mean()))},
+                {"p50Us", nanosToMicros(s.holdNs.percentile(50))},
+                {"p99Us", nanosToMicros(s.holdNs.percentile(99))},
+                {"maxUs", nanosToMicros(s.holdNs.max())},
+                {"estimatedTotalMs", nanosToMicros(s.holdNs.sum()) * scale / 1000.0}
+            }}
+        });
+    }
+
+    return {
+        {"name", p.name},
+        {"acquisitions", p.acquisitions},
+        {"contended", p.contended},
+        {"contendedRatio", p.acquisitions == 0 ? 0.0 : static_cast<double>(p.contended) / p.acquisitions},
+        {"sites", sites}
+    };
+}
 } // namespace
 
-ServerApp::ServerApp(std::uint16_t port, std::size_t cacheCapacity, std::size_t threadPoolSize)
+ServerApp::ServerApp(std::uint16_t port, std::size_t cacheBytes, std::size_t threadPoolSize)
     : port_(port)
     , threadPoolSize_(threadPoolSize)
-    , vfs_(clampCacheCapacity(cacheCapacity))
+    , vfs_(clampCacheBytes(cacheBytes))
     , auth_()
 {
     // 用户数据将在 run() 中 VFS 挂载后从文件系统加载
@@ -127,15 +322,31 @@ ServerApp::ServerApp(std::uint16_t port, std::size_t cacheCapacity, std::size_t
 void ServerApp::run()
 {
     running_.store(true);
-    osp::log(osp::LogLevel::Info,
+    osp::TimedMutex::ScopedTag lockTag("startup");
+    OSP_LOG(osp::LogLevel::Info,
              "Server starting on port " + std::to_string(port_)
-                 + " (cacheCapacity=" + std::to_string(vfs_.cacheCapacity())
-                 + ", threadPoolSize=" + std::to_string(threadPoolSize_) + ")");
+                 + " (cacheBytes=" + std::to_string(vfs_.cacheCapacityBytes())
+                 + (vfs_.cacheAutoTune().enabled
+                        ? " auto " + std::to_string(vfs_.cacheAutoTune().minBytes) + "-"
+                              + std::to_string(vfs_.cacheAutoTune().maxBytes)
+                        : std::string())
+                 + ", threadPoolSize=" + std::to_string(threadPoolSize_)
+                 + ", durability=" + osp::fs::durabilityModeName(groupCommit_.config().mode) + ")");
 
     // 挂载简化 VFS
     {
-        std::lock_guard<std::mutex> lock(vfsMutex_);
+        std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
         vfs_.mount("data.fs");
+        if (!blockTracePath_.empty())
+        {
+            vfs_.startBlockTrace(blockTracePath_);
+        }
+
+        // 旧数据没有全文索引时，启动阶段从 /papers 重建一次
+        if (!searchIndex_.initialized())
+        {
+            searchIndex_.rebuild();
+        }
     }
 
     // 初始化 AuthService 的 VFS 操作接口
@@ -143,13 +354,13 @@ void ServerApp::run()
 
     // 从 VFS 加载用户数据
     {
-        std::lock_guard<std::mutex> authLock(authMutex_);
+        std::lock_guard<osp::TimedMutex> authLock(authMutex_);
         auth_.loadUsers();
 
         // 如果没有用户数据，初始化默认账号
         if (auth_.getAllUsers().empty())
         {
-            osp::log(osp::LogLevel::Info, "No users found, creating default accounts...");
+            OSP_LOG(osp::LogLevel::Info, "No users found, creating default accounts...");
             auth_.addUser("admin", "admin", osp::Role::Admin);
             auth_.addUser("author", "author", osp::Role::Author);
             auth_.addUser("author2", "author2", osp::Role::Author);
@@ -158,19 +369,227 @@ void ServerApp::run()
         }
         else
         {
-            osp::log(osp::LogLevel::Info, 
+            OSP_LOG(osp::LogLevel::Info, 
                      "Loaded " + std::to_string(auth_.getAllUsers().size()) + " users from VFS");
         }
     }
 
+    // 组提交线程（仅 group 模式）
+    groupCommit_.start();
+
+    // WATCH 推送线程
+    watchThread_ = std::thread([this] { watchLoop(); });
+
+    if (backgroundDefrag_)
+    {
+        defragThread_ = std::thread([this] { defragLoop(); });
+    }
+
+    if (warmCache_)
+    {
+        warmSetThread_ = std::thread([this] { warmSetLoop(); });
+    }
+
+    // 缓存预算自动调节线程（未开启自动调节时只做空转检查，CACHE_CONFIG AUTO 可在运行时开启）
+    cacheTuneThread_ = std::thread([this] { cacheTuneLoop(); });
+
+    if (tierIntervalSec_ != 0)
+    {
+        tierThread_ = std::thread([this] { tierLoop(); });
+    }
+
+    if (metricsPort_ != 0)
+    {
+        metricsThread_ = std::thread([this] { metricsHttpLoop(); });
+    }
+
     // 使用多线程 TCP 服务器
     osp::net::TcpServer tcpServer(port_, threadPoolSize_);
 
-    tcpServer.start([this](const osp::protocol::Message& req) {
-        return handleRequest(req);
+    tcpServer.start(
+        [this](const osp::protocol::Message& req) {
+            return handleRequest(req);
+        },
+        [this](int fd, const osp::protocol::Message& req) {
+            return acceptWatchConnection(fd, req);
+        });
+
+    OSP_LOG(osp::LogLevel::Info, "Server shutting down");
+
+    running_.store(false);
+    events_.close();
+    if (watchThread_.joinable())
+    {
+        watchThread_.join();
+    }
+    if (defragThread_.joinable())
+    {
+        defragThread_.join();
+    }
+    if (warmSetThread_.joinable())
+    {
+        warmSetThread_.join();
+    }
+    if (cacheTuneThread_.joinable())
+    {
+        cacheTuneThread_.join();
+    }
+    if (tierThread_.joinable())
+    {
+        tierThread_.join();
+    }
+    groupCommit_.stop();
+    {
+        osp::TimedMutex::ScopedTag      lockTag("shutdown");
+        std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
+        vfs_.sync();
+    }
+    if (metricsThread_.joinable())
+    {
+        metricsThread_.join();
+    }
+    std::lock_guard<std::mutex> lock(watchersMutex_);
+    for (const auto& w : watchers_)
+    {
+        ::close(w.fd);
+    }
+    watchers_.clear();
+}
+
+bool ServerApp::acceptWatchConnection(int fd, const osp::protocol::Message& req)
+{
+    if (req.type != osp::protocol::MessageType::CommandRequest)
+    {
+        return false;
+    }
+
+    osp::protocol::Command cmd = osp::protocol::parseCommandFromJson(req.payload);
+    if (cmd.name != "WATCH" || cmd.sessionId.empty())
+    {
+        return false;
+    }
+
+    // 会话无效或参数错误时不接管连接，交给 handleCommand 返回对应错误
+    std::optional<osp::domain::Session> session;
+    {
+        osp::TimedMutex::ScopedTag lockTag("WATCH");
+        std::lock_guard<osp::TimedMutex> lock(authMutex_);
+        session = auth_.validateSession(cmd.sessionId);
+    }
+    if (!session)
+    {
+        return false;
+    }
+
+    std::uint64_t since = events_.lastSeq();
+    if (!cmd.args.empty())
+    {
+        try
+        {
+            since = std::stoull(cmd.args[0]);
+        }
+        catch (...)
+        {
+            return false;
+        }
+    }
+
+    // 推送线程会依次向所有连接发送，限制单次发送的阻塞时间，避免慢客户端拖住其他连接
+    timeval tv{};
+    tv.tv_sec = 2;
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    const auto ack = osp::protocol::makeSuccessResponse({
+        {"message", "Watching"},
+        {"seq", events_.lastSeq()}
     });
+    if (!osp::net::TcpServer::sendMessage(fd, ack))
+    {
+        ::close(fd);
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(watchersMutex_);
+    watchers_.push_back({fd, *session, since});
+    OSP_LOG(osp::LogLevel::Info,
+             "WATCH: " + session->username + " subscribed (fd " + std::to_string(fd)
+                 + ", watchers=" + std::to_string(watchers_.size()) + ")");
+    return true;
+}
+
+void ServerApp::watchLoop()
+{
+    using namespace std::chrono;
+    constexpr auto kPollInterval = milliseconds(1000);
+    constexpr auto kHeartbeatInterval = seconds(15);
+
+    auto          lastBeat = steady_clock::now();
+    std::uint64_t seen = 0;
+
+    while (running_.load())
+    {
+        seen = events_.waitNewer(seen, kPollInterval);
+
+        const auto now = steady_clock::now();
+        const bool beat = (now - lastBeat) >= kHeartbeatInterval;
+        if (beat)
+        {
+            lastBeat = now;
+        }
+
+        // 取出当前订阅者后在锁外发送：某个连接发送阻塞（最长 SO_SNDTIMEO）时不会拖住 acceptWatchConnection。
+        // 只有本线程修改 Watcher 的 lastSeq，发送完再把仍然有效的订阅者与期间新加入的合并回去
+        std::vector<Watcher> active;
+        {
+            std::lock_guard<std::mutex> lock(watchersMutex_);
+            active.swap(watchers_);
+        }
+        for (auto it = active.begin(); it != active.end();)
+        {
+            Watcher& w = *it;
+            bool     ok = true;
 
-    osp::log(osp::LogLevel::Info, "Server shutting down");
+            bool truncated = false;
+            auto pending = events_.since(w.lastSeq, truncated);
+            if (truncated)
+            {
+                // 客户端落后太多，缓冲区已覆盖：通知其全量刷新一次
+                ok = osp::net::TcpServer::sendMessage(
+                    w.fd, osp::protocol::makeSuccessResponse({{"event", {{"type", "Resync"}, {"seq", seen}}}}));
+            }
+            for (const auto& e : pending)
+            {
+                if (!ok)
+                {
+                    break;
+                }
+                if (EventFeed::visibleTo(e, w.session.role, w.session.userId))
+                {
+                    ok = osp::net::TcpServer::sendMessage(
+                        w.fd, osp::protocol::makeSuccessResponse({{"event", EventFeed::toJson(e)}}));
+                }
+                w.lastSeq = e.seq;
+            }
+            if (ok && pending.empty() && beat)
+            {
+                ok = osp::net::TcpServer::sendMessage(
+                    w.fd, osp::protocol::makeSuccessResponse({{"event", {{"type", "Heartbeat"}, {"seq", seen}}}}));
+            }
+
+            if (!ok)
+            {
+                OSP_LOG(osp::LogLevel::Info, "WATCH: dropping subscriber fd " + std::to_string(w.fd));
+                ::close(w.fd);
+                it = active.erase(it);
+                continue;
+            }
+            ++it;
+        }
+
+        std::lock_guard<std::mutex> lock(watchersMutex_);
+        active.insert(active.end(), std::make_move_iterator(watchers_.begin()), std::make_move_iterator(watchers_.end()));
+        watchers_ = std::move(active);
+    }
 }
 
 void ServerApp::initAuthVfsOperations()
@@ -179,39 +598,309 @@ void ServerApp::initAuthVfsOperations()
 
     // 创建目录
     ops.createDirectory = [this](const std::string& path) -> bool {
-        std::lock_guard<std::mutex> lock(vfsMutex_);
+        std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
         return vfs_.createDirectory(path);
     };
 
     // 写文件
     ops.writeFile = [this](const std::string& path, const std::string& content) -> bool {
-        std::lock_guard<std::mutex> lock(vfsMutex_);
+        std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
         return vfs_.writeFile(path, content);
     };
 
     // 读文件
     ops.readFile = [this](const std::string& path) -> std::optional<std::string> {
-        std::lock_guard<std::mutex> lock(vfsMutex_);
+        std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
         return vfs_.readFile(path);
     };
 
-    // 删除文件
-    ops.removeFile = [this](const std::string& path) -> bool {
-        std::lock_guard<std::mutex> lock(vfsMutex_);
-        return vfs_.removeFile(path);
-    };
+    // 删除文件
+    ops.removeFile = [this](const std::string& path) -> bool {
+        std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
+        return vfs_.removeFile(path);
+    };
+
+    // 列出目录下的普通文件
+    ops.listFiles = [this](const std::string& path) -> std::optional<std::vector<std::string>> {
+        std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
+        auto it = vfs_.openDirectory(path);
+        if (!it)
+        {
+            return std::nullopt;
+        }
+        std::vector<std::string>   files;
+        osp::fs::Vfs::DirEntryInfo e;
+        while (it->next(e))
+        {
+            if (e.type == osp::fs::FileType::File)
+            {
+                files.emplace_back(e.name);
+            }
+        }
+        return files;
+    };
+
+    // 设置到 AuthService（需要在 authMutex_ 保护下）
+    std::lock_guard<osp::TimedMutex> authLock(authMutex_);
+    auth_.setVfsOperations(ops);
+
+    OSP_LOG(osp::LogLevel::Info, "AuthService VFS persistence enabled");
+}
+
+void ServerApp::defragLoop()
+{
+    using namespace std::chrono;
+    constexpr auto kStepInterval = milliseconds(200); // 两步之间的最小间隔（每步只整理一个目录）
+    constexpr auto kPassInterval = seconds(60);       // 一轮扫描结束后的休眠时间
+
+    std::uint32_t cursor = 0;
+    auto          nextStep = steady_clock::now();
+
+    osp::TimedMutex::ScopedTag lockTag("defrag");
+
+    while (running_.load())
+    {
+        std::this_thread::sleep_for(kStepInterval);
+        if (steady_clock::now() < nextStep)
+        {
+            continue;
+        }
+
+        // 前台请求正在使用 VFS 时跳过本次，不与其争锁
+        std::unique_lock<osp::TimedMutex> lock(vfsMutex_, std::try_to_lock);
+        if (!lock.owns_lock())
+        {
+            continue;
+        }
+
+        if (vfs_.defragmentStep(cursor))
+        {
+            nextStep = steady_clock::now() + kPassInterval;
+        }
+    }
+}
+
+void ServerApp::warmSetLoop()
+{
+    using namespace std::chrono;
+    constexpr auto kSaveInterval = seconds(30);
+
+    osp::TimedMutex::ScopedTag lockTag("warmset");
+
+    auto nextSave = steady_clock::now() + kSaveInterval;
+    while (running_.load())
+    {
+        std::this_thread::sleep_for(milliseconds(200));
+        if (steady_clock::now() < nextSave)
+        {
+            continue;
+        }
+
+        // 与后台整理一样不与前台请求争锁，拿不到锁就稍后再试
+        std::unique_lock<osp::TimedMutex> lock(vfsMutex_, std::try_to_lock);
+        if (!lock.owns_lock())
+        {
+            continue;
+        }
+        vfs_.saveWarmSet();
+        nextSave = steady_clock::now() + kSaveInterval;
+    }
+}
+
+void ServerApp::cacheTuneLoop()
+{
+    using namespace std::chrono;
+    constexpr auto kTuneInterval = seconds(10);
+
+    osp::TimedMutex::ScopedTag lockTag("cachetune");
+
+    auto nextTune = steady_clock::now() + kTuneInterval;
+    while (running_.load())
+    {
+        std::this_thread::sleep_for(milliseconds(200));
+        if (steady_clock::now() < nextTune)
+        {
+            continue;
+        }
+
+        // 读 /proc/meminfo 放在锁外
+        const bool pressure = memoryPressure();
+        std::unique_lock<osp::TimedMutex> lock(vfsMutex_, std::try_to_lock);
+        if (!lock.owns_lock())
+        {
+            continue;
+        }
+        // 顺带对已释放的块打洞（OSP_PUNCH_HOLES）：打洞前会先 fdatasync，使释放先于打洞落盘
+        vfs_.punchFreedBlocks();
+
+        const auto before = vfs_.cacheCapacityBytes();
+        if (const auto after = vfs_.tuneCache(pressure))
+        {
+            lock.unlock();
+            OSP_LOG(osp::LogLevel::Info, "BlockCache: auto-tuned budget " + std::to_string(before) + " -> " +
+                                             std::to_string(*after) + " bytes" +
+                                             (pressure ? " (memory pressure)" : ""));
+        }
+        nextTune = steady_clock::now() + kTuneInterval;
+    }
+}
+
+void ServerApp::tierLoop()
+{
+    using namespace std::chrono;
+    const auto interval = seconds(tierIntervalSec_);
+
+    osp::TimedMutex::ScopedTag lockTag("tier");
+
+    auto nextPass = steady_clock::now() + interval;
+    while (running_.load())
+    {
+        std::this_thread::sleep_for(milliseconds(200));
+        if (steady_clock::now() < nextPass)
+        {
+            continue;
+        }
+
+        // 归档要读写整棵论文目录，同样不与前台请求争锁
+        std::unique_lock<osp::TimedMutex> lock(vfsMutex_, std::try_to_lock);
+        if (!lock.owns_lock())
+        {
+            continue;
+        }
+        runTieringPass();
+        nextPass = steady_clock::now() + interval;
+    }
+}
+
+std::optional<osp::fs::Vfs::ArchiveResult> ServerApp::runTieringPass()
+{
+    auto papers = vfs_.openDirectory("/papers");
+    if (!papers)
+    {
+        return osp::fs::Vfs::ArchiveResult{};
+    }
+    std::vector<std::string>   ids;
+    osp::fs::Vfs::DirEntryInfo e;
+    while (papers->next(e))
+    {
+        if (!e.archived && e.type == osp::fs::FileType::Directory)
+        {
+            ids.emplace_back(e.name);
+        }
+    }
+
+    const auto now = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+    const std::string accepted = osp::domain::paperStatusToString(osp::domain::PaperStatus::Accepted);
+    const std::string rejected = osp::domain::paperStatusToString(osp::domain::PaperStatus::Rejected);
+
+    std::vector<std::string> roots;
+    for (const auto& pidStr : ids)
+    {
+        const std::string paperDir = "/papers/" + pidStr;
+        const auto        meta = vfs_.readFile(paperDir + "/meta.txt");
+        if (!meta)
+        {
+            continue;
+        }
+        const auto status = statusFromMeta(*meta);
+        if (status != accepted && status != rejected)
+        {
+            continue;
+        }
+        // 整个目录（含 reviews/）在 tierMinAgeSec_ 内没有修改过才归档；mtime 为 0（旧版镜像，时间未知）视为足够旧
+        const auto newest = newestMtime(vfs_, paperDir);
+        if (!newest || *newest + static_cast<std::uint64_t>(tierMinAgeSec_) > now)
+        {
+            continue;
+        }
+        roots.push_back(paperDir);
+    }
+
+    if (roots.empty())
+    {
+        return osp::fs::Vfs::ArchiveResult{};
+    }
+    return vfs_.archive(roots);
+}
+
+void ServerApp::metricsHttpLoop()
+{
+    const int listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0)
+    {
+        OSP_LOG(osp::LogLevel::Error, "Metrics: failed to create socket");
+        return;
+    }
+
+    int opt = 1;
+    ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    // 只监听本机回环地址，指标不对外暴露
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(metricsPort_);
+    if (::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(listenFd, 16) < 0)
+    {
+        OSP_LOG(osp::LogLevel::Error, "Metrics: cannot listen on 127.0.0.1:" + std::to_string(metricsPort_));
+        ::close(listenFd);
+        return;
+    }
+    OSP_LOG(osp::LogLevel::Info, "Metrics: serving Prometheus text on 127.0.0.1:" + std::to_string(metricsPort_)
+                                      + "/metrics");
+
+    while (running_.load())
+    {
+        // 定期醒来检查 running_，以便 run() 退出时能 join
+        pollfd pfd{listenFd, POLLIN, 0};
+        if (::poll(&pfd, 1, 500) <= 0)
+        {
+            continue;
+        }
+
+        const int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0)
+        {
+            continue;
+        }
+
+        timeval tv{};
+        tv.tv_sec = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
 
-    // 列出目录
-    ops.listDirectory = [this](const std::string& path) -> std::optional<std::string> {
-        std::lock_guard<std::mutex> lock(vfsMutex_);
-        return vfs_.listDirectory(path);
-    };
+        // 只需要请求行：GET /metrics 返回指标，其余路径返回 404
+        char       buf[1024];
+        const auto n = ::recv(fd, buf, sizeof(buf) - 1, 0);
+        const std::string request = n > 0 ? std::string(buf, static_cast<std::size_t>(n)) : std::string{};
 
-    // 设置到 AuthService（需要在 authMutex_ 保护下）
-    std::lock_guard<std::mutex> authLock(authMutex_);
-    auth_.setVfsOperations(ops);
+        std::string response;
+        if (request.rfind("GET /metrics", 0) == 0)
+        {
+            const auto body = metrics_.toPrometheus();
+            response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+                       + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+        }
+        else
+        {
+            response = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        }
+
+        std::size_t sent = 0;
+        while (sent < response.size())
+        {
+            const auto w = ::send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (w <= 0)
+            {
+                break;
+            }
+            sent += static_cast<std::size_t>(w);
+        }
+        ::close(fd);
+    }
 
-    osp::log(osp::LogLevel::Info, "AuthService VFS persistence enabled");
+    ::close(listenFd);
 }
 
 void ServerApp::stop()
@@ -231,7 +920,10 @@ osp::protocol::Message ServerApp::handleRequest(const osp::protocol::Message& re
         return osp::protocol::makeErrorResponse("INVALID_TYPE", "Unsupported message type");
     }
 
-    osp::log(osp::LogLevel::Info, "Received request payload: " + req.payload.dump());
+    OSP_TRACE_SPAN("ServerApp::handleRequest");
+    OSP_LOG(osp::LogLevel::Debug, "Received request payload: " + req.payload.dump());
+
+    const auto probe = RequestMetrics::begin();
 
     // 从 JSON payload 解析 Command
     Command cmd = osp::protocol::parseCommandFromJson(req.payload);
@@ -240,11 +932,46 @@ osp::protocol::Message ServerApp::handleRequest(const osp::protocol::Message& re
         return osp::protocol::makeErrorResponse("EMPTY_COMMAND", "Empty command");
     }
 
+    // 本请求期间获取的 vfsMutex_ / authMutex_ 在竞争分析中记在该命令名下；追踪中以命令名作为区间名
+    const auto                 commandName = RequestMetrics::commandName(cmd.name);
+    osp::TimedMutex::ScopedTag lockTag(commandName);
+    OSP_TRACE_SPAN(commandName);
+
+    std::optional<osp::domain::Session> session;
+    auto response = dispatchCommand(cmd, session);
+
+    // 本请求写过块时，按持久化级别等待落盘后再应答（此时已不持有 vfsMutex_）
+    std::uint64_t syncWaitNanos = 0;
+    if (osp::fs::Vfs::threadIoCounters().blockWrites != probe.blockWrites)
+    {
+        OSP_TRACE_SPAN("GroupCommit::waitDurable");
+        const auto waitStart = std::chrono::steady_clock::now();
+        if (!groupCommit_.waitDurable())
+        {
+            response = osp::protocol::makeErrorResponse("FS_ERROR", "fdatasync failed; changes may not be durable");
+        }
+        syncWaitNanos = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - waitStart).count());
+    }
+
+    const bool error = response.type == MessageType::Error;
+    auto       sample = RequestMetrics::finish(probe);
+    sample.syncWaitNanos = syncWaitNanos;
+    metrics_.record(cmd.name, sample, error);
+    const std::string role = session ? roleToString(session->role) : std::string();
+    slowLog_.maybeRecord(commandName == "OTHER" ? std::string_view(cmd.name) : commandName, cmd.args, role, error,
+                         sample);
+    return response;
+}
+
+osp::protocol::Message ServerApp::dispatchCommand(const osp::protocol::Command&        cmd,
+                                                  std::optional<osp::domain::Session>& maybeSession)
+{
     // 如果携带了 Session ID，则在此统一校验会话是否有效
-    std::optional<osp::domain::Session> maybeSession;
     if (!cmd.sessionId.empty())
     {
-        std::lock_guard<std::mutex> lock(authMutex_);
+        OSP_TRACE_SPAN("AuthService::validateSession");
+        std::lock_guard<osp::TimedMutex> lock(authMutex_);
         auto s = auth_.validateSession(cmd.sessionId);
         if (!s)
         {
@@ -281,7 +1008,7 @@ osp::protocol::Message ServerApp::handleCommand(const osp::protocol::Command&
         cred.username = cmd.args[0];
         cred.password = cmd.args[1];
 
-        std::lock_guard<std::mutex> lock(authMutex_);
+        std::lock_guard<osp::TimedMutex> lock(authMutex_);
         auto session = auth_.login(cred);
         if (!session)
         {
@@ -300,7 +1027,8 @@ osp::protocol::Message ServerApp::handleCommand(const osp::protocol::Command&
     // 论文相关命令
     if (cmd.name == "LIST_PAPERS" || cmd.name == "SUBMIT" || cmd.name == "GET_PAPER"
         || cmd.name == "ASSIGN" || cmd.name == "REVIEW" || cmd.name == "LIST_REVIEWS"
-        || cmd.name == "DECISION" || cmd.name == "REVISE" || cmd.name == "SET_PAPER_FIELDS")
+        || cmd.name == "DECISION" || cmd.name == "REVISE" || cmd.name == "SET_PAPER_FIELDS"
+        || cmd.name == "SEARCH")
     {
         return handlePaperCommand(cmd, maybeSession);
     }
@@ -338,9 +1066,9 @@ osp::protocol::Message ServerApp::handleCommand(const osp::protocol::Command&
         // Load paper fields
         std::set<std::string> paperFields;
         {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
+            std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
             const std::string metaPath = "/papers/" + pidStr + "/meta.txt";
-            if (!vfs_.readFile(metaPath))
+            if (!vfs_.exists(metaPath))
             {
                 return osp::protocol::makeErrorResponse("NOT_FOUND", "Paper not found: " + pidStr);
             }
@@ -359,7 +1087,7 @@ osp::protocol::Message ServerApp::handleCommand(const osp::protocol::Command&
         };
         std::vector<ReviewerInfo> reviewers;
         {
-            std::lock_guard<std::mutex> lock(authMutex_);
+            std::lock_guard<osp::TimedMutex> lock(authMutex_);
             for (const auto& u : auth_.getAllUsers())
             {
                 if (u.role() != osp::Role::Reviewer) continue;
@@ -384,7 +1112,7 @@ osp::protocol::Message ServerApp::handleCommand(const osp::protocol::Command&
             std::set<std::string> reviewerFieldSet;
             std::vector<std::string> reviewerFields;
             {
-                std::lock_guard<std::mutex> lock(vfsMutex_);
+                std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
                 vfs_.createDirectory("/system");
                 vfs_.createDirectory("/system/reviewer_fields");
                 const std::string path = "/system/reviewer_fields/" + std::to_string(r.userId) + ".txt";
@@ -488,7 +1216,7 @@ osp::protocol::Message ServerApp::handleCommand(const osp::protocol::Command&
         
         if (subcmd == "LIST")
         {
-            std::lock_guard<std::mutex> lock(authMutex_);
+            std::lock_guard<osp::TimedMutex> lock(authMutex_);
             auto users = auth_.getAllUsers();
             json userList = json::array();
             for (const auto& user : users)
@@ -512,7 +1240,7 @@ osp::protocol::Message ServerApp::handleCommand(const osp::protocol::Command&
             const std::string& roleStr = cmd.args[3];
 
             osp::Role role = stringToRole(roleStr);
-            std::lock_guard<std::mutex> lock(authMutex_);
+            std::lock_guard<osp::TimedMutex> lock(authMutex_);
             auth_.addUser(username, password, role);
             return osp::protocol::makeSuccessResponse({{"message", "User added"}, {"username", username}});
         }
@@ -527,7 +1255,7 @@ osp::protocol::Message ServerApp::handleCommand(const osp::protocol::Command&
             std::optional<osp::Role> targetRole;
             std::optional<osp::UserId> targetUserId;
             {
-                std::lock_guard<std::mutex> lock(authMutex_);
+                std::lock_guard<osp::TimedMutex> lock(authMutex_);
                 targetRole = auth_.getUserRole(username);
                 targetUserId = auth_.getUserId(username);
                 if (!targetRole)
@@ -547,7 +1275,7 @@ osp::protocol::Message ServerApp::handleCommand(const osp::protocol::Command&
             // Best-effort cleanup: remove reviewer_fields mapping if it exists.
             if (targetUserId)
             {
-                std::lock_guard<std::mutex> lock(vfsMutex_);
+                std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
                 const std::string fieldsPath = "/system/reviewer_fields/" + std::to_string(*targetUserId) + ".txt";
                 vfs_.removeFile(fieldsPath);
             }
@@ -564,7 +1292,7 @@ osp::protocol::Message ServerApp::handleCommand(const osp::protocol::Command&
             const std::string& roleStr = cmd.args[2];
 
             osp::Role role = stringToRole(roleStr);
-            std::lock_guard<std::mutex> lock(authMutex_);
+            std::lock_guard<osp::TimedMutex> lock(authMutex_);
             auto targetRole = auth_.getUserRole(username);
             if (!targetRole)
             {
@@ -590,7 +1318,7 @@ osp::protocol::Message ServerApp::handleCommand(const osp::protocol::Command&
             const std::string& username = cmd.args[1];
             const std::string& newPassword = cmd.args[2];
 
-            std::lock_guard<std::mutex> lock(authMutex_);
+            std::lock_guard<osp::TimedMutex> lock(authMutex_);
             auto targetRole = auth_.getUserRole(username);
             if (!targetRole)
             {
@@ -618,7 +1346,7 @@ osp::protocol::Message ServerApp::handleCommand(const osp::protocol::Command&
             const std::string& fieldsCsv = cmd.args[2];
 
             {
-                std::lock_guard<std::mutex> lock(authMutex_);
+                std::lock_guard<osp::TimedMutex> lock(authMutex_);
                 auto targetRole = auth_.getUserRole(username);
                 if (!targetRole)
                 {
@@ -632,7 +1360,7 @@ osp::protocol::Message ServerApp::handleCommand(const osp::protocol::Command&
 
             std::optional<osp::UserId> userIdOpt;
             {
-                std::lock_guard<std::mutex> lock(authMutex_);
+                std::lock_guard<osp::TimedMutex> lock(authMutex_);
                 userIdOpt = auth_.getUserId(username);
             }
             if (!userIdOpt)
@@ -657,7 +1385,7 @@ osp::protocol::Message ServerApp::handleCommand(const osp::protocol::Command&
             }
 
             {
-                std::lock_guard<std::mutex> lock(vfsMutex_);
+                std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
                 vfs_.createDirectory("/system");
                 vfs_.createDirectory("/system/reviewer_fields");
                 const std::string path = "/system/reviewer_fields/" + std::to_string(*userIdOpt) + ".txt";
@@ -691,28 +1419,126 @@ osp::protocol::Message ServerApp::handleCommand(const osp::protocol::Command&
         }
         const std::string& dstPath = cmd.args[0];
 
-        // 先确保 VFS 落盘（写块逻辑已 flush，这里再显式 flush 一次更稳）
+        // 先确保 VFS 落盘，再在同一把锁内导出：备份总是单文件镜像（条带镜像会被合并），可直接用于 RESTORE / osproj_fsck
         {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
+            std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
             if (!vfs_.sync())
             {
                 return osp::protocol::makeErrorResponse("FS_ERROR", "BACKUP failed: cannot sync VFS");
             }
+            if (!vfs_.exportImage(dstPath))
+            {
+                return osp::protocol::makeErrorResponse("FS_ERROR", "BACKUP failed: cannot write backup image",
+                                                        {{"path", dstPath}});
+            }
         }
 
-        try
+        return osp::protocol::makeSuccessResponse({{"message", "Backup completed"}, {"path", dstPath}});
+    }
+
+    // TRACE [ON|OFF|CLEAR|DUMP [path]]：请求追踪的运行期开关与导出（需以 -DOSP_ENABLE_TRACING=ON 编译）。
+    // DUMP 不带路径时在响应中返回 Chrome trace JSON，带路径时写到服务器主机上的该文件
+    if (cmd.name == "TRACE")
+    {
+        if (!maybeSession)
+        {
+            return osp::protocol::makeErrorResponse("AUTH_REQUIRED", "TRACE: need to login first");
+        }
+        if (maybeSession->role != osp::Role::Admin)
         {
-            namespace fs = std::filesystem;
-            fs::copy_file("data.fs", dstPath, fs::copy_options::overwrite_existing);
+            return osp::protocol::makeErrorResponse("PERMISSION_DENIED", "TRACE: permission denied");
         }
-        catch (const std::exception& e)
+        if (!osp::trace::kCompiledIn)
         {
-            return osp::protocol::makeErrorResponse("FS_ERROR",
-                                                    std::string("BACKUP failed: ") + e.what(),
-                                                    {{"path", dstPath}});
+            return osp::protocol::makeErrorResponse("TRACING_DISABLED",
+                                                    "TRACE: server was built without -DOSP_ENABLE_TRACING=ON");
         }
 
-        return osp::protocol::makeSuccessResponse({{"message", "Backup completed"}, {"path", dstPath}});
+        const std::string action = cmd.args.empty() ? "STATUS" : cmd.args[0];
+        if (action == "ON" || action == "OFF")
+        {
+            osp::trace::setEnabled(action == "ON");
+            return osp::protocol::makeSuccessResponse({{"message", "Tracing " + action}, {"enabled", action == "ON"}});
+        }
+        if (action == "CLEAR")
+        {
+            osp::trace::Registry::instance().clear();
+            return osp::protocol::makeSuccessResponse({{"message", "Trace buffers cleared"}});
+        }
+        if (action == "DUMP")
+        {
+            auto trace = osp::trace::Registry::instance().toChromeTrace();
+            const auto eventCount = trace["traceEvents"].size();
+            if (cmd.args.size() < 2)
+            {
+                return osp::protocol::makeSuccessResponse({{"events", eventCount}, {"trace", std::move(trace)}});
+            }
+
+            const std::string& dstPath = cmd.args[1];
+            std::ofstream      out(dstPath, std::ios::out | std::ios::trunc);
+            out << trace.dump();
+            if (!out)
+            {
+                return osp::protocol::makeErrorResponse("FS_ERROR", "TRACE DUMP failed: cannot write file",
+                                                        {{"path", dstPath}});
+            }
+            return osp::protocol::makeSuccessResponse(
+                {{"message", "Trace written"}, {"path", dstPath}, {"events", eventCount}});
+        }
+        if (action == "STATUS")
+        {
+            return osp::protocol::makeSuccessResponse({{"enabled", osp::trace::enabled()},
+                                                       {"bufferEventsPerThread", osp::trace::kThreadBufferEvents}});
+        }
+        return osp::protocol::makeErrorResponse("INVALID_ARGS", "TRACE: expected ON, OFF, CLEAR or DUMP [path]");
+    }
+
+    // BLOCK_TRACE START <path> | STOP：录制块访问追踪（写到服务器主机上的文件），用 osproj_cachesim 离线分析
+    if (cmd.name == "BLOCK_TRACE")
+    {
+        if (!maybeSession)
+        {
+            return osp::protocol::makeErrorResponse("AUTH_REQUIRED", "BLOCK_TRACE: need to login first");
+        }
+        if (maybeSession->role != osp::Role::Admin)
+        {
+            return osp::protocol::makeErrorResponse("PERMISSION_DENIED", "BLOCK_TRACE: permission denied");
+        }
+
+        const std::string action = cmd.args.empty() ? "STATUS" : cmd.args[0];
+        std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
+        if (action == "START")
+        {
+            if (cmd.args.size() < 2)
+            {
+                return osp::protocol::makeErrorResponse("MISSING_ARGS", "BLOCK_TRACE START: missing path");
+            }
+            if (vfs_.blockTraceActive())
+            {
+                return osp::protocol::makeErrorResponse("ALREADY_RUNNING", "BLOCK_TRACE: already recording");
+            }
+            if (!vfs_.startBlockTrace(cmd.args[1]))
+            {
+                return osp::protocol::makeErrorResponse("FS_ERROR", "BLOCK_TRACE START: cannot open file",
+                                                        {{"path", cmd.args[1]}});
+            }
+            return osp::protocol::makeSuccessResponse({{"message", "Block trace started"}, {"path", cmd.args[1]}});
+        }
+        if (action == "STOP")
+        {
+            const auto records = vfs_.stopBlockTrace();
+            if (!records)
+            {
+                return osp::protocol::makeErrorResponse("NOT_RUNNING", "BLOCK_TRACE: not recording");
+            }
+            return osp::protocol::makeSuccessResponse({{"message", "Block trace stopped"}, {"records", *records}});
+        }
+        if (action == "STATUS")
+        {
+            return osp::protocol::makeSuccessResponse(
+                {{"recording", vfs_.blockTraceActive()}, {"records", vfs_.blockTraceRecords()}});
+        }
+        return osp::protocol::makeErrorResponse("INVALID_ARGS", "BLOCK_TRACE: expected START <path> or STOP");
     }
 
     if (cmd.name == "RESTORE")
@@ -740,12 +1566,24 @@ osp::protocol::Message ServerApp::handleCommand(const osp::protocol::Command&
         bool ok = false;
         {
             // RESTORE 同时会影响 VFS 与用户数据，避免并发期间读到不一致状态
-            std::scoped_lock lock(vfsMutex_, authMutex_);
+            std::unique_lock<osp::TimedMutex> vfsLock(vfsMutex_, std::defer_lock);
+            std::unique_lock<osp::TimedMutex> authLock(authMutex_, std::defer_lock);
+            std::lock(vfsLock, authLock);
 
             ok = vfs_.remount([&](const std::string& backingFile) -> bool {
                 try
                 {
                     fs::copy_file(srcPath, backingFile, fs::copy_options::overwrite_existing);
+                    // BACKUP 会把归档包一并导出为 <备份>.pack；备份没有归档包时也要去掉当前的包
+                    const std::string packPath = osp::fs::Vfs::packPathFor(backingFile);
+                    if (fs::exists(osp::fs::Vfs::packPathFor(srcPath)))
+                    {
+                        fs::copy_file(osp::fs::Vfs::packPathFor(srcPath), packPath, fs::copy_options::overwrite_existing);
+                    }
+                    else
+                    {
+                        fs::remove(packPath);
+                    }
                     return true;
                 }
                 catch (...)
@@ -759,13 +1597,45 @@ osp::protocol::Message ServerApp::handleCommand(const osp::protocol::Command&
                 return osp::protocol::makeErrorResponse("FS_ERROR", "RESTORE failed: copy/remount failed", {{"path", srcPath}});
             }
 
-            // 重新加载用户（AuthService::loadUsers 会先清空内存态用户表）
+            // 重新加载用户（AuthService::loadUsers 会先清空内存态用户表）。
+            // 它经由 initAuthVfsOperations 的回调自行加 vfsMutex_，先释放 VFS 锁，只保留 authMutex_（与其它路径的加锁顺序一致）
+            vfsLock.unlock();
             auth_.loadUsers();
         }
 
         return osp::protocol::makeSuccessResponse({{"message", "Restore completed"}, {"path", srcPath}});
     }
 
+    if (cmd.name == "COMPACT")
+    {
+        if (!maybeSession)
+        {
+            return osp::protocol::makeErrorResponse("AUTH_REQUIRED", "COMPACT: need to login first");
+        }
+        if (maybeSession->role != osp::Role::Admin)
+        {
+            return osp::protocol::makeErrorResponse("PERMISSION_DENIED", "COMPACT: permission denied");
+        }
+
+        std::optional<osp::fs::Vfs::CompactStats> stats;
+        {
+            std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
+            stats = vfs_.compact();
+        }
+        if (!stats)
+        {
+            return osp::protocol::makeErrorResponse("FS_ERROR", "COMPACT failed");
+        }
+
+        return osp::protocol::makeSuccessResponse({
+            {"message", "Compaction completed"},
+            {"liveBlocks", stats->liveBlocks},
+            {"movedBlocks", stats->movedBlocks},
+            {"fileBytesBefore", stats->fileBytesBefore},
+            {"fileBytesAfter", stats->fileBytesAfter}
+        });
+    }
+
     if (cmd.name == "VIEW_SYSTEM_STATUS")
     {
         if (!maybeSession)
@@ -780,92 +1650,390 @@ osp::protocol::Message ServerApp::handleCommand(const osp::protocol::Command&
         std::size_t userCount{};
         std::size_t sessionCount{};
         {
-            std::lock_guard<std::mutex> lock(authMutex_);
+            std::lock_guard<osp::TimedMutex> lock(authMutex_);
             userCount = auth_.getAllUsers().size();
             sessionCount = auth_.sessionCount();
         }
 
         // Papers: 通过遍历 /papers/<id>/ 目录计数（只统计一级目录项）
+        // Reviews: 遍历每篇论文的 /reviews 目录内文件数量
         std::size_t paperCount = 0;
-        std::optional<std::string> papersListing;
+        std::size_t reviewCount = 0;
+        {
+            std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
+            if (auto papers = vfs_.openDirectory("/papers"))
+            {
+                osp::fs::Vfs::DirEntryInfo entry;
+                while (papers->next(entry))
+                {
+                    if (entry.type != osp::fs::FileType::Directory)
+                    {
+                        continue;
+                    }
+                    ++paperCount;
+
+                    auto reviews = vfs_.openDirectory("/papers/" + std::string(entry.name) + "/reviews");
+                    if (!reviews)
+                    {
+                        continue;
+                    }
+                    osp::fs::Vfs::DirEntryInfo f;
+                    while (reviews->next(f))
+                    {
+                        if (f.type == osp::fs::FileType::File)
+                        {
+                            ++reviewCount;
+                        }
+                    }
+                }
+            }
+        }
+
+        osp::fs::BlockCache::Stats       cs;
+        osp::fs::Vfs::FragmentationStats frag;
+        osp::fs::Vfs::DefragStats        defrag;
+        bool                             directIo = false;
+        std::uint32_t                    stripeMembers = 1;
+        std::uint32_t                    stripeUnitBlocks = 1;
+        osp::fs::Vfs::ArchiveStats       archive;
+        bool                             readOnly = false;
         {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
-            papersListing = vfs_.listDirectory("/papers");
+            std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
+            archive = vfs_.archiveStats();
+            readOnly = vfs_.readOnly();
+            cs = vfs_.cacheStats();
+            directIo = vfs_.directIo();
+            stripeMembers = vfs_.stripeMembers();
+            stripeUnitBlocks = vfs_.stripeUnitBlocks();
+            frag = vfs_.fragmentation();
+            defrag = vfs_.defragStats();
         }
         
-        if (papersListing)
+        json data;
+        data["users"] = userCount;
+        data["sessions"] = sessionCount;
+        data["papers"] = paperCount;
+        data["reviews"] = reviewCount;
+        data["readOnly"] = readOnly; // 事务提交中途写盘失败后为 true，重启或 RESTORE 后恢复
+        data["blockCache"] = {
+            {"capacityBytes", cs.capacityBytes},
+            {"bytes", cs.bytes},
+            {"entries", cs.entries},
+            {"hits", cs.hits},
+            {"misses", cs.misses},
+            {"replacements", cs.replacements},
+            {"ghostHits", cs.ghostHits},
+            {"directIo", directIo},
+            {"stripeMembers", stripeMembers},
+            {"stripeUnitBlocks", stripeUnitBlocks}
+        };
+        // fragmentedRatio：多块文件中数据块不连续的比例；extentsPerFile 为 1 表示全部连续
+        data["fragmentation"] = {
+            {"multiBlockFiles", frag.multiBlockFiles},
+            {"fragmentedFiles", frag.fragmentedFiles},
+            {"extents", frag.extents},
+            {"blocks", frag.blocks},
+            {"fragmentedRatio", frag.multiBlockFiles == 0 ? 0.0 : static_cast<double>(frag.fragmentedFiles) / frag.multiBlockFiles},
+            {"extentsPerFile", frag.multiBlockFiles == 0 ? 1.0 : static_cast<double>(frag.extents) / frag.multiBlockFiles},
+            {"defragPasses", defrag.passes},
+            {"defragMovedFiles", defrag.movedFiles},
+            {"defragMovedBlocks", defrag.movedBlocks}
+        };
+        // 冷数据归档：papers 为归档包中的论文目录数（也计入上面的 papers / reviews）
+        data["archive"] = {
+            {"papers", archive.roots},
+            {"entries", archive.entries},
+            {"rawBytes", archive.rawBytes},
+            {"packBytes", archive.packBytes},
+            {"archivedTotal", archive.archivedRoots},
+            {"restoredTotal", archive.restoredRoots}
+        };
+        // 持久化：commits 为等待过落盘的写命令数，avgBatch 为平均每次 fdatasync 覆盖的命令数
+        const auto& dc = groupCommit_.config();
+        const auto  gc = groupCommit_.stats();
+        data["durability"] = {
+            {"mode", osp::fs::durabilityModeName(dc.mode)},
+            {"intervalMs", dc.intervalMs},
+            {"maxBatch", dc.maxBatch},
+            {"commits", gc.commits},
+            {"syncs", gc.syncs},
+            {"failedSyncs", gc.failedSyncs},
+            {"avgBatch", gc.syncs == 0 ? 0.0 : static_cast<double>(gc.commits) / static_cast<double>(gc.syncs)},
+            {"largestBatch", gc.maxBatch},
+            {"avgSyncUs", gc.syncs == 0 ? 0 : gc.syncNanos / gc.syncs / 1000},
+            {"maxSyncUs", gc.maxSyncNanos / 1000},
+            {"avgWaitUs", gc.commits == 0 ? 0 : gc.waitNanos / gc.commits / 1000}
+        };
+
+        return osp::protocol::makeSuccessResponse(data);
+    }
+
+    // METRICS：按命令统计的延迟分布、锁等待与块读写次数；METRICS RESET（仅管理员）返回当前值后清零
+    if (cmd.name == "METRICS")
+    {
+        if (!maybeSession)
+        {
+            return osp::protocol::makeErrorResponse("AUTH_REQUIRED", "METRICS: need to login first");
+        }
+        if (maybeSession->role != osp::Role::Admin && maybeSession->role != osp::Role::Editor)
+        {
+            return osp::protocol::makeErrorResponse("PERMISSION_DENIED", "METRICS: permission denied");
+        }
+
+        const bool reset = !cmd.args.empty() && cmd.args[0] == "RESET";
+        if (reset && maybeSession->role != osp::Role::Admin)
+        {
+            return osp::protocol::makeErrorResponse("PERMISSION_DENIED", "METRICS RESET: permission denied");
+        }
+
+        auto data = metrics_.toJson();
+        if (reset)
+        {
+            metrics_.reset();
+            data["reset"] = true;
+        }
+        return osp::protocol::makeSuccessResponse(data);
+    }
+
+    // LOCK_PROFILE：vfsMutex_ / authMutex_ 的采样竞争分析（按持锁命令汇总等待与持锁时间）；
+    // LOCK_PROFILE RESET（仅管理员）返回当前值后清零
+    if (cmd.name == "LOCK_PROFILE")
+    {
+        if (!maybeSession)
+        {
+            return osp::protocol::makeErrorResponse("AUTH_REQUIRED", "LOCK_PROFILE: need to login first");
+        }
+        if (maybeSession->role != osp::Role::Admin && maybeSession->role != osp::Role::Editor)
+        {
+            return osp::protocol::makeErrorResponse("PERMISSION_DENIED", "LOCK_PROFILE: permission denied");
+        }
+
+        const bool reset = !cmd.args.empty() && cmd.args[0] == "RESET";
+        if (reset && maybeSession->role != osp::Role::Admin)
+        {
+            return osp::protocol::makeErrorResponse("PERMISSION_DENIED", "LOCK_PROFILE RESET: permission denied");
+        }
+
+        json data;
+        data["sampleEvery"] = osp::TimedMutex::sampleEvery().load(std::memory_order_relaxed);
+        data["locks"] = json::array({lockProfileToJson(vfsMutex_.profile()), lockProfileToJson(authMutex_.profile())});
+        if (reset)
+        {
+            vfsMutex_.resetProfile();
+            authMutex_.resetProfile();
+            data["reset"] = true;
+        }
+        return osp::protocol::makeSuccessResponse(data);
+    }
+
+    // SLOW_LOG：最近处理时间超过阈值的请求（新的在前）及其锁等待、缓存命中 / 未命中、VFS 调用次数；
+    // SLOW_LOG RESET 清空，SLOW_LOG THRESHOLD <ms> 调整阈值（均仅管理员）
+    if (cmd.name == "SLOW_LOG")
+    {
+        if (!maybeSession)
+        {
+            return osp::protocol::makeErrorResponse("AUTH_REQUIRED", "SLOW_LOG: need to login first");
+        }
+        if (maybeSession->role != osp::Role::Admin)
+        {
+            return osp::protocol::makeErrorResponse("PERMISSION_DENIED", "SLOW_LOG: permission denied");
+        }
+
+        const std::string sub = cmd.args.empty() ? std::string() : cmd.args[0];
+        if (sub == "THRESHOLD")
+        {
+            if (cmd.args.size() < 2)
+            {
+                return osp::protocol::makeErrorResponse("MISSING_ARGS", "Usage: SLOW_LOG THRESHOLD <ms>");
+            }
+            std::uint64_t ms = 0;
+            try
+            {
+                ms = std::stoull(cmd.args[1]);
+            }
+            catch (...)
+            {
+                return osp::protocol::makeErrorResponse("INVALID_ARGS", "Usage: SLOW_LOG THRESHOLD <ms>");
+            }
+            slowLog_.setThresholdUs(ms * 1000);
+            return osp::protocol::makeSuccessResponse({{"thresholdMs", ms}});
+        }
+        if (!sub.empty() && sub != "RESET")
+        {
+            return osp::protocol::makeErrorResponse("INVALID_ARGS", "Usage: SLOW_LOG [RESET | THRESHOLD <ms>]");
+        }
+
+        auto data = slowLog_.toJson();
+        if (sub == "RESET")
+        {
+            slowLog_.clear();
+            data["reset"] = true;
+        }
+        return osp::protocol::makeSuccessResponse(data);
+    }
+
+    // CACHE_CONFIG：查看块缓存预算；SIZE <bytes> 在线调整（关闭自动调节），AUTO <min> <max> / AUTO OFF 开关自动调节。
+    // 字节数可带 K/M/G 后缀，上限为物理内存的一半
+    if (cmd.name == "CACHE_CONFIG")
+    {
+        if (!maybeSession)
+        {
+            return osp::protocol::makeErrorResponse("AUTH_REQUIRED", "CACHE_CONFIG: need to login first");
+        }
+        if (maybeSession->role != osp::Role::Admin)
+        {
+            return osp::protocol::makeErrorResponse("PERMISSION_DENIED", "CACHE_CONFIG: permission denied");
+        }
+
+        static const std::string kUsage = "Usage: CACHE_CONFIG [SIZE <bytes> | AUTO <minBytes> <maxBytes> | AUTO OFF]";
+        const std::string sub = cmd.args.empty() ? std::string() : cmd.args[0];
+        const std::size_t limit = maxCacheBytes();
+
+        std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
+        if (sub == "SIZE")
+        {
+            if (cmd.args.size() < 2)
+            {
+                return osp::protocol::makeErrorResponse("MISSING_ARGS", kUsage);
+            }
+            const auto bytes = osp::fs::parseByteSize(cmd.args[1]);
+            if (!bytes)
+            {
+                return osp::protocol::makeErrorResponse("INVALID_ARGS", kUsage);
+            }
+            vfs_.resizeCache(std::min(*bytes, limit));
+        }
+        else if (sub == "AUTO")
         {
-            std::stringstream ss(*papersListing);
-            std::string       entry;
-            while (std::getline(ss, entry))
+            if (cmd.args.size() == 2 && cmd.args[1] == "OFF")
+            {
+                vfs_.disableCacheAutoTune();
+            }
+            else
             {
-                if (!entry.empty() && entry.back() == '/')
+                if (cmd.args.size() < 3)
                 {
-                    ++paperCount;
+                    return osp::protocol::makeErrorResponse("MISSING_ARGS", kUsage);
+                }
+                const auto minBytes = osp::fs::parseByteSize(cmd.args[1]);
+                const auto maxBytes = osp::fs::parseByteSize(cmd.args[2]);
+                if (!minBytes || !maxBytes || *minBytes > *maxBytes)
+                {
+                    return osp::protocol::makeErrorResponse("INVALID_ARGS", kUsage);
                 }
+                vfs_.setCacheAutoTune(std::min(*minBytes, limit), std::min(*maxBytes, limit));
             }
         }
+        else if (!sub.empty())
+        {
+            return osp::protocol::makeErrorResponse("INVALID_ARGS", kUsage);
+        }
 
-        // Reviews: 遍历每篇论文的 /reviews 目录内文件数量
-        std::size_t reviewCount = 0;
-        if (papersListing)
+        const auto  cs = vfs_.cacheStats();
+        const auto& tune = vfs_.cacheAutoTune();
+        const auto  accesses = cs.hits + cs.misses;
+        return osp::protocol::makeSuccessResponse({
+            {"capacityBytes", cs.capacityBytes},
+            {"bytes", cs.bytes},
+            {"entries", cs.entries},
+            {"hitRatio", accesses == 0 ? 0.0 : static_cast<double>(cs.hits) / static_cast<double>(accesses)},
+            {"ghostHits", cs.ghostHits},
+            {"resizes", cs.resizes},
+            {"limitBytes", limit},
+            {"auto", {{"enabled", tune.enabled}, {"minBytes", tune.minBytes}, {"maxBytes", tune.maxBytes}}}
+        });
+    }
+
+    // ARCHIVE：查看冷数据归档包；RUN 立即执行一次归档（与后台线程的选取条件相同）
+    if (cmd.name == "ARCHIVE")
+    {
+        if (!maybeSession)
+        {
+            return osp::protocol::makeErrorResponse("AUTH_REQUIRED", "ARCHIVE: need to login first");
+        }
+        if (maybeSession->role != osp::Role::Admin)
+        {
+            return osp::protocol::makeErrorResponse("PERMISSION_DENIED", "ARCHIVE: permission denied");
+        }
+
+        const std::string sub = cmd.args.empty() ? std::string() : cmd.args[0];
+        if (!sub.empty() && sub != "RUN")
+        {
+            return osp::protocol::makeErrorResponse("INVALID_ARGS", "Usage: ARCHIVE [RUN]");
+        }
+
+        std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
+        json data;
+        if (sub == "RUN")
+        {
+            const auto result = runTieringPass();
+            if (!result)
+            {
+                return osp::protocol::makeErrorResponse("FS_ERROR", "ARCHIVE: archiving failed");
+            }
+            data["archived"] = {
+                {"papers", result->roots},
+                {"files", result->files},
+                {"rawBytes", result->rawBytes}
+            };
+        }
+
+        const auto stats = vfs_.archiveStats();
+        data["papers"] = stats.roots;
+        data["entries"] = stats.entries;
+        data["rawBytes"] = stats.rawBytes;
+        data["packBytes"] = stats.packBytes;
+        data["archivedTotal"] = stats.archivedRoots;
+        data["restoredTotal"] = stats.restoredRoots;
+        data["intervalSec"] = tierIntervalSec_;
+        data["minAgeSec"] = tierMinAgeSec_;
+        return osp::protocol::makeSuccessResponse(data);
+    }
+
+    // 变更事件：EVENTS 返回缓冲区中的增量事件；WATCH 在 acceptWatchConnection 中被接管为长连接
+    if (cmd.name == "EVENTS" || cmd.name == "WATCH")
+    {
+        if (!maybeSession)
+        {
+            return osp::protocol::makeErrorResponse("AUTH_REQUIRED", cmd.name + ": need to login first");
+        }
+
+        std::uint64_t since = 0;
+        if (!cmd.args.empty())
         {
-            std::stringstream ss(*papersListing);
-            std::string       entry;
-            while (std::getline(ss, entry))
+            try
             {
-                if (entry.empty() || entry.back() != '/')
-                {
-                    continue;
-                }
-
-                const std::string pidStr = entry.substr(0, entry.size() - 1);
-                const std::string reviewsDir = "/papers/" + pidStr + "/reviews";
-                std::optional<std::string> reviewsListing;
-                {
-                    std::lock_guard<std::mutex> lock(vfsMutex_);
-                    reviewsListing = vfs_.listDirectory(reviewsDir);
-                }
-                if (!reviewsListing)
-                {
-                    continue;
-                }
-                std::stringstream rss(*reviewsListing);
-                std::string       f;
-                while (std::getline(rss, f))
-                {
-                    if (!f.empty() && f.back() != '/')
-                    {
-                        ++reviewCount;
-                    }
-                }
+                since = std::stoull(cmd.args[0]);
+            }
+            catch (...)
+            {
+                return osp::protocol::makeErrorResponse("INVALID_ARGS", "Usage: " + cmd.name + " [sinceSeq]");
             }
         }
 
-        osp::fs::BlockCache::Stats cs;
+        if (cmd.name == "WATCH")
         {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
-            cs = vfs_.cacheStats();
+            return osp::protocol::makeErrorResponse("UNSUPPORTED", "WATCH: connection cannot be used for push");
         }
-        
-        json data;
-        data["users"] = userCount;
-        data["sessions"] = sessionCount;
-        data["papers"] = paperCount;
-        data["reviews"] = reviewCount;
-        data["blockCache"] = {
-            {"capacity", cs.capacity},
-            {"entries", cs.entries},
-            {"hits", cs.hits},
-            {"misses", cs.misses},
-            {"replacements", cs.replacements}
-        };
 
-        return osp::protocol::makeSuccessResponse(data);
+        bool truncated = false;
+        json events = json::array();
+        for (const auto& e : events_.since(since, truncated))
+        {
+            if (EventFeed::visibleTo(e, maybeSession->role, maybeSession->userId))
+            {
+                events.push_back(EventFeed::toJson(e));
+            }
+        }
+        return osp::protocol::makeSuccessResponse({
+            {"events", events},
+            {"lastSeq", events_.lastSeq()},
+            {"truncated", truncated}
+        });
     }
 
     // 文件系统相关命令
-    if (cmd.name == "MKDIR" || cmd.name == "WRITE" || cmd.name == "READ" || cmd.name == "RM"
+    if (cmd.name == "MKDIR" || cmd.name == "WRITE" || cmd.name == "APPEND" || cmd.name == "READ" || cmd.name == "STAT" || cmd.name == "RM"
         || cmd.name == "RMDIR" || cmd.name == "LIST")
     {
         return handleFsCommand(cmd, maybeSession);
@@ -903,37 +2071,29 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
             return osp::protocol::makeErrorResponse("PERMISSION_DENIED", "Permission denied");
         }
 
-        std::optional<std::string> listing;
-        {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
-            listing = vfs_.listDirectory("/papers");
-        }
-        
+        // 整个列表在一次加锁内完成（只读事务，无需 commit），各论文的路径解析共享 /papers 前缀
+        osp::fs::Vfs::Transaction tx(vfs_, vfsMutex_);
+
+        auto listing = tx->openDirectory("/papers");
         if (!listing)
         {
             return osp::protocol::makeSuccessResponse({{"papers", json::array()}});
         }
 
-        std::stringstream ss(*listing);
-        std::string       entry;
-        json              papers = json::array();
+        osp::fs::Vfs::DirEntryInfo entry;
+        json                       papers = json::array();
 
-        while (std::getline(ss, entry))
+        while (listing->next(entry))
         {
-            if (entry.empty() || entry.back() != '/')
+            if (entry.type != osp::fs::FileType::Directory)
             {
                 continue;
             }
 
-            std::string pidStr   = entry.substr(0, entry.size() - 1);
+            std::string pidStr(entry.name);
             std::string metaPath = "/papers/" + pidStr + "/meta.txt";
 
-            std::optional<std::string> metaData;
-            {
-                std::lock_guard<std::mutex> lock(vfsMutex_);
-                metaData = vfs_.readFile(metaPath);
-            }
-            
+            auto metaData = tx->readFile(metaPath);
             if (!metaData)
             {
                 continue;
@@ -963,12 +2123,8 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
             if (isReviewer)
             {
                 std::string reviewersPath = "/papers/" + pidStr + "/reviewers.txt";
-                std::optional<std::string> reviewersData;
-                {
-                    std::lock_guard<std::mutex> lock(vfsMutex_);
-                    reviewersData = vfs_.readFile(reviewersPath);
-                }
-                
+                auto        reviewersData = tx->readFile(reviewersPath);
+
                 bool assigned = false;
                 if (reviewersData)
                 {
@@ -1001,6 +2157,100 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
         return osp::protocol::makeSuccessResponse({{"papers", papers}});
     }
 
+    if (cmd.name == "SEARCH")
+    {
+        std::string query = trimCopy(cmd.rawArgs);
+        if (query.empty())
+        {
+            return osp::protocol::makeErrorResponse("MISSING_ARGS", "Usage: SEARCH <query...>");
+        }
+
+        const bool isAuthor   = (maybeSession->role == osp::Role::Author);
+        const bool isReviewer = (maybeSession->role == osp::Role::Reviewer);
+        const std::string myIdStr = std::to_string(maybeSession->userId);
+
+        constexpr std::size_t kSearchLimit = 20;
+
+        json results = json::array();
+        {
+            std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
+
+            // 之前的写入或本次查询遇到无法解码的桶时，从 /papers 重建后再查
+            auto hits = searchIndex_.needsRebuild() ? std::vector<osp::search::InvertedIndex::Hit>{}
+                                                    : searchIndex_.search(query, 0);
+            if (searchIndex_.needsRebuild())
+            {
+                OSP_LOG(osp::LogLevel::Warn, "SEARCH: search index is corrupted, rebuilding from /papers");
+                searchIndex_.rebuild();
+                hits = searchIndex_.search(query, 0);
+            }
+
+            // 只读取索引桶与命中论文的 meta / reviewers（做权限过滤），不读取正文
+            for (const auto& hit : hits)
+            {
+                const std::string pidStr = std::to_string(hit.paperId);
+                auto metaData = vfs_.readFile("/papers/" + pidStr + "/meta.txt");
+                if (!metaData)
+                {
+                    continue;
+                }
+
+                std::stringstream metaSS(*metaData);
+                std::uint32_t     p_id;
+                std::uint32_t     p_authorId;
+                std::string       p_status;
+                std::string       p_title;
+                if (!(metaSS >> p_id >> p_authorId >> p_status))
+                {
+                    continue;
+                }
+                char dummy;
+                metaSS.get(dummy);
+                std::getline(metaSS, p_title);
+
+                if (isAuthor && p_authorId != maybeSession->userId)
+                {
+                    continue;
+                }
+                if (isReviewer)
+                {
+                    bool assigned = false;
+                    if (auto reviewersData = vfs_.readFile("/papers/" + pidStr + "/reviewers.txt"))
+                    {
+                        std::stringstream rss(*reviewersData);
+                        std::string       rid;
+                        while (rss >> rid)
+                        {
+                            if (rid == myIdStr)
+                            {
+                                assigned = true;
+                                break;
+                            }
+                        }
+                    }
+                    if (!assigned)
+                    {
+                        continue;
+                    }
+                }
+
+                results.push_back({
+                    {"id", p_id},
+                    {"title", p_title},
+                    {"status", p_status},
+                    {"authorId", p_authorId},
+                    {"score", hit.score}
+                });
+                if (results.size() >= kSearchLimit)
+                {
+                    break;
+                }
+            }
+        }
+
+        return osp::protocol::makeSuccessResponse({{"query", query}, {"papers", results}});
+    }
+
     if (cmd.name == "SET_PAPER_FIELDS")
     {
         if (!maybeSession)
@@ -1018,7 +2268,7 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
 
         std::optional<std::string> metaData;
         {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
+            std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
             metaData = vfs_.readFile(metaPath);
         }
         if (!metaData)
@@ -1067,7 +2317,7 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
 
         const std::string fieldsPath = paperDir + "/fields.txt";
         {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
+            std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
             if (!vfs_.writeFile(fieldsPath, toWrite))
             {
                 return osp::protocol::makeErrorResponse("FS_ERROR", "Failed to save paper fields");
@@ -1091,7 +2341,31 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
     {
         if (cmd.args.empty())
         {
-            return osp::protocol::makeErrorResponse("MISSING_ARGS", "Usage: GET_PAPER <PaperID>");
+            return osp::protocol::makeErrorResponse("MISSING_ARGS", "Usage: GET_PAPER <PaperID> [offset] [length]");
+        }
+
+        // 可选的分页参数：只返回正文 [offset, offset + length) 字节区间（按 UTF-8 字符边界对齐）
+        const bool  ranged = cmd.args.size() >= 2;
+        std::size_t rangeOffset = 0;
+        std::size_t rangeLength = kPaperPageBytes;
+        if (ranged)
+        {
+            try
+            {
+                rangeOffset = static_cast<std::size_t>(std::stoull(cmd.args[1]));
+                if (cmd.args.size() >= 3)
+                {
+                    rangeLength = static_cast<std::size_t>(std::stoull(cmd.args[2]));
+                }
+            }
+            catch (...)
+            {
+                return osp::protocol::makeErrorResponse("INVALID_ARGS", "Usage: GET_PAPER <PaperID> [offset] [length]");
+            }
+            if (rangeLength == 0)
+            {
+                return osp::protocol::makeErrorResponse("INVALID_ARGS", "GET_PAPER: length must be positive");
+            }
         }
 
         std::string pidStr   = cmd.args[0];
@@ -1101,7 +2375,7 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
         std::optional<std::string> metaData;
         std::optional<std::string> fieldsData;
         {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
+            std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
             metaData = vfs_.readFile(metaPath);
             fieldsData = vfs_.readFile(fieldsPath);
         }
@@ -1132,7 +2406,7 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
             std::string reviewersPath = "/papers/" + pidStr + "/reviewers.txt";
             std::optional<std::string> reviewersData;
             {
-                std::lock_guard<std::mutex> lock(vfsMutex_);
+                std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
                 reviewersData = vfs_.readFile(reviewersPath);
             }
             
@@ -1159,9 +2433,19 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
 
         std::string contentPath = "/papers/" + pidStr + "/content.txt";
         std::optional<std::string> contentData;
+        std::size_t                contentSize = 0;
         {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
-            contentData = vfs_.readFile(contentPath);
+            std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
+            if (ranged)
+            {
+                // 只读取覆盖该区间的块；多读 4 字节用于对齐字符边界
+                contentData = vfs_.readFileRange(contentPath, rangeOffset, rangeLength + 4, &contentSize);
+            }
+            else
+            {
+                contentData = vfs_.readFile(contentPath);
+                contentSize = contentData ? contentData->size() : 0;
+            }
         }
 
         json data;
@@ -1169,7 +2453,23 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
         data["title"] = p_title;
         data["status"] = p_status;
         data["authorId"] = p_authorId;
-        data["content"] = contentData ? *contentData : "";
+        data["contentSize"] = contentSize;
+        if (ranged)
+        {
+            std::size_t skipped = 0;
+            std::string page = contentData ? utf8Slice(*contentData, rangeLength, skipped) : std::string{};
+            const std::size_t pageOffset = std::min(rangeOffset + skipped, contentSize);
+            const std::size_t nextOffset = pageOffset + page.size();
+
+            data["content"] = std::move(page);
+            data["contentOffset"] = pageOffset;
+            data["nextOffset"] = nextOffset;
+            data["hasMore"] = nextOffset < contentSize;
+        }
+        else
+        {
+            data["content"] = contentData ? *contentData : "";
+        }
 
         json fieldsArr = json::array();
         if (fieldsData)
@@ -1221,15 +2521,16 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
         std::string paperDir = "/papers/" + std::to_string(pid);
 
         {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
-            vfs_.createDirectory("/papers");
+            // 目录、正文、元数据在同一事务中写入：任一步失败都不会留下半成品论文目录
+            osp::fs::Vfs::Transaction tx(vfs_, vfsMutex_);
+            tx->createDirectory("/papers");
 
-            if (!vfs_.createDirectory(paperDir))
+            if (!tx->createDirectory(paperDir))
             {
                 return osp::protocol::makeErrorResponse("FS_ERROR", "Failed to create paper directory");
             }
 
-            if (!vfs_.writeFile(paperDir + "/content.txt", content))
+            if (!tx->writeFile(paperDir + "/content.txt", content))
             {
                 return osp::protocol::makeErrorResponse("FS_ERROR", "Failed to save paper content");
             }
@@ -1240,12 +2541,29 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
                  << osp::domain::paperStatusToString(osp::domain::PaperStatus::Submitted) << "\n"
                  << title;
 
-            if (!vfs_.writeFile(paperDir + "/meta.txt", meta.str()))
+            if (!tx->writeFile(paperDir + "/meta.txt", meta.str()))
             {
                 return osp::protocol::makeErrorResponse("FS_ERROR", "Failed to save paper metadata");
             }
+
+            // 索引写入失败时整体回滚，旧的倒排桶保持不变；
+            // 索引已损坏（等待下次 SEARCH 时从 /papers 重建）时照常提交，重建会包含这篇论文
+            if (!searchIndex_.addDocument(pid, title, content) && !searchIndex_.needsRebuild())
+            {
+                OSP_LOG(osp::LogLevel::Error, "SUBMIT: failed to index paper " + std::to_string(pid));
+                return osp::protocol::makeErrorResponse("FS_ERROR", "SUBMIT failed: cannot update search index");
+            }
+
+            if (!tx.commit())
+            {
+                return osp::protocol::makeErrorResponse("FS_ERROR", "Failed to save paper");
+            }
         }
 
+        events_.publish("PaperSubmitted",
+                        {{"paperId", pid}, {"title", title}, {"authorId", maybeSession->userId}},
+                        {maybeSession->userId});
+
         return osp::protocol::makeSuccessResponse({{"message", "Paper submitted successfully"}, {"paperId", pid}});
     }
 
@@ -1286,12 +2604,11 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
         const std::string contentPath = paperDir + "/content.txt";
         const std::string revisionsDir = paperDir + "/revisions";
 
+        // 校验作者、保存历史版本、写入新内容与 meta 在同一事务中完成
+        osp::fs::Vfs::Transaction tx(vfs_, vfsMutex_);
+
         // 读 meta，校验作者
-        std::optional<std::string> metaData;
-        {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
-            metaData = vfs_.readFile(metaPath);
-        }
+        auto metaData = tx->readFile(metaPath);
         if (!metaData)
         {
             return osp::protocol::makeErrorResponse("NOT_FOUND", "Paper not found");
@@ -1319,71 +2636,86 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
         }
 
         std::uint32_t newVersion = 1;
-        {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
 
-            // 确保 revisions 目录存在（不存在则创建）
-            if (!vfs_.listDirectory(revisionsDir))
-            {
-                vfs_.createDirectory(revisionsDir);
-            }
+        // 确保 revisions 目录存在（不存在则创建）
+        if (!tx->exists(revisionsDir))
+        {
+            tx->createDirectory(revisionsDir);
+        }
 
-            // 计算下一个版本号：扫描 vN.txt
-            if (auto listing = vfs_.listDirectory(revisionsDir))
+        // 计算下一个版本号：扫描 vN.txt
+        if (auto listing = tx->openDirectory(revisionsDir))
+        {
+            osp::fs::Vfs::DirEntryInfo entry;
+            std::uint32_t              maxV = 0;
+            while (listing->next(entry))
             {
-                std::stringstream ss(*listing);
-                std::string       entry;
-                std::uint32_t     maxV = 0;
-                while (std::getline(ss, entry))
+                if (entry.type != osp::fs::FileType::File)
+                {
+                    continue;
+                }
+                // 期望格式：v<number>.txt
+                const std::string_view name = entry.name;
+                if (name.size() >= 6 && name.front() == 'v' && name.substr(name.size() - 4) == ".txt")
                 {
-                    if (entry.empty() || entry.back() == '/')
+                    const std::string numStr(name.substr(1, name.size() - 1 - 4));
+                    try
                     {
-                        continue;
+                        std::uint32_t v = static_cast<std::uint32_t>(std::stoul(numStr));
+                        if (v > maxV) maxV = v;
                     }
-                    // 期望格式：v<number>.txt
-                    if (entry.size() >= 6 && entry.front() == 'v' && entry.rfind(".txt") == entry.size() - 4)
+                    catch (...)
                     {
-                        const std::string numStr = entry.substr(1, entry.size() - 1 - 4);
-                        try
-                        {
-                            std::uint32_t v = static_cast<std::uint32_t>(std::stoul(numStr));
-                            if (v > maxV) maxV = v;
-                        }
-                        catch (...)
-                        {
-                            // ignore
-                        }
+                        // ignore
                     }
                 }
-                newVersion = maxV + 1;
             }
+            newVersion = maxV + 1;
+        }
 
-            // 保存旧内容到 revisions
-            const std::string revPath = revisionsDir + "/v" + std::to_string(newVersion) + ".txt";
-            const auto        oldContent = vfs_.readFile(contentPath);
-            if (!vfs_.writeFile(revPath, oldContent ? *oldContent : std::string{}))
-            {
-                return osp::protocol::makeErrorResponse("FS_ERROR", "REVISE failed: cannot save revision history");
-            }
+        // 保存旧内容到 revisions
+        const std::string revPath = revisionsDir + "/v" + std::to_string(newVersion) + ".txt";
+        const auto        oldContent = tx->readFile(contentPath);
+        if (!tx->writeFile(revPath, oldContent ? *oldContent : std::string{}))
+        {
+            return osp::protocol::makeErrorResponse("FS_ERROR", "REVISE failed: cannot save revision history");
+        }
 
-            // 写入新内容
-            if (!vfs_.writeFile(contentPath, newContent))
-            {
-                return osp::protocol::makeErrorResponse("FS_ERROR", "REVISE failed: cannot write new content");
-            }
+        // 写入新内容
+        if (!tx->writeFile(contentPath, newContent))
+        {
+            return osp::protocol::makeErrorResponse("FS_ERROR", "REVISE failed: cannot write new content");
+        }
 
-            // 更新 meta 状态为 Submitted（重新进入提交态）
-            std::ostringstream newMeta;
-            newMeta << p_id << "\n"
-                    << p_authorId << "\n"
-                    << osp::domain::paperStatusToString(osp::domain::PaperStatus::Submitted) << "\n"
-                    << p_title;
-            if (!vfs_.writeFile(metaPath, newMeta.str()))
-            {
-                return osp::protocol::makeErrorResponse("FS_ERROR", "REVISE failed: cannot update meta");
-            }
+        // 更新 meta 状态为 Submitted（重新进入提交态）
+        std::ostringstream newMeta;
+        newMeta << p_id << "\n"
+                << p_authorId << "\n"
+                << osp::domain::paperStatusToString(osp::domain::PaperStatus::Submitted) << "\n"
+                << p_title;
+        if (!tx->writeFile(metaPath, newMeta.str()))
+        {
+            return osp::protocol::makeErrorResponse("FS_ERROR", "REVISE failed: cannot update meta");
+        }
+
+        if (!searchIndex_.updateDocument(p_id, p_title, oldContent ? *oldContent : std::string{}, p_title, newContent)
+            && !searchIndex_.needsRebuild())
+        {
+            OSP_LOG(osp::LogLevel::Error, "REVISE: failed to update index for paper " + pidStr);
+            return osp::protocol::makeErrorResponse("FS_ERROR", "REVISE failed: cannot update search index");
+        }
+
+        if (!tx.commit())
+        {
+            return osp::protocol::makeErrorResponse("FS_ERROR", "REVISE failed: cannot commit revision");
         }
 
+        auto audience = assignedReviewers(pidStr);
+        audience.push_back(p_authorId);
+        events_.publish("PaperRevised",
+                        {{"paperId", p_id}, {"revision", newVersion}, {"authorId", p_authorId}},
+                        std::move(audience));
+
         return osp::protocol::makeSuccessResponse({
             {"message", "Revision submitted successfully"},
             {"paperId", pidStr},
@@ -1406,69 +2738,65 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
         std::string pidStr       = cmd.args[0];
         std::string reviewerName = cmd.args[1];
 
-        std::string paperDir = "/papers/" + pidStr;
-        std::string metaPath = paperDir + "/meta.txt";
-        
-        {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
-            if (!vfs_.readFile(metaPath))
-            {
-                return osp::protocol::makeErrorResponse("NOT_FOUND", "Paper not found: " + pidStr);
-            }
-        }
-
         std::optional<osp::UserId> reviewerIdOpt;
         {
-            std::lock_guard<std::mutex> lock(authMutex_);
+            std::lock_guard<osp::TimedMutex> lock(authMutex_);
             reviewerIdOpt = auth_.getUserId(reviewerName);
         }
-        
+
         if (!reviewerIdOpt)
         {
             return osp::protocol::makeErrorResponse("NOT_FOUND", "User not found: " + reviewerName);
         }
 
-        std::string reviewersPath   = paperDir + "/reviewers.txt";
-        std::string currentReviewers;
-        
+        std::string   paperDir      = "/papers/" + pidStr;
+        std::string   metaPath      = paperDir + "/meta.txt";
+        std::string   reviewersPath = paperDir + "/reviewers.txt";
+        std::string   newEntry      = std::to_string(*reviewerIdOpt);
+        osp::UserId   authorId{};
+        std::uint32_t paperId{};
+
         {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
-            auto existing = vfs_.readFile(reviewersPath);
-            if (existing)
+            // 查重与追加在同一次加锁内完成，并发的 ASSIGN 不会把同一审稿人追加两次
+            std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
+            auto metaData = vfs_.readFile(metaPath);
+            if (!metaData)
             {
-                currentReviewers = *existing;
+                return osp::protocol::makeErrorResponse("NOT_FOUND", "Paper not found: " + pidStr);
             }
-        }
+            authorId = authorIdFromMeta(*metaData);
+            paperId = paperIdFromMeta(*metaData);
 
-        std::string newEntry = std::to_string(*reviewerIdOpt);
+            std::string currentReviewers = vfs_.readFile(reviewersPath).value_or(std::string{});
 
-        std::stringstream rss(currentReviewers);
-        std::string       rid;
-        bool              alreadyAssigned = false;
-        while (rss >> rid)
-        {
-            if (rid == newEntry)
+            std::stringstream rss(currentReviewers);
+            std::string       rid;
+            while (rss >> rid)
             {
-                alreadyAssigned = true;
-                break;
+                if (rid == newEntry)
+                {
+                    return osp::protocol::makeErrorResponse("ALREADY_ASSIGNED", "Reviewer " + reviewerName + " is already assigned to this paper");
+                }
             }
-        }
 
-        if (alreadyAssigned)
-        {
-            return osp::protocol::makeErrorResponse("ALREADY_ASSIGNED", "Reviewer " + reviewerName + " is already assigned to this paper");
-        }
+            // 已有内容未以换行结尾时先补一个分隔符
+            std::string toAppend = newEntry + "\n";
+            if (!currentReviewers.empty() && currentReviewers.back() != '\n')
+            {
+                toAppend.insert(toAppend.begin(), '\n');
+            }
 
-        currentReviewers += newEntry + "\n";
-        
-        {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
-            if (!vfs_.writeFile(reviewersPath, currentReviewers))
+            // 只追加新的一行，不重写整个 reviewers.txt
+            if (!vfs_.appendFile(reviewersPath, toAppend))
             {
                 return osp::protocol::makeErrorResponse("FS_ERROR", "Failed to save assignment");
             }
         }
 
+        events_.publish("ReviewerAssigned",
+                        {{"paperId", paperId}, {"reviewer", reviewerName}, {"reviewerId", *reviewerIdOpt}},
+                        {authorId, *reviewerIdOpt});
+
         return osp::protocol::makeSuccessResponse({
             {"message", "Reviewer assigned"},
             {"paperId", pidStr},
@@ -1519,13 +2847,11 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
 
         std::string paperDir      = "/papers/" + pidStr;
         std::string reviewersPath = paperDir + "/reviewers.txt";
-        
-        std::optional<std::string> reviewersData;
-        {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
-            reviewersData = vfs_.readFile(reviewersPath);
-        }
-        
+
+        // 校验分配关系与写入评审在同一事务中完成
+        osp::fs::Vfs::Transaction tx(vfs_, vfsMutex_);
+        auto                      reviewersData = tx->readFile(reviewersPath);
+
         bool assigned = false;
         if (reviewersData)
         {
@@ -1553,16 +2879,30 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
         std::ostringstream reviewContent;
         reviewContent << decisionStr << "\n" << comments;
 
+        osp::UserId   authorId{};
+        std::uint32_t paperId{};
+        tx->createDirectory(reviewsDir);
+
+        if (!tx->writeFile(reviewPath, reviewContent.str()))
         {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
-            vfs_.createDirectory(reviewsDir);
+            return osp::protocol::makeErrorResponse("FS_ERROR", "Failed to save review");
+        }
 
-            if (!vfs_.writeFile(reviewPath, reviewContent.str()))
-            {
-                return osp::protocol::makeErrorResponse("FS_ERROR", "Failed to save review");
-            }
+        if (auto metaData = tx->readFile(paperDir + "/meta.txt"))
+        {
+            authorId = authorIdFromMeta(*metaData);
+            paperId = paperIdFromMeta(*metaData);
+        }
+
+        if (!tx.commit())
+        {
+            return osp::protocol::makeErrorResponse("FS_ERROR", "Failed to save review");
         }
 
+        events_.publish("ReviewPosted",
+                        {{"paperId", paperId}, {"reviewerId", maybeSession->userId}, {"decision", decisionStr}},
+                        {authorId, maybeSession->userId});
+
         return osp::protocol::makeSuccessResponse({
             {"message", "Review submitted successfully"},
             {"paperId", pidStr},
@@ -1579,13 +2919,11 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
 
         std::string pidStr = cmd.args[0];
 
+        // meta 与全部评审文件在一次加锁内读取（只读事务，无需 commit）
+        osp::fs::Vfs::Transaction tx(vfs_, vfsMutex_);
+
         std::string metaPath = "/papers/" + pidStr + "/meta.txt";
-        std::optional<std::string> metaData;
-        {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
-            metaData = vfs_.readFile(metaPath);
-        }
-        
+        auto        metaData = tx->readFile(metaPath);
         if (!metaData)
         {
             return osp::protocol::makeErrorResponse("NOT_FOUND", "Paper not found");
@@ -1611,33 +2949,23 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
         }
 
         std::string reviewsDir = "/papers/" + pidStr + "/reviews";
-        std::optional<std::string> listing;
-        {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
-            listing = vfs_.listDirectory(reviewsDir);
-        }
-        
+        auto        listing = tx->openDirectory(reviewsDir);
         if (!listing)
         {
             return osp::protocol::makeSuccessResponse({{"reviews", json::array()}});
         }
 
-        std::stringstream ss(*listing);
-        std::string       entry;
-        json              reviews = json::array();
+        osp::fs::Vfs::DirEntryInfo dirEntry;
+        json                       reviews = json::array();
 
-        while (std::getline(ss, entry))
+        while (listing->next(dirEntry))
         {
-            if (entry.empty())
+            if (dirEntry.type != osp::fs::FileType::File)
                 continue;
             
+            const std::string entry(dirEntry.name);
             std::string reviewPath = reviewsDir + "/" + entry;
-            std::optional<std::string> reviewContent;
-            {
-                std::lock_guard<std::mutex> lock(vfsMutex_);
-                reviewContent = vfs_.readFile(reviewPath);
-            }
-            
+            auto        reviewContent = tx->readFile(reviewPath);
             if (!reviewContent)
                 continue;
 
@@ -1688,13 +3016,11 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
             return osp::protocol::makeErrorResponse("INVALID_ARGS", "Invalid decision. Use ACCEPT or REJECT");
         }
 
+        // 读取并改写 meta 在同一事务中完成，避免两次加锁之间被其它请求改写
+        osp::fs::Vfs::Transaction tx(vfs_, vfsMutex_);
+
         std::string metaPath = "/papers/" + pidStr + "/meta.txt";
-        std::optional<std::string> metaData;
-        {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
-            metaData = vfs_.readFile(metaPath);
-        }
-        
+        auto        metaData = tx->readFile(metaPath);
         if (!metaData)
         {
             return osp::protocol::makeErrorResponse("NOT_FOUND", "Paper not found");
@@ -1719,14 +3045,18 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
                 << newStatus << "\n"
                 << p_title;
 
+        if (!tx->writeFile(metaPath, newMeta.str()) || !tx.commit())
         {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
-            if (!vfs_.writeFile(metaPath, newMeta.str()))
-            {
-                return osp::protocol::makeErrorResponse("FS_ERROR", "Failed to update paper status");
-            }
+            return osp::protocol::makeErrorResponse("FS_ERROR", "Failed to update paper status");
         }
 
+        auto audience = assignedReviewers(pidStr);
+        audience.push_back(p_authorId);
+
+        events_.publish("DecisionMade",
+                        {{"paperId", p_id}, {"status", newStatus}, {"authorId", p_authorId}},
+                        std::move(audience));
+
         return osp::protocol::makeSuccessResponse({
             {"message", "Paper decision updated"},
             {"paperId", pidStr},
@@ -1739,7 +3069,7 @@ ServerApp::handlePaperCommand(const osp::protocol::Command&
 
 std::uint32_t ServerApp::nextPaperId()
 {
-    std::lock_guard<std::mutex> lock(vfsMutex_);
+    std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
     
     std::string   path   = "/system/next_paper_id";
     std::uint32_t nextId = 1;
@@ -1764,6 +3094,31 @@ std::uint32_t ServerApp::nextPaperId()
     return nextId;
 }
 
+std::vector<osp::UserId> ServerApp::assignedReviewers(const std::string& pidStr)
+{
+    std::vector<osp::UserId> ids;
+    auto data = vfs_.readFile("/papers/" + pidStr + "/reviewers.txt");
+    if (!data)
+    {
+        return ids;
+    }
+
+    std::stringstream rss(*data);
+    std::string       rid;
+    while (rss >> rid)
+    {
+        try
+        {
+            ids.push_back(static_cast<osp::UserId>(std::stoul(rid)));
+        }
+        catch (...)
+        {
+            // ignore
+        }
+    }
+    return ids;
+}
+
 osp::protocol::Message
 ServerApp::handleFsCommand(const osp::protocol::Command&                        cmd,
                            const std::optional<osp::domain::Session>& /*maybeSession*/)
@@ -1782,7 +3137,7 @@ ServerApp::handleFsCommand(const osp::protocol::Command&
 
         bool ok;
         {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
+            std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
             ok = vfs_.createDirectory(path);
         }
         
@@ -1793,11 +3148,12 @@ ServerApp::handleFsCommand(const osp::protocol::Command&
         return osp::protocol::makeErrorResponse("FS_ERROR", "MKDIR failed: " + path);
     }
 
-    if (cmd.name == "WRITE")
+    // WRITE 覆盖整个文件；APPEND 只在末尾追加（不存在则创建）
+    if (cmd.name == "WRITE" || cmd.name == "APPEND")
     {
         if (cmd.rawArgs.empty())
         {
-            return osp::protocol::makeErrorResponse("MISSING_ARGS", "WRITE: missing path");
+            return osp::protocol::makeErrorResponse("MISSING_ARGS", cmd.name + ": missing path");
         }
 
         std::istringstream iss(cmd.rawArgs);
@@ -1805,7 +3161,7 @@ ServerApp::handleFsCommand(const osp::protocol::Command&
         iss >> path;
         if (path.empty())
         {
-            return osp::protocol::makeErrorResponse("MISSING_ARGS", "WRITE: missing path");
+            return osp::protocol::makeErrorResponse("MISSING_ARGS", cmd.name + ": missing path");
         }
 
         std::string content;
@@ -1817,15 +3173,15 @@ ServerApp::handleFsCommand(const osp::protocol::Command&
 
         bool ok;
         {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
-            ok = vfs_.writeFile(path, content);
+            std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
+            ok = (cmd.name == "APPEND") ? vfs_.appendFile(path, content) : vfs_.writeFile(path, content);
         }
         
         if (ok)
         {
-            return osp::protocol::makeSuccessResponse({{"message", "File written"}, {"path", path}});
+            return osp::protocol::makeSuccessResponse({{"message", cmd.name == "APPEND" ? "File appended" : "File written"}, {"path", path}});
         }
-        return osp::protocol::makeErrorResponse("FS_ERROR", "WRITE failed: " + path);
+        return osp::protocol::makeErrorResponse("FS_ERROR", cmd.name + " failed: " + path);
     }
 
     if (cmd.name == "READ")
@@ -1838,7 +3194,7 @@ ServerApp::handleFsCommand(const osp::protocol::Command&
 
         std::optional<std::string> data;
         {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
+            std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
             data = vfs_.readFile(path);
         }
         
@@ -1849,6 +3205,34 @@ ServerApp::handleFsCommand(const osp::protocol::Command&
         return osp::protocol::makeSuccessResponse({{"path", path}, {"content", *data}});
     }
 
+    if (cmd.name == "STAT")
+    {
+        if (cmd.args.empty())
+        {
+            return osp::protocol::makeErrorResponse("MISSING_ARGS", "STAT: missing path");
+        }
+        const std::string& path = cmd.args[0];
+
+        std::optional<osp::fs::Vfs::FileStat> st;
+        {
+            std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
+            st = vfs_.stat(path);
+        }
+
+        if (!st)
+        {
+            return osp::protocol::makeErrorResponse("NOT_FOUND", "STAT: no such file or directory: " + path);
+        }
+        return osp::protocol::makeSuccessResponse({
+            {"path", path},
+            {"type", st->isDirectory ? "directory" : "file"},
+            {"size", st->size},
+            {"inode", st->inodeId},
+            {"mtime", st->mtime},
+            {"archived", st->archived}
+        });
+    }
+
     if (cmd.name == "RM")
     {
         if (cmd.args.empty())
@@ -1859,7 +3243,7 @@ ServerApp::handleFsCommand(const osp::protocol::Command&
 
         bool ok;
         {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
+            std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
             ok = vfs_.removeFile(path);
         }
         
@@ -1880,7 +3264,7 @@ ServerApp::handleFsCommand(const osp::protocol::Command&
 
         bool ok;
         {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
+            std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
             ok = vfs_.removeDirectory(path);
         }
         
@@ -1899,10 +3283,10 @@ ServerApp::handleFsCommand(const osp::protocol::Command&
             path = cmd.args[0];
         }
 
-        std::optional<std::string> listing;
+        std::optional<osp::fs::Vfs::DirIterator> listing;
         {
-            std::lock_guard<std::mutex> lock(vfsMutex_);
-            listing = vfs_.listDirectory(path);
+            std::lock_guard<osp::TimedMutex> lock(vfsMutex_);
+            listing = vfs_.openDirectory(path);
         }
         
         if (!listing)
@@ -1910,16 +3294,17 @@ ServerApp::handleFsCommand(const osp::protocol::Command&
             return osp::protocol::makeErrorResponse("FS_ERROR", "LIST failed: " + path);
         }
 
-        // 解析目录列表为数组
-        std::stringstream ss(*listing);
-        std::string       entry;
-        json              entries = json::array();
-        while (std::getline(ss, entry))
+        // 目录名后追加 '/'，便于客户端区分文件与目录
+        osp::fs::Vfs::DirEntryInfo entry;
+        json                       entries = json::array();
+        while (listing->next(entry))
         {
-            if (!entry.empty())
+            std::string name(entry.name);
+            if (entry.type == osp::fs::FileType::Directory)
             {
-                entries.push_back(entry);
+                name.push_back('/');
             }
+            entries.push_back(std::move(name));
         }
 
         return osp::protocol::makeSuccessResponse({{"path", path}, {"entries", entries}});
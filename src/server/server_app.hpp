@@ -2,9 +2,15 @@
 
 #include "common/logger.hpp"
 #include "common/protocol.hpp"
+#include "common/timed_mutex.hpp"
 
+#include "filesystem/group_commit.hpp"
 #include "filesystem/vfs.hpp"
+#include "server/events/event_feed.hpp"
+#include "server/metrics/request_metrics.hpp"
+#include "server/metrics/slow_request_log.hpp"
 #include "server/net/tcp_server.hpp"
+#include "server/search/inverted_index.hpp"
 
 #include "domain/auth.hpp"
 
@@ -14,6 +20,8 @@
 #include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace osp::server
 {
@@ -23,8 +31,9 @@ namespace osp::server
 class ServerApp
 {
 public:
+    // cacheBytes：块缓存字节预算（上限为物理内存的一半，运行时可用 CACHE_CONFIG 调整）
     explicit ServerApp(std::uint16_t port,
-                       std::size_t   cacheCapacity = 64,
+                       std::size_t   cacheBytes = 64 * osp::fs::BlockCache::entryCost(4096),
                        std::size_t   threadPoolSize = 4);
 
     void run();    // 启动服务器（阻塞）
@@ -33,9 +42,59 @@ public:
     // 获取配置信息
     [[nodiscard]] std::size_t threadPoolSize() const noexcept { return threadPoolSize_; }
 
+    // 释放数据块时对 backing file 打洞（需在 run() 之前设置）
+    void setPunchHoles(bool enabled) noexcept { vfs_.setPunchHoles(enabled); }
+
+    // 以 O_DIRECT 读写 data.fs，避免块同时缓存在内核页缓存与 BlockCache 中（需在 run() 之前设置）
+    void setDirectIo(bool enabled) noexcept { vfs_.setDirectIo(enabled); }
+
+    // 把 data.fs 的数据块条带化到 members 这些文件上（见 Vfs::setStripe，需在 run() 之前设置）
+    void setStripe(std::vector<std::string> members, std::uint32_t unitBlocks)
+    {
+        vfs_.setStripe(std::move(members), unitBlocks);
+    }
+
+    // 写命令的持久化级别（需在 run() 之前设置，默认 async）：sync / group 模式下写命令在 fdatasync 完成后才应答
+    void setDurability(const osp::fs::DurabilityConfig& config) { groupCommit_.configure(config); }
+
+    // 是否启用后台碎片整理线程（需在 run() 之前设置，默认关闭）
+    void setBackgroundDefrag(bool enabled) noexcept { backgroundDefrag_ = enabled; }
+
+    // 冷数据归档（需在 run() 之前设置）：每 intervalSec 秒把已定稿（Accepted / Rejected）且 minAgeSec 秒内
+    // 没有修改过的论文目录移入归档包 data.fs.pack（见 Vfs::archive）。intervalSec 为 0（默认）时不启动后台线程，
+    // 仍可用 ARCHIVE RUN 手动归档
+    void setTiering(std::uint32_t intervalSec, std::uint32_t minAgeSec) noexcept
+    {
+        tierIntervalSec_ = intervalSec;
+        tierMinAgeSec_ = minAgeSec;
+    }
+
+    // 是否保存 / 预取缓存预热集合 data.fs.warm（需在 run() 之前设置，默认启用）
+    void setWarmCache(bool enabled) noexcept
+    {
+        warmCache_ = enabled;
+        vfs_.setWarmCache(enabled);
+    }
+
+    // 在 [minBytes, maxBytes] 内按命中情况与内存压力自动调节块缓存预算（需在 run() 之前设置）
+    void setCacheAutoTune(std::size_t minBytes, std::size_t maxBytes) { vfs_.setCacheAutoTune(minBytes, maxBytes); }
+
+    // 在 127.0.0.1:port 上提供 Prometheus 文本格式的指标（需在 run() 之前设置，0 表示不开启）
+    void setMetricsPort(std::uint16_t port) noexcept { metricsPort_ = port; }
+
+    // 挂载后立即开始录制块访问追踪到 path（需在 run() 之前设置，空串表示不录制；也可用 BLOCK_TRACE 命令开关）
+    void setBlockTracePath(std::string path) { blockTracePath_ = std::move(path); }
+
+    // 处理时间超过 ms 毫秒的请求记入慢请求日志（SLOW_LOG 命令查看，也可用 SLOW_LOG THRESHOLD 运行时调整）
+    void setSlowRequestThresholdMs(std::uint64_t ms) noexcept { slowLog_.setThresholdUs(ms * 1000); }
+
 private:
     osp::protocol::Message handleRequest(const osp::protocol::Message& req);
 
+    // 校验请求携带的会话后交给 handleCommand；session 返回校验通过的会话（供慢请求日志记录角色）
+    osp::protocol::Message dispatchCommand(const osp::protocol::Command&        cmd,
+                                           std::optional<osp::domain::Session>& session);
+
     // 统一命令路由入口：根据命令名分发到不同子处理函数
     osp::protocol::Message
     handleCommand(const osp::protocol::Command&                        cmd,
@@ -54,6 +113,34 @@ private:
     // 辅助函数：获取并自增下一个 Paper ID
     std::uint32_t nextPaperId();
 
+    // 辅助函数：读取论文已分配的审稿人 ID（调用方需持有 vfsMutex_）
+    std::vector<osp::UserId> assignedReviewers(const std::string& pidStr);
+
+    // WATCH：把携带有效会话的 WATCH 请求所在连接接管为事件推送长连接
+    bool acceptWatchConnection(int fd, const osp::protocol::Message& req);
+
+    // 推送线程：等待 events_ 中的新事件并推送给所有 WATCH 连接
+    void watchLoop();
+
+    // 后台碎片整理线程：限速地逐个目录调用 Vfs::defragmentStep，前台请求持有 vfsMutex_ 时主动让路
+    void defragLoop();
+
+    // 指标导出线程：在 metricsPort_ 上应答 HTTP GET /metrics
+    void metricsHttpLoop();
+
+    // 预热集合保存线程：定期把当前缓存中的热块号写入 data.fs.warm（进程被直接杀掉时也不会丢失太多）
+    void warmSetLoop();
+
+    // 缓存调节线程：每 10 秒调用一次 Vfs::tuneCache（未开启自动调节时为空操作）
+    void cacheTuneLoop();
+
+    // 归档线程：每 tierIntervalSec_ 秒执行一次 runTieringPass，拿不到 vfsMutex_ 时稍后再试
+    void tierLoop();
+
+    // 选出可归档的论文目录并归档；没有可归档的论文时返回 ArchiveResult{}，失败返回 std::nullopt。
+    // 调用方需持有 vfsMutex_
+    std::optional<osp::fs::Vfs::ArchiveResult> runTieringPass();
+
     // 初始化 AuthService 的 VFS 操作接口
     void initAuthVfsOperations();
 
@@ -61,11 +148,46 @@ private:
     std::size_t              threadPoolSize_{};
     std::atomic<bool>        running_{false};
     osp::fs::Vfs             vfs_;
+    osp::fs::GroupCommit     groupCommit_{[this] { return vfs_.syncData(); }}; // 写命令应答前的落盘（见 setDurability）
+    osp::search::InvertedIndex searchIndex_{vfs_}; // 论文全文索引（存放在 vfs_ 中，受 vfsMutex_ 保护）
     osp::domain::AuthService auth_; // 认证与会话管理
 
     // 互斥锁保护共享资源
-    mutable std::mutex vfsMutex_;   // 保护 VFS 访问
-    mutable std::mutex authMutex_;  // 保护 AuthService 访问
+    mutable osp::TimedMutex vfsMutex_{"vfsMutex_"};   // 保护 VFS 访问
+    mutable osp::TimedMutex authMutex_{"authMutex_"}; // 保护 AuthService 访问
+
+    // 变更事件与 WATCH 长连接
+    struct Watcher
+    {
+        int                  fd{-1};
+        osp::domain::Session session;
+        std::uint64_t        lastSeq{0}; // 已推送给该连接的最后一个事件序号
+    };
+    EventFeed            events_;
+    std::mutex           watchersMutex_;
+    std::vector<Watcher> watchers_;
+    std::thread          watchThread_;
+
+    bool        backgroundDefrag_{false}; // 默认关闭，OSP_DEFRAG=1 开启
+    std::thread defragThread_;
+
+    bool        warmCache_{true};
+    std::thread warmSetThread_;
+
+    std::thread cacheTuneThread_;
+
+    std::uint32_t tierIntervalSec_{0}; // 默认关闭后台归档，OSP_TIER_INTERVAL 开启
+    std::uint32_t tierMinAgeSec_{3600};
+    std::thread   tierThread_;
+
+    // 按命令统计的延迟 / 锁等待 / 块 IO（METRICS 命令与 Prometheus 端口）
+    RequestMetrics metrics_;
+    std::uint16_t  metricsPort_{0};
+    std::thread    metricsThread_;
+
+    SlowRequestLog slowLog_;
+
+    std::string blockTracePath_;
 };
 
 } // namespace osp::server